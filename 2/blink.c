@@ -0,0 +1,198 @@
+#include "blink.h"
+#include "hw_pwm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BLINK_CONSUMER "blink"
+#define BLINK_LEDS_DIR "/sys/class/leds"
+
+struct blink {
+    blink_kind_t kind;
+    unsigned half_ms;
+    gint64 started;
+    // gpio
+    struct gpiod_line *line;
+    guint timer;
+    int on;
+    gint64 last_toggle;
+    blink_stats_t stats;
+    // ledtrig
+    char dir[96];
+    // pwm
+    hw_pwm_t *pwm;
+};
+
+static int write_attr(const char *dir, const char *name, const char *value) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    int len = strlen(value);
+    int res = write(fd, value, len) == len ? 0 : -1;
+    int err = errno;
+    close(fd);
+    errno = err;
+    return res;
+}
+
+static blink_t *blink_new(blink_kind_t kind, unsigned half_ms) {
+    if (half_ms == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    blink_t *b = calloc(1, sizeof(*b));
+    if (b) {
+        b->kind = kind;
+        b->half_ms = half_ms;
+    }
+    return b;
+}
+
+blink_t *blink_open_gpio(struct gpiod_chip *chip, unsigned line, unsigned half_ms) {
+    blink_t *b = blink_new(BLINK_GPIO, half_ms);
+    if (!b)
+        return NULL;
+    b->line = gpiod_chip_get_line(chip, line);
+    if (!b->line || gpiod_line_request_output(b->line, BLINK_CONSUMER, 0) < 0) {
+        int err = errno;
+        free(b);
+        errno = err;
+        return NULL;
+    }
+    return b;
+}
+
+blink_t *blink_open_ledtrig(const char *name, unsigned half_ms) {
+    blink_t *b = blink_new(BLINK_LEDTRIG, half_ms);
+    if (!b)
+        return NULL;
+    snprintf(b->dir, sizeof(b->dir), "%s/%s", BLINK_LEDS_DIR, name ? name : BLINK_LED_DEFAULT);
+    if (write_attr(b->dir, "trigger", "none") < 0 || write_attr(b->dir, "brightness", "0") < 0) {
+        int err = errno;
+        free(b);
+        errno = err;
+        return NULL;
+    }
+    return b;
+}
+
+blink_t *blink_open_pwm(unsigned gpio, unsigned half_ms) {
+    blink_t *b = blink_new(BLINK_PWM, half_ms);
+    if (!b)
+        return NULL;
+    // Период 2 * half_ms: у pwm-bcm2835 32-битный счётчик, секунды он держит
+    b->pwm = hw_pwm_open(gpio, 2000000UL * half_ms);
+    if (!b->pwm) {
+        int err = errno;
+        free(b);
+        errno = err;
+        return NULL;
+    }
+    return b;
+}
+
+void blink_close(blink_t *b) {
+    if (!b)
+        return;
+    blink_stop(b);
+    if (b->line)
+        gpiod_line_release(b->line);
+    hw_pwm_close(b->pwm);
+    free(b);
+}
+
+// Таймер главного цикла: переключает линию и замеряет, насколько интервал
+// разошёлся с полупериодом
+static gboolean blink_tick(gpointer user_data) {
+    blink_t *b = user_data;
+    gint64 now = g_get_monotonic_time();
+    gint64 err = now - b->last_toggle - b->half_ms * 1000LL;
+
+    if (err < 0)
+        err = -err;
+    b->on = !b->on;
+    gpiod_line_set_value(b->line, b->on);
+    b->last_toggle = now;
+    b->stats.toggles++;
+    b->stats.intervals++;
+    b->stats.err_us_total += err;
+    if (err > b->stats.err_us_max)
+        b->stats.err_us_max = err;
+    return G_SOURCE_CONTINUE;
+}
+
+int blink_start(blink_t *b) {
+    char ms[16];
+
+    if (b->started)
+        return 0;
+    switch (b->kind) {
+    case BLINK_GPIO:
+        if (gpiod_line_set_value(b->line, 1) < 0)
+            return -1;
+        b->on = 1;
+        b->last_toggle = g_get_monotonic_time();
+        b->stats.toggles++;
+        b->timer = g_timeout_add(b->half_ms, blink_tick, b);
+        break;
+    case BLINK_LEDTRIG:
+        // delay_on/delay_off появляются после выбора триггера; запись
+        // перезапускает мигание с «горит»
+        snprintf(ms, sizeof(ms), "%u", b->half_ms);
+        if (write_attr(b->dir, "trigger", "timer") < 0 || write_attr(b->dir, "delay_on", ms) < 0 ||
+            write_attr(b->dir, "delay_off", ms) < 0)
+            return -1;
+        break;
+    case BLINK_PWM:
+        if (hw_pwm_set_duty(b->pwm, hw_pwm_period(b->pwm) / 2) < 0)
+            return -1;
+        break;
+    }
+    b->started = g_get_monotonic_time();
+    return 0;
+}
+
+int blink_stop(blink_t *b) {
+    int res = 0;
+
+    switch (b->kind) {
+    case BLINK_GPIO:
+        if (b->timer) {
+            g_source_remove(b->timer);
+            b->timer = 0;
+        }
+        b->on = 0;
+        res = gpiod_line_set_value(b->line, 0);
+        break;
+    case BLINK_LEDTRIG:
+        res = write_attr(b->dir, "trigger", "none") < 0 || write_attr(b->dir, "brightness", "0") < 0 ? -1 : 0;
+        break;
+    case BLINK_PWM:
+        res = hw_pwm_set_duty(b->pwm, 0);
+        break;
+    }
+    b->started = 0;
+    return res;
+}
+
+gint64 blink_started(blink_t *b) {
+    return b->started;
+}
+
+blink_kind_t blink_kind(blink_t *b) {
+    return b->kind;
+}
+
+const char *blink_name(blink_t *b) {
+    static const char *names[] = {"gpio", "ledtrig", "pwm"};
+    return names[b->kind];
+}
+
+void blink_get_stats(blink_t *b, blink_stats_t *st) {
+    *st = b->stats;
+}
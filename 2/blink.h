@@ -0,0 +1,54 @@
+#ifndef BLINK_H
+#define BLINK_H
+
+#include <glib.h>
+#include <gpiod.h>
+
+// Мигание светодиода тревоги: полпериода горит, полпериода нет. Способы:
+//   gpio    — таймер главного цикла GLib переключает линию через libgpiod.
+//             Процесс просыпается на каждое переключение, а занятый GUI
+//             сбивает ритм;
+//   ledtrig — светодиод отдан драйверу gpio-leds, например
+//               dtoverlay=gpio-led,gpio=17,label=alarm
+//             в /boot/config.txt, и мигает триггер ядра timer
+//             (delay_on/delay_off в /sys/class/leds/<имя>);
+//   pwm     — аппаратный ШИМ (../6/hw_pwm.c) с периодом в два полупериода
+//             и скважностью 50 %; только GPIO12/13/18/19.
+// У ledtrig и pwm ритм держат ядро и периферия: процесс не просыпается, и
+// нагрузка на главный цикл на мигание не влияет.
+
+#define BLINK_LED_DEFAULT "alarm" // Имя светодиода gpio-leds
+
+typedef enum { BLINK_GPIO, BLINK_LEDTRIG, BLINK_PWM } blink_kind_t;
+
+typedef struct {
+    unsigned long toggles;     // Переключений, сделанных процессом (только gpio)
+    unsigned long intervals;   // Из них с известным предыдущим переключением
+    gint64 err_us_total;       // Отклонение интервала от полупериода, мкс
+    gint64 err_us_max;
+} blink_stats_t;
+
+typedef struct blink blink_t;
+
+// Открывают способ со светодиодом погашенным; NULL — ошибка (errno).
+// gpio: линия line чипа chip (чип закрывает вызывающий);
+// ledtrig: светодиод name (NULL — BLINK_LED_DEFAULT); pwm: номер GPIO.
+blink_t *blink_open_gpio(struct gpiod_chip *chip, unsigned line, unsigned half_ms);
+blink_t *blink_open_ledtrig(const char *name, unsigned half_ms);
+blink_t *blink_open_pwm(unsigned gpio, unsigned half_ms);
+// Гасит светодиод и освобождает линию, файлы или канал
+void blink_close(blink_t *b);
+
+// Начинает мигать с «горит»; 0 — успех, -1 — ошибка (errno)
+int blink_start(blink_t *b);
+// Гасит светодиод
+int blink_stop(blink_t *b);
+// Когда начато мигание, мкс g_get_monotonic_time (0 — не мигает): по нему
+// фазу повторяет надпись в окне
+gint64 blink_started(blink_t *b);
+
+blink_kind_t blink_kind(blink_t *b);
+const char *blink_name(blink_t *b);
+void blink_get_stats(blink_t *b, blink_stats_t *st);
+
+#endif // BLINK_H
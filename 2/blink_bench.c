@@ -0,0 +1,193 @@
+#include <glib.h>
+#include <glib-unix.h>
+#include <gpiod.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "blink.h"
+
+/**
+ * @file blink_bench.c
+ * @brief Сравнение способов мигать светодиодом тревоги: точность и пробуждения.
+ *
+ *   ./blink_bench [секунд [GPIO ШИМ [GPIO петли]]]   (по умолчанию 5 12, без петли)
+ *
+ * Способы (blink.h): gpio — таймер главного цикла на GPIO17, ledtrig —
+ * триггер timer светодиода gpio-leds BLINK_LED_DEFAULT, pwm — аппаратный
+ * ШИМ на заданном GPIO. Каждый мигает с полупериодом 500 мс заданное время
+ * дважды: в простое и с занятым главным циклом (раз в секунду обработчик
+ * занимает его на 300 мс, как тяжёлая перерисовка GUI).
+ *
+ * Печатается:
+ *   wakeups/s — пробуждения процесса (добровольные переключения контекста,
+ *               getrusage), в секунду;
+ *   ctxt/s    — переключения контекста всей системы по /proc/stat;
+ *   toggles   — переключений, сделанных процессом;
+ *   err mean/max — отклонение полупериода от 500 мс, мс.
+ * Отклонение берётся с петли, если светодиодный вывод соединён перемычкой
+ * с GPIO петли: её фронты с метками ядра ловятся событиями, как кнопка в
+ * led_alarm_gui (сама петля добавляет по пробуждению на фронт). Без петли
+ * отклонение известно только способу gpio — по его собственным
+ * переключениям. Недоступный способ пропускается с причиной; ledtrig и
+ * pwm требуют root.
+ */
+
+#define CHIPNAME "gpiochip0"
+#define LED_GPIO 17
+#define HALF_MS 500
+#define BUSY_MS 300
+
+// Фронты петли: отклонение интервала между ними от полупериода
+typedef struct {
+    struct gpiod_line *line;
+    gint64 last_ts;
+    unsigned long intervals;
+    gint64 err_us_total, err_us_max;
+} loop_capture_t;
+
+static gboolean on_loop_event(gint fd, GIOCondition condition, gpointer user_data) {
+    loop_capture_t *c = user_data;
+    struct gpiod_line_event ev[16];
+    int n = gpiod_line_event_read_multiple(c->line, ev, 16);
+
+    for (int i = 0; i < n; i++) {
+        gint64 ts = ev[i].ts.tv_sec * G_USEC_PER_SEC + ev[i].ts.tv_nsec / 1000;
+        if (c->last_ts) {
+            gint64 err = ts - c->last_ts - HALF_MS * 1000LL;
+            if (err < 0)
+                err = -err;
+            c->intervals++;
+            c->err_us_total += err;
+            if (err > c->err_us_max)
+                c->err_us_max = err;
+        }
+        c->last_ts = ts;
+    }
+    return n < 0 ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+// Занятый главный цикл: обработчик держит его BUSY_MS
+static gboolean busy(gpointer user_data) {
+    gint64 end = g_get_monotonic_time() + BUSY_MS * 1000;
+    while (g_get_monotonic_time() < end)
+        ;
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean quit(gpointer user_data) {
+    g_main_loop_quit(user_data);
+    return G_SOURCE_REMOVE;
+}
+
+// Переключения контекста всей системы по /proc/stat
+static unsigned long long system_ctxt(void) {
+    char line[256];
+    unsigned long long v = 0;
+    FILE *f = fopen("/proc/stat", "r");
+
+    if (!f)
+        return 0;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "ctxt %llu", &v) == 1)
+            break;
+    fclose(f);
+    return v;
+}
+
+static void measure(blink_t *b, int busy_load, int seconds, loop_capture_t *cap) {
+    GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+    guint watch = 0, busy_src = 0;
+    struct rusage ru0, ru1;
+
+    if (cap) {
+        // Сбрасываем накопленное с прошлого замера
+        struct gpiod_line_event ev[16];
+        while (gpiod_line_event_wait(cap->line, &(struct timespec){0, 0}) > 0 &&
+               gpiod_line_event_read_multiple(cap->line, ev, 16) > 0)
+            ;
+        cap->last_ts = 0;
+        cap->intervals = 0;
+        cap->err_us_total = cap->err_us_max = 0;
+        watch = g_unix_fd_add(gpiod_line_event_get_fd(cap->line), G_IO_IN, on_loop_event, cap);
+    }
+    if (busy_load)
+        busy_src = g_timeout_add(1000, busy, NULL);
+    g_timeout_add_seconds(seconds, quit, loop);
+
+    unsigned long long c0 = system_ctxt();
+    gint64 t0 = g_get_monotonic_time();
+    getrusage(RUSAGE_SELF, &ru0);
+    blink_start(b);
+    g_main_loop_run(loop);
+    blink_stop(b);
+    getrusage(RUSAGE_SELF, &ru1);
+    double wall = (g_get_monotonic_time() - t0) / 1e6;
+    unsigned long long c1 = system_ctxt();
+    blink_stats_t st;
+    blink_get_stats(b, &st);
+
+    if (watch)
+        g_source_remove(watch);
+    if (busy_src)
+        g_source_remove(busy_src);
+    g_main_loop_unref(loop);
+
+    printf("%-8s %-5s %10.2f %10.0f %8lu ", blink_name(b), busy_load ? "busy" : "idle",
+           (ru1.ru_nvcsw - ru0.ru_nvcsw) / wall, (c1 - c0) / wall, st.toggles);
+    if (cap && cap->intervals)
+        printf("%9.2f %9.2f  loop\n", cap->err_us_total / 1e3 / cap->intervals, cap->err_us_max / 1e3);
+    else if (st.intervals)
+        printf("%9.2f %9.2f  self\n", st.err_us_total / 1e3 / st.intervals, st.err_us_max / 1e3);
+    else
+        printf("%9s %9s  -\n", "-", "-");
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 && atoi(argv[1]) > 0 ? atoi(argv[1]) : 5;
+    unsigned pwm_gpio = argc > 2 ? atoi(argv[2]) : 12;
+    int loop_gpio = argc > 3 ? atoi(argv[3]) : -1;
+    loop_capture_t cap = {0}, *capp = NULL;
+
+    struct gpiod_chip *chip = gpiod_chip_open_lookup(CHIPNAME);
+    if (!chip) {
+        perror("gpiod_chip_open_lookup");
+        return 1;
+    }
+    if (loop_gpio >= 0) {
+        cap.line = gpiod_chip_get_line(chip, loop_gpio);
+        if (!cap.line || gpiod_line_request_both_edges_events(cap.line, "blink_bench") < 0) {
+            perror("loop GPIO");
+            gpiod_chip_close(chip);
+            return 1;
+        }
+        capp = &cap;
+    }
+
+    printf("half period %d ms, %d s per run, busy: %d ms every second; loop %s\n\n", HALF_MS, seconds,
+           BUSY_MS, capp ? "on" : "off");
+    printf("%-8s %-5s %10s %10s %8s %9s %9s  %s\n", "backend", "load", "wakeups/s", "ctxt/s",
+           "toggles", "err mean", "err max", "source");
+
+    for (int kind = BLINK_GPIO; kind <= BLINK_PWM; kind++) {
+        static const char *names[] = {"gpio", "ledtrig", "pwm"};
+        // Для каждого прогона способ открывается заново: счётчики с нуля
+        for (int busy_load = 0; busy_load <= 1; busy_load++) {
+            blink_t *b = kind == BLINK_GPIO      ? blink_open_gpio(chip, LED_GPIO, HALF_MS)
+                         : kind == BLINK_LEDTRIG ? blink_open_ledtrig(NULL, HALF_MS)
+                                                 : blink_open_pwm(pwm_gpio, HALF_MS);
+            if (!b) {
+                printf("%-8s skipped: %s\n", names[kind], strerror(errno));
+                break;
+            }
+            measure(b, busy_load, seconds, capp);
+            blink_close(b);
+        }
+    }
+
+    if (capp)
+        gpiod_line_release(cap.line);
+    gpiod_chip_close(chip);
+    return 0;
+}
@@ -1,165 +1,296 @@
 #include <gtk/gtk.h>       // Основная библиотека GTK для создания графического интерфейса
+#include <glib-unix.h>     // g_unix_fd_add: события кнопки приходят в главный цикл GTK
 #include <gpiod.h>         // Библиотека libgpiod для взаимодействия с GPIO
 #include <stdio.h>         // Стандартная библиотека ввода/вывода (например, для perror)
 #include <stdlib.h>        // Стандартная библиотека для общих утилит
 #include <stdbool.h>       // Для использования булевых типов (true/false)
+#include <string.h>        // Для strcmp (разбор параметров)
+#include <time.h>          // Для clock_gettime: задержка реакции на нажатие
+#include <sys/resource.h>  // Для getrusage: сколько раз процесс просыпался
+#include "blink.h"         // Мигание светодиода: таймер, триггер ядра или аппаратный ШИМ
 
 // Определение констант для удобства
 #define CONSUMER "GUI_for_Zero2W" // Имя потребителя для линий GPIO
 #define CHIPNAME "gpiochip0"      // Имя GPIO-чипа на Raspberry Pi
 #define LED_GPIO 17               // Номер GPIO-пина для светодиода
 #define BUTTON_GPIO 18            // Номер GPIO-пина для кнопки
+#define DEBOUNCE_US 20000         // Нажатие — спад после 20 мс без фронтов; остальное — дребезг
+#define MAX_EVENTS 16             // Сколько событий кнопки читаем за один вызов
+#define BLINK_HALF_MS 500         // Полпериода мигания тревоги, мс
+#define BLINK_PWM_GPIO 12         // Светодиод для --blink pwm: GPIO18 занят кнопкой, берем GPIO12
 
 // Структура для хранения указателей на виджеты и состояния приложения
 // Эта структура будет передаваться между функциями через gpointer user_data
 struct app_widgets {
     GtkWidget *button_toggle_alarm; // Указатель на кнопку GTK для управления тревогой
     GtkWidget *label_alarm;         // Указатель на лейбл GTK для отображения текста "ТРЕВОГА"
-    struct gpiod_line *led_line;    // Указатель на линию GPIO для светодиода
     struct gpiod_line *button_line; // Указатель на линию GPIO для кнопки
+    blink_t *blink;                 // Мигание светодиода (см. blink.h)
     bool alarm_active;              // Флаг: true, если тревога активна; false, если нет
-    bool led_on;                    // Флаг: true, если светодиод включен; false, если выключен (для мигания)
-    guint blink_timer;              // Идентификатор таймера для мигания (0, если таймер не активен)
-    guint poll_timer;               // Идентификатор таймера для опроса кнопки (0, если таймер не активен)
+    bool label_on;                  // Флаг: надпись "ТРЕВОГА" сейчас видна (для мигания)
+    guint flash_tick;               // Tick-callback мигания надписи (0, если не подключен)
+    guint button_watch;             // Источник главного цикла для событий кнопки (0, если не подключен)
+    gint64 last_edge_us;            // Метка ядра последнего фронта кнопки, мкс (0 — фронтов еще не было)
+    unsigned long presses;          // Засчитанных нажатий
+    unsigned long bounces;          // Спадов, отброшенных как дребезг
+    gint64 latency_us_total;        // Задержка реакции: от фронта (метка ядра) до обработчика, мкс
+    gint64 latency_us_max;
+    unsigned long wait_presses;     // --events: сколько нажатий дождаться без окна (0 — режим GUI)
+    GMainLoop *loop;                // --events: главный цикл без GTK
 };
 
-// Функция, вызываемая по таймеру для мигания светодиода и текста тревоги
-gboolean blink_led(gpointer user_data) {
+// Функция flash_label: Вызывается на каждый кадр окна, пока тревога активна.
+// Раньше светодиод и надпись переключал один таймер главного цикла: занятый GUI сбивал ритм
+// светодиода, а процесс просыпался дважды в секунду, даже когда окно не видно. Теперь
+// светодиодом мигает blink, а надпись следует за часами кадров (frame clock): фаза
+// считается от начала мигания, поэтому надпись совпадает со светодиодом. Кадры идут,
+// только пока окно видно, и свернутое окно не будит процесс ради надписи.
+gboolean flash_label(GtkWidget *label, GdkFrameClock *clock, gpointer user_data) {
     struct app_widgets *app = user_data; // Приводим user_data к типу нашей структуры
+    gint64 elapsed = gdk_frame_clock_get_frame_time(clock) - blink_started(app->blink);
+    bool on = elapsed / (BLINK_HALF_MS * 1000) % 2 == 0; // Четный полупериод — горит
 
-    if (app->alarm_active) {
-        // Если тревога активна, переключаем состояние светодиода и текста
-        app->led_on = !app->led_on; // Инвертируем состояние светодиода
-        gpiod_line_set_value(app->led_line, app->led_on); // Устанавливаем значение на GPIO
+    if (on != app->label_on) {
+        app->label_on = on;
+        // Прозрачность вместо смены текста: размер надписи не меняется, раскладка не пересчитывается
+        gtk_widget_set_opacity(label, on ? 1.0 : 0.0);
+    }
+    return G_SOURCE_CONTINUE; // Продолжаем, пока tick-callback не удалят
+}
 
-        // Обновляем текст лейбла: "ТРЕВОГА" или пустая строка для мигания
-        gtk_label_set_text(GTK_LABEL(app->label_alarm),
-                           app->led_on ? "⚠ ТРЕВОГА ⚠" : "");
-        return TRUE; // Возвращаем TRUE, чтобы таймер продолжал работать
+// Функция set_alarm: Включает или отключает тревогу: светодиод, надпись и текст кнопки.
+void set_alarm(struct app_widgets *app, bool active) {
+    app->alarm_active = active;
+    if (active) {
+        blink_start(app->blink); // Ритм дальше держит выбранный способ, а не главный цикл
+        gtk_button_set_label(GTK_BUTTON(app->button_toggle_alarm), "Отключить тревогу");
+        gtk_label_set_text(GTK_LABEL(app->label_alarm), "⚠ ТРЕВОГА ⚠");
+        gtk_widget_set_opacity(app->label_alarm, 1.0);
+        app->label_on = true;
+        if (!app->flash_tick) {
+            app->flash_tick = gtk_widget_add_tick_callback(app->label_alarm, flash_label, app, NULL);
+        }
     } else {
-        // Если тревога неактивна, выключаем светодиод и очищаем текст
-        gpiod_line_set_value(app->led_line, 0); // Выключаем светодиод
+        blink_stop(app->blink); // Выключаем светодиод
+        gtk_button_set_label(GTK_BUTTON(app->button_toggle_alarm), "Включить тревогу");
+        if (app->flash_tick) {
+            gtk_widget_remove_tick_callback(app->label_alarm, app->flash_tick);
+            app->flash_tick = 0;
+        }
         gtk_label_set_text(GTK_LABEL(app->label_alarm), ""); // Очищаем текст лейбла
-        return FALSE; // Возвращаем FALSE, чтобы остановить таймер мигания
     }
 }
 
-// Функция, вызываемая по таймеру для опроса состояния физической кнопки
-gboolean poll_button(gpointer user_data) {
+// Функция, вызываемая при нажатии физической кнопки (после подавления дребезга)
+void on_button_pressed(struct app_widgets *app) {
+    // Если тревога еще не активна, активируем ее
+    if (!app->alarm_active) {
+        set_alarm(app, true);
+    }
+}
+
+// Функция, вызываемая главным циклом, когда у линии кнопки есть события.
+// Раньше кнопку опрашивали таймером раз в 100 мс: процесс просыпался 10 раз в секунду,
+// короткие нажатия терялись, а реакция запаздывала до 100 мс. Теперь ядро само ловит
+// фронты по прерыванию и ставит их в очередь с метками времени; пока кнопку не трогают,
+// процесс спит, а нажатие короче любого периода опроса все равно не потеряется.
+gboolean on_button_event(gint fd, GIOCondition condition, gpointer user_data) {
     struct app_widgets *app = user_data; // Приводим user_data к типу нашей структуры
-    int val = gpiod_line_get_value(app->button_line); // Считываем значение с линии кнопки
-
-    if (val == 0) { // Если кнопка нажата (пин подключен к GND, считываем LOW)
-        // Если тревога еще не активна, активируем ее
-        if (!app->alarm_active) {
-            app->alarm_active = true; // Устанавливаем флаг тревоги в true
-            // Если таймер мигания не запущен, запускаем его
-            if (!app->blink_timer) {
-                app->blink_timer = g_timeout_add(500, blink_led, app); // Запускаем таймер с интервалом 500 мс
-            }
-            // Обновляем текст на кнопке GUI
-            gtk_button_set_label(GTK_BUTTON(app->button_toggle_alarm), "Отключить тревогу");
+    struct gpiod_line_event events[MAX_EVENTS];
+    struct timespec now;
+
+    // Забираем все накопившиеся события одним чтением
+    int n = gpiod_line_event_read_multiple(app->button_line, events, MAX_EVENTS);
+    if (n < 0) {
+        perror("Ошибка чтения событий кнопки");
+        app->button_watch = 0;
+        return G_SOURCE_REMOVE; // Источник удаляется, больше не вызываемся
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now); // Ядро ставит метки по CLOCK_MONOTONIC (Linux 5.7+)
+    gint64 now_us = now.tv_sec * G_USEC_PER_SEC + now.tv_nsec / 1000;
+
+    for (int i = 0; i < n; i++) {
+        gint64 ts = events[i].ts.tv_sec * G_USEC_PER_SEC + events[i].ts.tv_nsec / 1000;
+        // Дребезг: контакты несколько раз замыкаются и размыкаются за миллисекунды.
+        // Нажатие засчитываем, только если перед спадом линия DEBOUNCE_US была спокойна,
+        // поэтому и дребезг при нажатии, и спады при отпускании отбрасываются.
+        bool quiet = !app->last_edge_us || ts - app->last_edge_us >= DEBOUNCE_US;
+        app->last_edge_us = ts;
+        if (events[i].event_type != GPIOD_LINE_EVENT_FALLING_EDGE) continue; // Отпускание
+        if (!quiet) {
+            app->bounces++;
+            continue;
+        }
+
+        gint64 latency = now_us - ts; // От фронта на выводе до обработчика
+        app->presses++;
+        app->latency_us_total += latency;
+        if (latency > app->latency_us_max) app->latency_us_max = latency;
+
+        if (app->wait_presses) {
+            // Режим --events: печатаем нажатие, окна нет
+            printf("нажатие %lu: реакция %" G_GINT64_FORMAT " мкс\n", app->presses, latency);
+            if (app->presses >= app->wait_presses) g_main_loop_quit(app->loop);
+        } else {
+            on_button_pressed(app);
         }
     }
-    return TRUE; // Возвращаем TRUE, чтобы таймер опроса продолжал работать
+    return G_SOURCE_CONTINUE; // Продолжаем ждать события
+}
+
+// Функция print_button_stats: Печатает итог по кнопке при выходе.
+// wakeups — добровольные переключения контекста за время работы: столько раз процесс засыпал
+// и просыпался. Пока кнопку не нажимают, их не прибавляется.
+void print_button_stats(struct app_widgets *app, long wakeups, double seconds) {
+    printf("Кнопка: нажатий %lu, отброшено дребезга %lu", app->presses, app->bounces);
+    if (app->presses) {
+        printf(", реакция %.0f мкс в среднем, %" G_GINT64_FORMAT " мкс максимум",
+               (double)app->latency_us_total / app->presses, app->latency_us_max);
+    }
+    printf("\nПробуждений процесса: %ld за %.1f с\n", wakeups, seconds);
+    blink_stats_t st;
+    blink_get_stats(app->blink, &st);
+    printf("Мигание: %s, переключений процессом %lu\n", blink_name(app->blink), st.toggles);
 }
 
 // Функция, вызываемая при нажатии кнопки "Включить/Отключить тревогу" в GUI
 void on_toggle_alarm(GtkButton *button, gpointer user_data) {
     struct app_widgets *app = user_data; // Приводим user_data к типу нашей структуры
-    app->alarm_active = !app->alarm_active; // Инвертируем состояние тревоги
-
-    if (app->alarm_active) {
-        // Если тревога активирована через GUI
-        gtk_button_set_label(button, "Отключить тревогу"); // Меняем текст кнопки
-        if (!app->blink_timer) {
-            // Если таймер мигания не запущен, запускаем его
-            app->blink_timer = g_timeout_add(500, blink_led, app);
-        }
-    } else {
-        // Если тревога деактивирована через GUI
-        gtk_button_set_label(button, "Включить тревогу"); // Меняем текст кнопки
-        if (app->blink_timer) {
-            // Если таймер мигания запущен, останавливаем его
-            g_source_remove(app->blink_timer);
-            app->blink_timer = 0; // Сбрасываем идентификатор таймера
-        }
-        gpiod_line_set_value(app->led_line, 0); // Выключаем светодиод
-        gtk_label_set_text(GTK_LABEL(app->label_alarm), ""); // Очищаем текст лейбла
-    }
+    set_alarm(app, !app->alarm_active);  // Инвертируем состояние тревоги
 }
 
 // Главная функция приложения
 int main(int argc, char *argv[]) {
-    gtk_init(&argc, &argv); // Инициализация библиотеки GTK
+    // Параметр --chip NAME: GPIO-чип по имени, пути или метке (по умолчанию CHIPNAME);
+    // например, "gpio-sim" — чип модуля ядра gpio-sim для проверки без кнопки.
+    // Параметр --events [N]: без окна дождаться N нажатий (по умолчанию 10), печатая
+    // задержку реакции каждого, затем итог и число пробуждений процесса.
+    // Параметр --blink gpio|led[=ИМЯ]|pwm[=GPIO]: чем мигать светодиодом (см. blink.h).
+    // По умолчанию — триггером ядра, если есть светодиод gpio-leds BLINK_LED_DEFAULT,
+    // иначе таймером на LED_GPIO, как раньше.
+    const char *chipname = CHIPNAME;
+    const char *blink_mode = NULL;
+    unsigned long wait_presses = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL; // Значение параметра, если есть
+        if (strcmp(argv[i], "--chip") == 0 && next) {
+            chipname = argv[++i];
+        } else if (strcmp(argv[i], "--blink") == 0 && next) {
+            blink_mode = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0) {
+            wait_presses = next && atol(next) > 0 ? strtoul(argv[++i], NULL, 10) : 10;
+        }
+    }
+    if (!wait_presses) {
+        gtk_init(&argc, &argv); // Инициализация библиотеки GTK (режиму --events окно не нужно)
+    }
 
     // Инициализация GPIO
-    struct gpiod_chip *chip = gpiod_chip_open_by_name(CHIPNAME); // Открываем GPIO-чип
+    struct gpiod_chip *chip = gpiod_chip_open_lookup(chipname); // Открываем GPIO-чип
     if (!chip) {
         perror("Ошибка открытия GPIO-чипа");
         return 1;
     }
 
-    // Получаем линии GPIO для светодиода и кнопки
-    struct gpiod_line *led_line = gpiod_chip_get_line(chip, LED_GPIO);
+    // Получаем линию GPIO для кнопки
     struct gpiod_line *button_line = gpiod_chip_get_line(chip, BUTTON_GPIO);
-    if (!led_line || !button_line) {
+    if (!button_line) {
         perror("Ошибка получения линий GPIO");
         gpiod_chip_close(chip);
         return 1;
     }
 
-    // Запрашиваем линии GPIO: светодиод как выход, кнопка как вход
-    if (gpiod_line_request_output(led_line, CONSUMER, 0) < 0 || // LED как выход, начальное значение 0
-        gpiod_line_request_input(button_line, CONSUMER) < 0) {   // BUTTON как вход
+    // Запрашиваем линию кнопки как вход с событиями по обоим фронтам
+    // (спад — нажатие, подъем — отпускание; оба нужны для подавления дребезга)
+    if (gpiod_line_request_both_edges_events(button_line, CONSUMER) < 0) { // BUTTON: события фронтов
         perror("Ошибка запроса линий GPIO");
         gpiod_chip_close(chip);
         return 1;
     }
 
+    // Светодиод: линию LED_GPIO запрашивает blink только для способа gpio; у gpio-leds
+    // и ШИМ вывод принадлежит ядру
+    blink_t *blink;
+    if (!blink_mode) {
+        blink = blink_open_ledtrig(NULL, BLINK_HALF_MS); // Есть светодиод gpio-leds — мигает ядро
+        if (!blink) {
+            blink = blink_open_gpio(chip, LED_GPIO, BLINK_HALF_MS); // Иначе — таймер главного цикла
+        }
+    } else if (strncmp(blink_mode, "led", 3) == 0) {
+        blink = blink_open_ledtrig(blink_mode[3] == '=' ? blink_mode + 4 : NULL, BLINK_HALF_MS);
+    } else if (strncmp(blink_mode, "pwm", 3) == 0) {
+        blink = blink_open_pwm(blink_mode[3] == '=' ? atoi(blink_mode + 4) : BLINK_PWM_GPIO, BLINK_HALF_MS);
+    } else {
+        blink = blink_open_gpio(chip, LED_GPIO, BLINK_HALF_MS);
+    }
+    if (!blink) {
+        perror("Ошибка: не удалось открыть мигание светодиода");
+        gpiod_line_release(button_line);
+        gpiod_chip_close(chip);
+        return 1;
+    }
+
     // Инициализация структуры app_widgets
     struct app_widgets app = {
-        .led_line = led_line,       // Присваиваем указатель на линию светодиода
         .button_line = button_line, // Присваиваем указатель на линию кнопки
+        .blink = blink,             // Светодиод погашен, пока тревога неактивна
         .alarm_active = false,      // Тревога изначально неактивна
-        .led_on = false,            // Светодиод изначально выключен
-        .blink_timer = 0            // Таймер мигания неактивен
+        .wait_presses = wait_presses
     };
 
-    // Создание и настройка GTK UI
-    GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL); // Создаем главное окно
-    gtk_window_set_title(GTK_WINDOW(window), "Тревожный сигнал"); // Устанавливаем заголовок окна
-    gtk_window_set_default_size(GTK_WINDOW(window), 250, 150); // Устанавливаем размер окна
-    // Подключаем сигнал закрытия окна к функции выхода из GTK
-    g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
+    struct rusage ru0, ru1; // Для подсчета пробуждений процесса
+    gint64 start = g_get_monotonic_time();
+    getrusage(RUSAGE_SELF, &ru0);
 
-    // Создаем вертикальный контейнер для размещения виджетов
-    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10); // Отступ 10 пикселей
-    gtk_container_add(GTK_CONTAINER(window), vbox); // Добавляем контейнер в окно
+    // Файл событий линии кнопки добавляем в главный цикл: обработчик вызывается, только
+    // когда ядро поставило в очередь фронт, а без нажатий процесс не просыпается вовсе.
+    app.button_watch = g_unix_fd_add(gpiod_line_event_get_fd(button_line), G_IO_IN,
+                                     on_button_event, &app);
 
-    // Создаем лейбл для отображения текста тревоги
-    app.label_alarm = gtk_label_new("");
-    // Добавляем лейбл в контейнер, расширяя его по вертикали и горизонтали
-    gtk_box_pack_start(GTK_BOX(vbox), app.label_alarm, TRUE, TRUE, 10);
+    if (wait_presses) {
+        // Режим --events: только главный цикл GLib, без окна
+        printf("Ждем %lu нажатий кнопки (GPIO%d на %s)...\n", wait_presses, BUTTON_GPIO, chipname);
+        app.loop = g_main_loop_new(NULL, FALSE);
+        g_main_loop_run(app.loop);
+        g_main_loop_unref(app.loop);
+    } else {
+        // Создание и настройка GTK UI
+        GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL); // Создаем главное окно
+        gtk_window_set_title(GTK_WINDOW(window), "Тревожный сигнал"); // Устанавливаем заголовок окна
+        gtk_window_set_default_size(GTK_WINDOW(window), 250, 150); // Устанавливаем размер окна
+        // Подключаем сигнал закрытия окна к функции выхода из GTK
+        g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
 
-    // Создаем кнопку для управления тревогой
-    app.button_toggle_alarm = gtk_button_new_with_label("Включить тревогу");
-    // Добавляем кнопку в контейнер
-    gtk_box_pack_start(GTK_BOX(vbox), app.button_toggle_alarm, TRUE, TRUE, 10);
-    // Подключаем сигнал нажатия кнопки к нашей функции on_toggle_alarm
-    g_signal_connect(app.button_toggle_alarm, "clicked",
-                     G_CALLBACK(on_toggle_alarm), &app);
+        // Создаем вертикальный контейнер для размещения виджетов
+        GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10); // Отступ 10 пикселей
+        gtk_container_add(GTK_CONTAINER(window), vbox); // Добавляем контейнер в окно
 
-    gtk_widget_show_all(window); // Показываем все виджеты в окне
+        // Создаем лейбл для отображения текста тревоги
+        app.label_alarm = gtk_label_new("");
+        // Добавляем лейбл в контейнер, расширяя его по вертикали и горизонтали
+        gtk_box_pack_start(GTK_BOX(vbox), app.label_alarm, TRUE, TRUE, 10);
 
-    // Запускаем таймер для периодического опроса физической кнопки
-    app.poll_timer = g_timeout_add(100, poll_button, &app); // Опрос каждые 100 мс
+        // Создаем кнопку для управления тревогой
+        app.button_toggle_alarm = gtk_button_new_with_label("Включить тревогу");
+        // Добавляем кнопку в контейнер
+        gtk_box_pack_start(GTK_BOX(vbox), app.button_toggle_alarm, TRUE, TRUE, 10);
+        // Подключаем сигнал нажатия кнопки к нашей функции on_toggle_alarm
+        g_signal_connect(app.button_toggle_alarm, "clicked",
+                         G_CALLBACK(on_toggle_alarm), &app);
 
-    gtk_main(); // Запускаем основной цикл обработки событий GTK
+        gtk_widget_show_all(window); // Показываем все виджеты в окне
+
+        gtk_main(); // Запускаем основной цикл обработки событий GTK
+    }
+
+    getrusage(RUSAGE_SELF, &ru1);
+    print_button_stats(&app, ru1.ru_nvcsw - ru0.ru_nvcsw, (g_get_monotonic_time() - start) / 1e6);
 
     // --- Очистка ресурсов перед завершением программы ---
-    gpiod_line_set_value(led_line, 0); // Убедимся, что светодиод выключен
-    gpiod_line_release(led_line);      // Освобождаем линию светодиода
+    if (app.button_watch) {
+        g_source_remove(app.button_watch); // Отключаем события кнопки от главного цикла
+    }
+    blink_close(blink);                // Гасим светодиод и освобождаем его линию или канал
     gpiod_line_release(button_line);   // Освобождаем линию кнопки
     gpiod_chip_close(chip);            // Закрываем GPIO-чип
 
@@ -3,58 +3,75 @@
     #include <stdlib.h>        // Подключаем стандартную библиотеку для функций, таких как rand() и atoi()
     #include <time.h>          // Подключаем библиотеку для работы со временем, используемой для инициализации rand()
     #include <stdio.h>         // Подключаем для snprintf и perror
+    #include <string.h>        // Подключаем для strcmp (разбор параметров --bench и --gui-bench)
+    #include <sys/resource.h>  // Подключаем для getrusage (процессор в --gui-bench)
+    #include "led_bar.h"       // Линейка светодиодов, нарисованная cairo
+    #include "sr595.h"         // Вывод числа на сдвиговые регистры 74HC595 по SPI
 
     // Определение констант для количества светодиодов, имени GPIO-чипа и потребителя
-    #define NUM_LEDS 8
+    #define NUM_LEDS 8         // Светодиодов на выводах GPIO; через 74HC595 — до 64 (--bits)
+    #define SR595_LATCH 5      // GPIO защёлки (RCLK) 74HC595 по умолчанию (не из gpio_pins)
     #define CHIPNAME "gpiochip0"
     #define CONSUMER "BinaryGame"
 
     // Массив номеров GPIO-пинов, к которым подключены светодиоды
     // Порядок пинов соответствует порядку битов от LSB (индекс 0) до MSB (индекс 7)
-    int gpio_pins[NUM_LEDS] = {4, 25, 24, 23, 22, 27, 18, 17};
+    unsigned int gpio_pins[NUM_LEDS] = {4, 25, 24, 23, 22, 27, 18, 17};
 
     // Глобальные переменные для хранения состояния приложения и указателей на виджеты/GPIO
     // Использование глобальных переменных упрощает передачу данных между функциями в данном примере.
-    int current_value = 0;              // Текущее загаданное десятичное число
+    unsigned num_bits = NUM_LEDS;       // Разрядность числа: 8, 16, 32 или 64 (--bits)
+    guint64 value_mask = 0xff;          // Маска num_bits младших битов
+    guint64 current_value = 0;          // Текущее загаданное десятичное число
     int correct = 0;                    // Счетчик правильных ответов
     int incorrect = 0;                  // Счетчик ошибок
     struct gpiod_chip *chip;            // Указатель на GPIO-чип
-    struct gpiod_line *lines[NUM_LEDS]; // Массив указателей на линии GPIO для светодиодов
-    GtkWidget *circles[NUM_LEDS];       // Массив указателей на виджеты-контейнеры для GUI-индикаторов
+    struct gpiod_line_bulk leds;        // Все линии светодиодов одним запросом: запись байта — один ioctl
+    gboolean gpio_ready = FALSE;        // Линии запрошены (в --gui-bench GPIO не используется)
+    sr595_t *sr = NULL;                 // Цепочка 74HC595 (--sr595) вместо выводов GPIO
+    GtkWidget *led_bar;                 // Виджет-линейка GUI-индикаторов светодиодов
     GtkWidget *entry;                   // Указатель на виджет поля ввода (GtkEntry)
     GtkWidget *correct_label;           // Указатель на лейбл для отображения количества правильных ответов (GtkLabel)
     GtkWidget *incorrect_label;         // Указатель на лейбл для отображения количества ошибок (GtkLabel)
     gboolean game_running = FALSE;      // Флаг состояния игры (TRUE - игра активна, FALSE - нет)
 
 
-    // Функция update_led_circle: Обновляет цвет GUI-индикатора светодиода.
-    // i: индекс светодиода (от 0 до 7)
-    // state: 0 для выключенного (белый), 1 для включенного (красный)
-    void update_led_circle(int i, int state) {
-        GdkRGBA color;
-        // gdk_rgba_parse преобразует строковое название цвета в структуру GdkRGBA
-        // Если state равен 1, цвет будет "red", иначе "white".
-        gdk_rgba_parse(&color, state ? "red" : "white");
-        // Устанавливаем фоновый цвет для виджета (GtkEventBox), который имитирует светодиод.
-        gtk_widget_override_background_color(circles[i], GTK_STATE_FLAG_NORMAL, &color);
+    // Функция write_leds: Записывает число на все физические светодиоды одним вызовом.
+    // Линии запрошены одним gpiod_line_bulk, поэтому gpiod_line_set_value_bulk выставляет
+    // все 8 выводов одним ioctl: светодиоды меняются одновременно, без смеси старого и нового числа.
+    // С --sr595 число уходит в сдвиговые регистры одной передачей SPI и защёлкивается разом.
+    // Возвращает 0 при успехе, -1 при ошибке.
+    int write_leds(guint64 value) {
+        int values[NUM_LEDS];
+        if (sr) return sr595_write(sr, value);
+        if (!gpio_ready) return 0; // Без GPIO (--gui-bench) пишем только в GUI.
+        for (int i = 0; i < NUM_LEDS; i++) {
+            // Извлекаем i-й бит из числа 'value'.
+            // Оператор >> (побитовый сдвиг вправо) сдвигает биты числа на 'i' позиций вправо.
+            // Оператор & 1 (побитовое И с 1) извлекает самый младший бит (то есть, текущий i-й бит).
+            values[i] = (value >> i) & 1;
+        }
+        return gpiod_line_set_value_bulk(&leds, values);
     }
 
     // Функция set_leds: Устанавливает состояние физических светодиодов и их GUI-индикаторов
     // в соответствии с двоичным представлением заданного числа.
     // value: десятичное число, которое нужно отобразить.
-    void set_leds(int value) {
-        current_value = value; // Сохраняем текущее загаданное число.
-        for (int i = 0; i < NUM_LEDS; i++) {
-            // Извлекаем i-й бит из числа 'value'.
-            // Оператор >> (побитовый сдвиг вправо) сдвигает биты числа на 'i' позиций вправо.
-            // Оператор & 1 (побитовое И с 1) извлекает самый младший бит (то есть, текущий i-й бит).
-            int bit = (value >> i) & 1;
-            // Устанавливаем значение на соответствующей физической GPIO-линии.
-            // 0 - выключить светодиод, 1 - включить светодиод.
-            gpiod_line_set_value(lines[i], bit);
-            // Обновляем цвет GUI-индикатора.
-            update_led_circle(i, bit);
+    void set_leds(guint64 value) {
+        current_value = value & value_mask; // Сохраняем текущее загаданное число.
+        write_leds(value);     // Все физические светодиоды — одним вызовом.
+        // GUI-индикаторы: линейка запоминает маску и перерисовывается, только если она изменилась.
+        led_bar_set_mask(led_bar, value);
+    }
+
+    // Функция random_value: Случайное число из num_bits битов.
+    // rand() дает не меньше 15 случайных битов, поэтому 64 бита собираем из пяти вызовов.
+    guint64 random_value() {
+        guint64 value = 0;
+        for (int i = 0; i < 5; i++) {
+            value = (value << 15) ^ rand();
         }
+        return value & value_mask;
     }
 
     // Функция reset_all_leds: Выключает все физические светодиоды и их GUI-индикаторы.
@@ -65,9 +82,8 @@
     // Обработчик кнопки "Старт": Начинает новую игру.
     // Параметр gpointer user_data удален, так как функция использует глобальные переменные.
     void start_game(GtkButton *btn) {
-        // Генерируем случайное число от 0 до 255 (для 8 бит).
-        // rand() % 256 дает остаток от деления на 256, что гарантирует число в диапазоне [0, 255].
-        int value = rand() % 256;
+        // Генерируем случайное число от 0 до 2^num_bits - 1 (для 8 бит — от 0 до 255).
+        guint64 value = random_value();
         set_leds(value); // Обновляем светодиоды в соответствии с новым загаданным числом.
         game_running = TRUE; // Устанавливаем флаг, что игра запущена.
         gtk_entry_set_text(GTK_ENTRY(entry), ""); // Очищаем текстовое поле ввода.
@@ -81,8 +97,8 @@
 
         // Получаем текст из поля ввода.
         const gchar *input_text = gtk_entry_get_text(GTK_ENTRY(entry));
-        // Преобразуем введенную строку в целое число.
-        int user_val = atoi(input_text);
+        // Преобразуем введенную строку в целое число (до 64 бит, поэтому не atoi).
+        guint64 user_val = g_ascii_strtoull(input_text, NULL, 10);
 
         // Сравниваем ответ пользователя с текущим загаданным числом.
         if (user_val == current_value) {
@@ -100,7 +116,7 @@
         gtk_label_set_text(GTK_LABEL(incorrect_label), buf);
 
         // Генерируем новое случайное число для следующего раунда игры.
-        int new_value = rand() % 256;
+        guint64 new_value = random_value();
         set_leds(new_value); // Обновляем светодиоды для нового числа.
         gtk_entry_set_text(GTK_ENTRY(entry), ""); // Очищаем поле ввода для нового ответа.
     }
@@ -122,13 +138,17 @@
     // Обработчик сигнала "destroy" окна: Освобождает все захваченные ресурсы и завершает приложение.
     // Параметр gpointer data удален, так как функция использует глобальные переменные.
     void on_destroy(GtkWidget *widget) {
-        reset_all_leds(); // Убедимся, что все светодиоды выключены перед выходом.
+        // Цепочка 74HC595 при закрытии сама гасит выходы и освобождает SPI и защёлку.
+        sr595_close(sr);
+        sr = NULL;
 
-        // Освобождаем каждую GPIO-линию, которая была запрошена.
-        for (int i = 0; i < NUM_LEDS; i++) {
-            if (lines[i]) { // Проверяем, что указатель на линию не NULL (т.е. линия была успешно получена)
-                gpiod_line_release(lines[i]);
-            }
+        if (gpio_ready) {
+            // Гасим все светодиоды тем же одним bulk-вызовом. Индикаторы GUI уже уничтожаются
+            // вместе с окном, поэтому трогаем только физические линии.
+            write_leds(0);
+
+            // Освобождаем все GPIO-линии одним вызовом.
+            gpiod_line_release_bulk(&leds);
         }
 
         // Закрываем GPIO-чип.
@@ -138,35 +158,193 @@
         gtk_main_quit(); // Завершаем основной цикл обработки событий GTK, что приводит к завершению приложения.
     }
 
+    // Функция run_bench: Сравнивает запись числа по одной линии (8 вызовов
+    // gpiod_line_set_value, 8 ioctl) и одним gpiod_line_set_value_bulk (1 ioctl).
+    // Линии одного bulk-запроса делят один дескриптор, и set_value на любой из них
+    // пишет все 8, поэтому для построчного способа линии на время замера
+    // запрашиваются каждая отдельно (8 запросов, 8 дескрипторов). n: сколько чисел
+    // записать каждым способом. Светодиоды при этом мигают. Возвращает 0 или -1 (errno).
+    int run_bench(long n) {
+        struct timespec t0, t1;
+        double per_line, bulk;
+        int zeros[NUM_LEDS] = {0};
+        int i;
+
+        gpiod_line_release_bulk(&leds);
+        for (i = 0; i < NUM_LEDS; i++) {
+            if (gpiod_line_request_output(gpiod_line_bulk_get_line(&leds, i), CONSUMER, 0) < 0)
+                break;
+        }
+        if (i < NUM_LEDS) {
+            while (i-- > 0)
+                gpiod_line_release(gpiod_line_bulk_get_line(&leds, i));
+            return -1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long k = 0; k < n; k++) {
+            for (i = 0; i < NUM_LEDS; i++) {
+                gpiod_line_set_value(gpiod_line_bulk_get_line(&leds, i), (k >> i) & 1);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        per_line = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+        // Обратно одним bulk-запросом
+        for (i = 0; i < NUM_LEDS; i++)
+            gpiod_line_release(gpiod_line_bulk_get_line(&leds, i));
+        if (gpiod_line_request_bulk_output(&leds, CONSUMER, zeros) < 0)
+            return -1;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long k = 0; k < n; k++) {
+            write_leds(k & 0xff);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        bulk = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+        write_leds(0);
+        printf("%ld updates of %d LEDs\n", n, NUM_LEDS);
+        printf("%-9s %14s %12s %14s\n", "path", "updates/s", "us/update", "ioctl/update");
+        printf("%-9s %14.0f %12.2f %14d\n", "per-line", n / per_line, per_line * 1e6 / n, NUM_LEDS);
+        printf("%-9s %14.0f %12.2f %14d\n", "bulk", n / bulk, bulk * 1e6 / n, 1);
+        return 0;
+    }
+
+    // Состояние замера --gui-bench: обновления по таймеру 1 мс и интервалы кадров экрана.
+    struct {
+        gint64 start, end;        // Начало и конец замера, мкс
+        struct rusage ru0;        // Процессор в начале
+        gint64 last_frame;        // Время предыдущего кадра
+        unsigned long frames;     // Кадров экрана
+        gint64 frame_us_total, frame_us_max;
+        guint64 value;
+    } gui_bench;
+
+    // Функция gui_bench_update: Таймер 1 мс (1 кГц) — новое число на светодиодах.
+    gboolean gui_bench_update(gpointer data) {
+        set_leds(++gui_bench.value);
+        if (g_get_monotonic_time() < gui_bench.end) return G_SOURCE_CONTINUE;
+
+        struct rusage ru;
+        led_bar_stats_t st;
+        getrusage(RUSAGE_SELF, &ru);
+        led_bar_get_stats(led_bar, &st);
+        double wall = (g_get_monotonic_time() - gui_bench.start) / 1e6;
+        double cpu = (ru.ru_utime.tv_sec - gui_bench.ru0.ru_utime.tv_sec) + (ru.ru_stime.tv_sec - gui_bench.ru0.ru_stime.tv_sec) +
+                     ((ru.ru_utime.tv_usec - gui_bench.ru0.ru_utime.tv_usec) + (ru.ru_stime.tv_usec - gui_bench.ru0.ru_stime.tv_usec)) / 1e6;
+
+        printf("%.1f s, %u LEDs\n", wall, led_bar_get_count(led_bar));
+        printf("updates: %lu (%.0f/s), mask changes %lu\n", st.updates, st.updates / wall, st.changes);
+        printf("draws:   %lu (%.1f/s), draw %.1f us mean, %" G_GINT64_FORMAT " us max\n", st.draws, st.draws / wall,
+               st.draws ? (double)st.draw_us_total / st.draws : 0.0, st.draw_us_max);
+        printf("frames:  %lu, interval %.2f ms mean, %.2f ms max\n", gui_bench.frames,
+               gui_bench.frames ? gui_bench.frame_us_total / 1e3 / gui_bench.frames : 0.0, gui_bench.frame_us_max / 1e3);
+        printf("cpu:     %.1f%% of one core\n", cpu * 100 / wall);
+        gtk_main_quit();
+        return G_SOURCE_REMOVE;
+    }
+
+    // Функция gui_bench_frame: Вызывается на каждый кадр экрана; запоминает интервал между кадрами.
+    gboolean gui_bench_frame(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+        gint64 now = gdk_frame_clock_get_frame_time(clock);
+        if (gui_bench.last_frame) {
+            gint64 dt = now - gui_bench.last_frame;
+            gui_bench.frames++;
+            gui_bench.frame_us_total += dt;
+            if (dt > gui_bench.frame_us_max) gui_bench.frame_us_max = dt;
+        }
+        gui_bench.last_frame = now;
+        return G_SOURCE_CONTINUE;
+    }
+
     // Главная функция приложения, точка входа.
     int main(int argc, char *argv[]) {
-        gtk_init(&argc, &argv); // Инициализация библиотеки GTK. Это должно быть вызвано в начале.
+        // Параметр --bench [N]: замер записи на светодиоды без окна (N чисел, по умолчанию 100000).
+        // Параметр --gui-bench [S]: S секунд (по умолчанию 5) обновлять индикаторы GUI с частотой 1 кГц,
+        // без GPIO; печатает время отрисовки, интервалы кадров и процессор.
+        // Параметр --bits N: разрядность числа 8, 16, 32 или 64; больше 8 — только с --sr595.
+        // Параметр --sr595 [DEV]: выводить число на цепочку 74HC595 через spidev (по умолчанию
+        // /dev/spidev0.0; "" — модель без устройства) вместо восьми выводов GPIO.
+        // Параметр --latch GPIO|ce: вывод защёлки RCLK (по умолчанию SR595_LATCH) или CE0.
+        long bench = 0;
+        int gui_bench_s = 0;
+        const char *sr_dev = NULL; // NULL — светодиоды на выводах gpio_pins
+        int sr_latch = SR595_LATCH;
+        for (int i = 1; i < argc; i++) {
+            const char *next = i + 1 < argc ? argv[i + 1] : NULL; // Значение параметра, если есть
+            if (strcmp(argv[i], "--bench") == 0) {
+                bench = next && atol(next) > 0 ? atol(argv[++i]) : 100000;
+            } else if (strcmp(argv[i], "--gui-bench") == 0) {
+                gui_bench_s = next && atoi(next) > 0 ? atoi(argv[++i]) : 5;
+            } else if (strcmp(argv[i], "--bits") == 0 && next) {
+                num_bits = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--sr595") == 0) {
+                sr_dev = next && next[0] != '-' ? argv[++i] : SR595_SPI_DEFAULT;
+            } else if (strcmp(argv[i], "--latch") == 0 && next) {
+                sr_latch = strcmp(next, "ce") == 0 ? SR595_LATCH_CE : atoi(next);
+                i++;
+            }
+        }
+        if (num_bits != 8 && num_bits != 16 && num_bits != 32 && num_bits != 64) {
+            fprintf(stderr, "Ошибка: --bits — 8, 16, 32 или 64\n");
+            return 1;
+        }
+        if (num_bits > NUM_LEDS && !sr_dev && !gui_bench_s) {
+            fprintf(stderr, "Ошибка: на выводах GPIO только %d светодиодов, для %u бит нужен --sr595\n",
+                    NUM_LEDS, num_bits);
+            return 1;
+        }
+        // Маска num_bits младших битов; сдвиг на 64 в C не определен, поэтому отдельно.
+        value_mask = num_bits < 64 ? ((guint64)1 << num_bits) - 1 : G_MAXUINT64;
+        if (!bench) {
+            gtk_init(&argc, &argv); // Инициализация библиотеки GTK. Замеру --bench окно не нужно.
+        }
         srand(time(NULL)); // Инициализация генератора случайных чисел.
                            // time(NULL) возвращает текущее время, обеспечивая разную последовательность чисел при каждом запуске.
 
-        // Инициализация GPIO
-        chip = gpiod_chip_open("/dev/gpiochip0"); // Открываем GPIO-чип по его пути.
-        // Альтернативный вариант: chip = gpiod_chip_open_by_name(CHIPNAME);
-        if (!chip) {
-            perror("Ошибка: не удалось открыть GPIO chip"); // Выводим сообщение об ошибке, если чип не открылся.
-            return 1; // Завершаем программу с кодом ошибки.
+        // Цепочка 74HC595: одна передача SPI на число и защёлка на одном выводе.
+        if (sr_dev) {
+            if (bench) {
+                fprintf(stderr, "--bench сравнивает выводы GPIO; для 74HC595 есть ./sr595_bench\n");
+                return 1;
+            }
+            sr = sr595_open(sr_dev, num_bits, sr_latch);
+            if (!sr) {
+                perror("Ошибка: не удалось открыть SPI или защёлку 74HC595");
+                return 1;
+            }
         }
 
-        // Запрашиваем и настраиваем все 8 GPIO-линий как выходы.
-        for (int i = 0; i < NUM_LEDS; i++) {
-            // Получаем указатель на конкретную GPIO-линию по ее номеру.
-            lines[i] = gpiod_chip_get_line(chip, gpio_pins[i]);
-            // Запрашиваем линию как выход с начальным значением 0 (выключено).
-            // Проверяем, что линия получена и запрос успешен.
-            if (!lines[i] || gpiod_line_request_output(lines[i], CONSUMER, 0) < 0) {
+        // Инициализация GPIO (в --gui-bench и с --sr595 не нужна)
+        if (!gui_bench_s && !sr) {
+            chip = gpiod_chip_open("/dev/gpiochip0"); // Открываем GPIO-чип по его пути.
+            // Альтернативный вариант: chip = gpiod_chip_open_by_name(CHIPNAME);
+            if (!chip) {
+                perror("Ошибка: не удалось открыть GPIO chip"); // Выводим сообщение об ошибке, если чип не открылся.
+                return 1; // Завершаем программу с кодом ошибки.
+            }
+
+            // Запрашиваем все 8 GPIO-линий одним bulk-запросом как выходы с начальным значением 0.
+            // При ошибке libgpiod сам освобождает уже запрошенные линии.
+            int zeros[NUM_LEDS] = {0};
+            if (gpiod_chip_get_lines(chip, gpio_pins, NUM_LEDS, &leds) < 0 ||
+                gpiod_line_request_bulk_output(&leds, CONSUMER, zeros) < 0) {
                 perror("Ошибка: не удалось настроить пины"); // Сообщение об ошибке.
-                // В случае ошибки, освобождаем все линии, которые были успешно запрошены до этого.
-                for (int j = 0; j < i; j++) {
-                    if (lines[j]) gpiod_line_release(lines[j]);
-                }
                 gpiod_chip_close(chip); // Закрываем чип.
                 return 1; // Завершаем программу.
             }
+
+            gpio_ready = TRUE;
+
+            if (bench) {
+                int res = run_bench(bench);
+                if (res < 0)
+                    perror("Ошибка: не удалось перезапросить пины для замера");
+                gpiod_line_release_bulk(&leds);
+                gpiod_chip_close(chip);
+                return res < 0 ? 1 : 0;
+            }
         }
 
         // Создание и настройка GTK интерфейса
@@ -181,23 +359,12 @@
         GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10); // Создаем вертикальный контейнер с отступом 10 пикселей между элементами.
         gtk_container_add(GTK_CONTAINER(window), vbox); // Добавляем контейнер в главное окно.
 
-        // Контейнер для светодиодов (визуальное представление битов)
-        GtkWidget *led_grid = gtk_grid_new(); // Используем GtkGrid для размещения индикаторов.
-        gtk_grid_set_row_spacing(GTK_GRID(led_grid), 10); // Устанавливаем вертикальный отступ между рядами (на всякий случай).
-        gtk_grid_set_column_spacing(GTK_GRID(led_grid), 10); // Устанавливаем ГОРИЗОНТАЛЬНЫЙ ОТСТУП между столбцами.
-
-        // Создаем 8 виджетов-контейнеров (GtkEventBox), которые будут имитировать светодиоды.
-        // Идем от 0 к NUM_LEDS-1, чтобы младший бит (LSB) был слева в GUI.
-        // Для отображения MSB слева, LSB справа, нужно инвертировать индекс столбца.
-        for (int i = 0; i < NUM_LEDS; i++) { // Итерация от LSB к MSB
-            circles[i] = gtk_event_box_new(); // Создаем GtkEventBox - это контейнер, который может иметь фон.
-            gtk_widget_set_size_request(circles[i], 30, 30); // Устанавливаем фиксированный размер для каждого "светодиода".
-            update_led_circle(i, 0); // Изначально все "светодиоды" выключены (белые).
-            // Прикрепляем виджет к сетке. (NUM_LEDS - 1) - i используется для того, чтобы circles[7] (MSB) оказался в столбце 0 (самый левый),
-            // а circles[0] (LSB) оказался в столбце 7 (самый правый).
-            gtk_grid_attach(GTK_GRID(led_grid), circles[i], (NUM_LEDS - 1) - i, 0, 1, 1);
-        }
-        gtk_box_pack_start(GTK_BOX(vbox), led_grid, FALSE, FALSE, 0); // Добавляем контейнер светодиодов в основной вертикальный контейнер.
+        // Линейка светодиодов (визуальное представление битов): один виджет рисует все
+        // num_bits кругов за один проход cairo; старший бит (MSB) слева, младший (LSB) справа.
+        // Больше 16 светодиодов линейка раскладывает в несколько строк по 16.
+        led_bar = led_bar_new(num_bits, num_bits > 16 ? 20 : 30);
+        gtk_widget_set_halign(led_bar, GTK_ALIGN_CENTER); // Центрируем линейку по горизонтали.
+        gtk_box_pack_start(GTK_BOX(vbox), led_bar, FALSE, FALSE, 0); // Добавляем линейку в основной вертикальный контейнер.
 
         // Поле ввода для ответа пользователя
         entry = gtk_entry_new(); // Создаем новое текстовое поле ввода.
@@ -229,6 +396,15 @@
         gtk_box_pack_start(GTK_BOX(vbox), incorrect_label, FALSE, FALSE, 2);   // Добавляем лейбл в основной контейнер с отступом.
 
         gtk_widget_show_all(window); // Отображаем все виджеты, содержащиеся в окне.
+
+        if (gui_bench_s) {
+            // Замер: таймер 1 мс меняет число, кадры экрана считает tick-callback линейки.
+            gui_bench.start = g_get_monotonic_time();
+            gui_bench.end = gui_bench.start + gui_bench_s * G_USEC_PER_SEC;
+            getrusage(RUSAGE_SELF, &gui_bench.ru0);
+            gtk_widget_add_tick_callback(led_bar, gui_bench_frame, NULL, NULL);
+            g_timeout_add(1, gui_bench_update, NULL);
+        }
         gtk_main(); // Запускаем основной цикл обработки событий GTK. Приложение будет активно до вызова gtk_main_quit().
 
         return 0; // Успешное завершение программы.
@@ -0,0 +1,93 @@
+#include "led_bar.h"
+#include <math.h>
+
+#define LED_BAR_GAP 10 // Промежуток между кругами, пикселей
+
+typedef struct {
+    unsigned n;
+    guint64 mask;
+    led_bar_stats_t stats;
+} led_bar_t;
+
+static led_bar_t *bar_data(GtkWidget *bar) {
+    return g_object_get_data(G_OBJECT(bar), "led-bar");
+}
+
+static gboolean led_bar_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    led_bar_t *b = user_data;
+    gint64 t0 = g_get_monotonic_time();
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+
+    // Круги вписываем в виджет по строкам; старший бит слева в верхней строке
+    unsigned cols = MIN(b->n, LED_BAR_ROW), rows = (b->n + cols - 1) / cols;
+    double step = (double)width / cols;
+    double row_step = (double)(height + LED_BAR_GAP) / rows;
+    double r = (MIN(step, row_step) - LED_BAR_GAP) / 2;
+    if (r < 1)
+        r = 1;
+
+    cairo_set_line_width(cr, 1);
+    // Сначала все выключенные, затем все включенные: два заполнения на проход
+    for (int on = 0; on <= 1; on++) {
+        for (unsigned i = 0; i < b->n; i++) {
+            unsigned bit = b->n - 1 - i;
+            if (((b->mask >> bit) & 1) != (guint64)on)
+                continue;
+            cairo_new_sub_path(cr);
+            cairo_arc(cr, step * (i % cols) + step / 2,
+                      row_step * (i / cols) + (row_step - LED_BAR_GAP) / 2, r, 0, 2 * M_PI);
+        }
+        if (on)
+            cairo_set_source_rgb(cr, 0.9, 0.1, 0.1);
+        else
+            cairo_set_source_rgb(cr, 1, 1, 1);
+        cairo_fill_preserve(cr);
+        cairo_set_source_rgb(cr, 0.3, 0.3, 0.3);
+        cairo_stroke(cr);
+    }
+
+    gint64 dt = g_get_monotonic_time() - t0;
+    b->stats.draws++;
+    b->stats.draw_us_total += dt;
+    if (dt > b->stats.draw_us_max)
+        b->stats.draw_us_max = dt;
+    return FALSE;
+}
+
+GtkWidget *led_bar_new(unsigned n, int size) {
+    led_bar_t *b = g_new0(led_bar_t, 1);
+    GtkWidget *bar = gtk_drawing_area_new();
+
+    b->n = CLAMP(n, 1, LED_BAR_MAX);
+    unsigned cols = MIN(b->n, LED_BAR_ROW), rows = (b->n + cols - 1) / cols;
+    g_object_set_data_full(G_OBJECT(bar), "led-bar", b, g_free);
+    gtk_widget_set_size_request(bar, cols * (size + LED_BAR_GAP), rows * (size + LED_BAR_GAP) - LED_BAR_GAP);
+    g_signal_connect(bar, "draw", G_CALLBACK(led_bar_draw), b);
+    return bar;
+}
+
+void led_bar_set_mask(GtkWidget *bar, guint64 mask) {
+    led_bar_t *b = bar_data(bar);
+
+    if (b->n < 64)
+        mask &= (G_GUINT64_CONSTANT(1) << b->n) - 1;
+    b->stats.updates++;
+    if (mask == b->mask)
+        return;
+    b->mask = mask;
+    b->stats.changes++;
+    gtk_widget_queue_draw(bar);
+}
+
+guint64 led_bar_get_mask(GtkWidget *bar) {
+    return bar_data(bar)->mask;
+}
+
+unsigned led_bar_get_count(GtkWidget *bar) {
+    return bar_data(bar)->n;
+}
+
+void led_bar_get_stats(GtkWidget *bar, led_bar_stats_t *st) {
+    *st = bar_data(bar)->stats;
+}
@@ -0,0 +1,32 @@
+#ifndef LED_BAR_H
+#define LED_BAR_H
+
+#include <gtk/gtk.h>
+
+// Линейка светодиодов: один виджет (GtkDrawingArea) рисует все N
+// светодиодов кругами за один проход cairo. Состояние — битовая маска
+// (бит 0 — самый правый светодиод); перерисовка запрашивается, только
+// когда маска изменилась, и выполняется одна на кадр экрана, сколько бы
+// раз маску ни меняли за кадр. Больше LED_BAR_ROW светодиодов
+// раскладываются в несколько строк: старшие биты — в верхней, бит 0 —
+// справа в нижней.
+
+#define LED_BAR_MAX 64
+#define LED_BAR_ROW 16 // Светодиодов в строке
+
+typedef struct {
+    unsigned long updates;   // Вызовов led_bar_set_mask
+    unsigned long changes;   // Из них с новой маской (запрос перерисовки)
+    unsigned long draws;     // Выполненных отрисовок
+    gint64 draw_us_total;    // Время в обработчике draw, мкс
+    gint64 draw_us_max;
+} led_bar_stats_t;
+
+// n — число светодиодов (1..LED_BAR_MAX), size — диаметр круга, пикселей
+GtkWidget *led_bar_new(unsigned n, int size);
+void led_bar_set_mask(GtkWidget *bar, guint64 mask);
+guint64 led_bar_get_mask(GtkWidget *bar);
+unsigned led_bar_get_count(GtkWidget *bar);
+void led_bar_get_stats(GtkWidget *bar, led_bar_stats_t *st);
+
+#endif // LED_BAR_H
@@ -0,0 +1,158 @@
+#include "sr595.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gpiod.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#define SR595_CHIP "/dev/gpiochip0"
+#define SR595_CONSUMER "sr595"
+
+struct sr595 {
+    int fd;                 // -1 — модель без устройства
+    unsigned bytes;
+    struct gpiod_chip *chip;
+    struct gpiod_line *latch; // NULL — защёлкивает CE0
+    int loopback;
+    uint64_t value;         // Последнее записанное
+    uint8_t tx[SR595_MAX_BITS / 8];
+    uint8_t rx[SR595_MAX_BITS / 8];
+    uint8_t chain[SR595_MAX_BITS / 8];   // Модель: сдвиговые регистры, [0] — ближний
+    uint64_t model_out;                  // Модель: выходы после защёлки
+    sr595_stats_t stats;
+};
+
+// Передаёт младшие bytes байтов value, старший первым, и защёлкивает
+static int sr595_transfer(sr595_t *s, uint64_t value) {
+    for (unsigned i = 0; i < s->bytes; i++)
+        s->tx[i] = value >> (8 * (s->bytes - 1 - i));
+
+    if (s->fd < 0) {
+        // Каждый байт сдвигает цепочку на регистр дальше от Pi
+        for (unsigned i = 0; i < s->bytes; i++) {
+            memmove(s->chain + 1, s->chain, s->bytes - 1);
+            s->chain[0] = s->tx[i];
+        }
+        s->model_out = 0;
+        for (unsigned k = 0; k < s->bytes; k++)
+            s->model_out |= (uint64_t)s->chain[k] << (8 * k);
+        return 0;
+    }
+
+    struct spi_ioc_transfer tr;
+    memset(&tr, 0, sizeof(tr));
+    tr.tx_buf = (uintptr_t)s->tx;
+    tr.rx_buf = s->loopback ? (uintptr_t)s->rx : 0;
+    tr.len = s->bytes;
+    tr.speed_hz = SR595_SPI_HZ;
+    tr.bits_per_word = 8;
+    if (ioctl(s->fd, SPI_IOC_MESSAGE(1), &tr) < 0) {
+        s->stats.errors++;
+        return -1;
+    }
+    if (s->loopback && memcmp(s->tx, s->rx, s->bytes) != 0)
+        s->stats.mismatch++;
+    // Подъём RCLK переносит сдвинутое на выходы
+    if (s->latch && (gpiod_line_set_value(s->latch, 1) < 0 || gpiod_line_set_value(s->latch, 0) < 0)) {
+        s->stats.errors++;
+        return -1;
+    }
+    return 0;
+}
+
+sr595_t *sr595_open(const char *dev, unsigned bits, int latch_gpio) {
+    int err;
+
+    if (bits != 8 && bits != 16 && bits != 32 && bits != 64) {
+        errno = EINVAL;
+        return NULL;
+    }
+    sr595_t *s = calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->fd = -1;
+    s->bytes = bits / 8;
+
+    if (!dev)
+        dev = SR595_SPI_DEFAULT;
+    if (*dev) {
+        uint8_t mode = SPI_MODE_0, wbits = 8;
+        uint32_t hz = SR595_SPI_HZ;
+        s->fd = open(dev, O_RDWR | O_CLOEXEC);
+        if (s->fd < 0 || ioctl(s->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+            ioctl(s->fd, SPI_IOC_WR_BITS_PER_WORD, &wbits) < 0 ||
+            ioctl(s->fd, SPI_IOC_WR_MAX_SPEED_HZ, &hz) < 0)
+            goto fail;
+        if (latch_gpio != SR595_LATCH_CE) {
+            s->chip = gpiod_chip_open(SR595_CHIP);
+            if (!s->chip || !(s->latch = gpiod_chip_get_line(s->chip, latch_gpio)) ||
+                gpiod_line_request_output(s->latch, SR595_CONSUMER, 0) < 0) {
+                s->latch = NULL;
+                goto fail;
+            }
+        }
+    }
+    if (sr595_transfer(s, 0) < 0)
+        goto fail;
+    return s;
+
+fail:
+    err = errno;
+    if (s->latch)
+        gpiod_line_release(s->latch);
+    if (s->chip)
+        gpiod_chip_close(s->chip);
+    if (s->fd >= 0)
+        close(s->fd);
+    free(s);
+    errno = err;
+    return NULL;
+}
+
+void sr595_close(sr595_t *s) {
+    if (!s)
+        return;
+    sr595_transfer(s, 0);
+    if (s->latch)
+        gpiod_line_release(s->latch);
+    if (s->chip)
+        gpiod_chip_close(s->chip);
+    if (s->fd >= 0)
+        close(s->fd);
+    free(s);
+}
+
+unsigned sr595_bits(sr595_t *s) {
+    return s->bytes * 8;
+}
+
+int sr595_write(sr595_t *s, uint64_t value) {
+    if (s->bytes < 8)
+        value &= ((uint64_t)1 << (8 * s->bytes)) - 1;
+    if (value == s->value)
+        return 0;
+    if (sr595_transfer(s, value) < 0)
+        return -1;
+    s->value = value;
+    s->stats.updates++;
+    return 0;
+}
+
+uint64_t sr595_outputs(sr595_t *s) {
+    return s->fd < 0 ? s->model_out : s->value;
+}
+
+void sr595_set_loopback(sr595_t *s, int on) {
+    s->loopback = on;
+}
+
+unsigned sr595_wire_ns(sr595_t *s) {
+    return (unsigned)((unsigned long long)s->bytes * 8 * 1000000000 / SR595_SPI_HZ);
+}
+
+void sr595_get_stats(sr595_t *s, sr595_stats_t *st) {
+    *st = s->stats;
+}
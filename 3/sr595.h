@@ -0,0 +1,61 @@
+#ifndef SR595_H
+#define SR595_H
+
+#include <stdint.h>
+
+// Сдвиговые регистры 74HC595, соединённые цепочкой, через SPI
+// (/dev/spidev0.0): MOSI (GPIO10) — на SER первого регистра, SCLK (GPIO11) —
+// на SRCLK всех, QH' каждого — на SER следующего. Восемь выводов на
+// регистр, 8/16/32/64 бита — 1/2/4/8 регистров, а выводов Raspberry Pi
+// занято всего три.
+//
+// Число уходит одной SPI_IOC_MESSAGE (старший байт первым, старший бит
+// первым), после чего импульс на RCLK переносит сдвинутое на выходы: все
+// светодиоды меняются одновременно. В регистре, ближнем к Pi, оказываются
+// биты 0..7 (QA — бит 0), в следующем 8..15 и так далее.
+//
+// RCLK подключается к отдельному GPIO (запрос через libgpiod) или к CE0:
+// с SR595_LATCH_CE защёлкивает сам подъём CE0 в конце передачи, и на
+// обновление остаётся один ioctl.
+//
+// Без устройства (dev "") вместо spidev работает модель цепочки: байты
+// вдвигаются в неё так же, как в регистры, и sr595_outputs возвращает то,
+// что оказалось бы на выходах, — для проверки порядка битов и замеров.
+
+#define SR595_SPI_DEFAULT "/dev/spidev0.0"
+#define SR595_SPI_HZ 8000000 // 74HC595 при 3,3 В держит не меньше 20 МГц
+#define SR595_MAX_BITS 64
+#define SR595_LATCH_CE -1    // RCLK на CE0, отдельный GPIO не нужен
+
+typedef struct {
+    unsigned long updates;  // Чисел, действительно переданных
+    unsigned long errors;   // Ошибок ioctl
+    unsigned long mismatch; // С loopback: принятое не совпало с переданным
+} sr595_stats_t;
+
+typedef struct sr595 sr595_t;
+
+// bits — 8, 16, 32 или 64; latch_gpio — номер GPIO для RCLK или
+// SR595_LATCH_CE. dev NULL — SR595_SPI_DEFAULT, "" — модель без устройства.
+// Выходы обнуляются. NULL — ошибка (errno).
+sr595_t *sr595_open(const char *dev, unsigned bits, int latch_gpio);
+// Гасит выходы и освобождает spidev и линию защёлки
+void sr595_close(sr595_t *s);
+
+unsigned sr595_bits(sr595_t *s);
+// Выдаёт младшие bits битов value на выходы. 0 — передано или не
+// изменилось, -1 — ошибка (errno).
+int sr595_write(sr595_t *s, uint64_t value);
+// Что сейчас на выходах: модель — вдвинутое в цепочку, устройство —
+// последнее записанное значение
+uint64_t sr595_outputs(sr595_t *s);
+
+// Проверка по перемычке MOSI–MISO: принимать ответ каждой передачи и
+// сравнивать с отправленным (счётчик mismatch)
+void sr595_set_loopback(sr595_t *s, int on);
+// Время передачи числа по шине, нс
+unsigned sr595_wire_ns(sr595_t *s);
+
+void sr595_get_stats(sr595_t *s, sr595_stats_t *st);
+
+#endif // SR595_H
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sr595.h"
+
+/**
+ * @file sr595_bench.c
+ * @brief Замер вывода числа на цепочку 74HC595 по SPI при 8/16/32/64 битах.
+ *
+ *   ./sr595_bench [spidev [GPIO защёлки|ce [loop]]]
+ *
+ * По умолчанию — без устройства: работает модель цепочки (sr595.h), и
+ * после каждой записи проверяется, что на её выходах ровно записанное
+ * число. С указанным spidev (защёлка по умолчанию — GPIO5) числа уходят в
+ * настоящие регистры; с «loop» принимается и сверяется ответ каждой
+ * передачи — для этого MOSI (GPIO10) соединяют перемычкой с MISO (GPIO9).
+ *
+ * Для каждой ширины — задержка записи числа (среднее, p50, p99, максимум),
+ * достижимая частота обновления и предел шины на SR595_SPI_HZ.
+ */
+
+#define UPDATES 20000
+#define DEFAULT_LATCH 5
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char *argv[]) {
+    const char *dev = argc > 1 ? argv[1] : "";
+    int latch = argc > 2 ? (strcmp(argv[2], "ce") == 0 ? SR595_LATCH_CE : atoi(argv[2])) : DEFAULT_LATCH;
+    int loop = argc > 3 && strcmp(argv[3], "loop") == 0;
+    static const unsigned widths[] = {8, 16, 32, 64};
+    double *lat = malloc(UPDATES * sizeof(*lat));
+
+    if (!lat)
+        return 1;
+    printf("%s, %d updates per width, SPI %d Hz\n\n", *dev ? dev : "model (no device)", UPDATES,
+           SR595_SPI_HZ);
+    printf("%-5s %9s %8s %8s %8s %11s %11s %6s\n", "bits", "mean us", "p50 us", "p99 us", "max us",
+           "updates/s", "wire max/s", "check");
+
+    for (unsigned w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        sr595_t *s = sr595_open(dev, widths[w], latch);
+        if (!s) {
+            perror("sr595_open");
+            free(lat);
+            return 1;
+        }
+        sr595_set_loopback(s, loop);
+
+        // Псевдослучайные числа (xorshift), каждое отличается от предыдущего
+        uint64_t x = 0x9e3779b97f4a7c15ULL, mask = widths[w] < 64 ? (1ULL << widths[w]) - 1 : ~0ULL;
+        unsigned long bad = 0;
+        double t_all = now_us();
+        for (int i = 0; i < UPDATES; i++) {
+            uint64_t prev = x & mask;
+            do {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+            } while ((x & mask) == prev);
+            double t = now_us();
+            sr595_write(s, x);
+            lat[i] = now_us() - t;
+            if (!*dev && sr595_outputs(s) != (x & mask))
+                bad++;
+        }
+        t_all = now_us() - t_all;
+
+        sr595_stats_t st;
+        sr595_get_stats(s, &st);
+        double sum = 0;
+        for (int i = 0; i < UPDATES; i++)
+            sum += lat[i];
+        qsort(lat, UPDATES, sizeof(lat[0]), cmp_double);
+        printf("%-5u %9.2f %8.2f %8.2f %8.2f %11.0f %11.0f ", widths[w], sum / UPDATES,
+               lat[UPDATES / 2], lat[UPDATES * 99 / 100], lat[UPDATES - 1],
+               UPDATES / t_all * 1e6, 1e9 / sr595_wire_ns(s));
+        if (!*dev)
+            printf("%6s", bad ? "FAIL" : "ok");
+        else if (loop)
+            printf("%6s", st.mismatch ? "FAIL" : "ok");
+        else
+            printf("%6s", "-");
+        if (st.errors)
+            printf("  (%lu errors)", st.errors);
+        printf("\n");
+        sr595_close(s);
+    }
+    free(lat);
+    return 0;
+}
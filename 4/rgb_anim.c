@@ -0,0 +1,104 @@
+#include "rgb_anim.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Положение ползунка (может быть дробным) -> уровень
+static unsigned short anim_level(double v) {
+    if (v <= 0)
+        return 0;
+    if (v >= 255)
+        return RGB_LEVEL_MAX;
+    return (unsigned short)lround(pow(v / 255.0, RGB_GAMMA) * RGB_LEVEL_MAX);
+}
+
+static void anim_put(rgb_schedule_t *s, unsigned i, double r, double g, double b) {
+    s->level[i][0] = anim_level(r);
+    s->level[i][1] = anim_level(g);
+    s->level[i][2] = anim_level(b);
+}
+
+// Оттенок h в [0, 1) при полной насыщенности и яркости
+static void anim_hue(double h, double rgb[3]) {
+    double x = h * 6;
+    int sector = (int)x % 6;
+    double f = x - floor(x);
+
+    switch (sector) {
+        case 0: rgb[0] = 1; rgb[1] = f; rgb[2] = 0; break;
+        case 1: rgb[0] = 1 - f; rgb[1] = 1; rgb[2] = 0; break;
+        case 2: rgb[0] = 0; rgb[1] = 1; rgb[2] = f; break;
+        case 3: rgb[0] = 0; rgb[1] = 1 - f; rgb[2] = 1; break;
+        case 4: rgb[0] = f; rgb[1] = 0; rgb[2] = 1; break;
+        default: rgb[0] = 1; rgb[1] = 0; rgb[2] = 1 - f; break;
+    }
+}
+
+static void anim_fade(const rgb_anim_t *a, rgb_schedule_t *s, unsigned tick_us) {
+    unsigned k = 0;
+
+    for (unsigned i = 0; i < s->ticks; i++) {
+        double ms = i * (tick_us / 1000.0);
+        while (k + 2 < a->nkeys && ms >= a->keys[k + 1].ms)
+            k++;
+        const rgb_keyframe_t *p = &a->keys[k], *q = &a->keys[k + 1];
+        double t = q->ms > p->ms ? (ms - p->ms) / (q->ms - p->ms) : 1;
+        if (t > 1)
+            t = 1;
+        anim_put(s, i, p->rgb[0] + (q->rgb[0] - p->rgb[0]) * t,
+                 p->rgb[1] + (q->rgb[1] - p->rgb[1]) * t, p->rgb[2] + (q->rgb[2] - p->rgb[2]) * t);
+    }
+}
+
+rgb_schedule_t *rgb_anim_build(const rgb_anim_t *a, unsigned tick_us) {
+    unsigned ms;
+
+    if (tick_us == 0)
+        return NULL;
+    if (a->kind == RGB_ANIM_FADE) {
+        if (a->nkeys < 2 || a->nkeys > RGB_ANIM_KEYS_MAX || a->keys[0].ms != 0)
+            return NULL;
+        for (unsigned k = 1; k < a->nkeys; k++)
+            if (a->keys[k].ms < a->keys[k - 1].ms)
+                return NULL;
+        ms = a->keys[a->nkeys - 1].ms;
+    } else {
+        ms = a->period_ms;
+    }
+    if (ms == 0 || ms > RGB_ANIM_MAX_MS)
+        return NULL;
+
+    // Для цикла — ровно период; без цикла ещё тик на последний кадр
+    unsigned ticks = (unsigned)((ms * 1000ULL + tick_us - 1) / tick_us);
+    int loop = a->kind != RGB_ANIM_FADE || a->loop;
+    if (!loop)
+        ticks++;
+    rgb_schedule_t *s = malloc(sizeof(*s) + ticks * sizeof(s->level[0]));
+    if (!s)
+        return NULL;
+    s->ticks = ticks;
+    s->loop = loop;
+
+    for (unsigned i = 0; i < ticks && a->kind != RGB_ANIM_FADE; i++) {
+        double phase = (double)i / ticks; // Доля периода, [0, 1)
+        double rgb[3];
+        switch (a->kind) {
+            case RGB_ANIM_BREATHE: {
+                double b = (1 - cos(2 * M_PI * phase)) / 2;
+                anim_put(s, i, a->rgb[0] * b, a->rgb[1] * b, a->rgb[2] * b);
+                break;
+            }
+            case RGB_ANIM_RAINBOW:
+                anim_hue(phase, rgb);
+                anim_put(s, i, rgb[0] * 255, rgb[1] * 255, rgb[2] * 255);
+                break;
+            default: { // RGB_ANIM_STROBE
+                double on = phase * 100 < a->flash_pct;
+                anim_put(s, i, a->rgb[0] * on, a->rgb[1] * on, a->rgb[2] * on);
+                break;
+            }
+        }
+    }
+    if (a->kind == RGB_ANIM_FADE)
+        anim_fade(a, s, tick_us);
+    return s;
+}
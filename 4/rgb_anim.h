@@ -0,0 +1,43 @@
+#ifndef RGB_ANIM_H
+#define RGB_ANIM_H
+
+#include "rgb_dither.h"
+
+// Анимации RGB-светодиода: описание (что и с каким периодом) превращается
+// в расписание уровней на каждый тик подмешивания. Вся плавающая точка —
+// здесь, при построении; поток тиков только читает готовые уровни.
+//
+// Цвета задаются как положения ползунков 0..255 и интерполируются в них же
+// (равномерно для глаза), а в уровень переводятся по RGB_GAMMA — точнее
+// таблицы rgb_gamma, поэтому медленные переходы у нуля не ступенчатые.
+
+#define RGB_ANIM_KEYS_MAX 16
+#define RGB_ANIM_MAX_MS 60000 // Длиннее расписание не строится (144 КБ)
+
+typedef enum {
+    RGB_ANIM_FADE,    // Линейные переходы между ключевыми кадрами
+    RGB_ANIM_BREATHE, // Цвет rgb, яркость по косинусу от 0 до полной и обратно
+    RGB_ANIM_RAINBOW, // Оттенок по кругу при полной насыщенности
+    RGB_ANIM_STROBE,  // Вспышка цветом rgb на flash_pct % периода
+} rgb_anim_kind_t;
+
+typedef struct {
+    unsigned ms;          // От начала анимации; у первого кадра 0
+    unsigned char rgb[3];
+} rgb_keyframe_t;
+
+typedef struct {
+    rgb_anim_kind_t kind;
+    unsigned period_ms;   // Цикл дыхания, радуги и строба
+    unsigned char rgb[3]; // Цвет дыхания и строба
+    unsigned flash_pct;   // Строб: доля вспышки, %
+    int loop;             // Переходы: по кругу (иначе остаётся последний кадр)
+    unsigned nkeys;
+    rgb_keyframe_t keys[RGB_ANIM_KEYS_MAX];
+} rgb_anim_t;
+
+// Расписание для rgb_dither_play с тиком tick_us. Дыхание, радуга и строб
+// повторяются всегда. NULL — неверное описание или длиннее RGB_ANIM_MAX_MS.
+rgb_schedule_t *rgb_anim_build(const rgb_anim_t *a, unsigned tick_us);
+
+#endif // RGB_ANIM_H
@@ -0,0 +1,135 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "rgb_anim.h"
+
+/**
+ * @file rgb_anim_bench.c
+ * @brief Замер анимации: процессор во время радуги и сроки тиков.
+ *
+ *   ./rgb_anim_bench [секунд [busy]]   (по умолчанию 60)
+ *
+ * Строит расписание радуги (цикл 6 с), отдаёт его потоку подмешивания и
+ * ждёт заданное время. Вместо gpioPWM вызовы только считаются, поэтому
+ * железо не нужно; на Raspberry Pi цифры показывают цену самого движка.
+ * С 'busy' главный поток всё это время крутит пустой цикл — как занятый
+ * GTK: сроки тиков от этого меняться не должны.
+ *
+ * Печатает время построения и размер расписания, процессор потоков,
+ * кроме главного (/proc/self/task), в процентах одного ядра, тики,
+ * вызовы вывода, опоздания и наибольший скачок уровня между тиками.
+ */
+
+static unsigned long out_calls;
+
+static void count_out(void *ctx, unsigned channel, unsigned duty, unsigned level) {
+    (void)ctx;
+    (void)channel;
+    (void)duty;
+    (void)level;
+    out_calls++;
+}
+
+// Наибольший скачок уровня между соседними тиками расписания, с переходом
+// через конец цикла
+static unsigned max_step(const rgb_schedule_t *s) {
+    unsigned max = 0;
+
+    for (unsigned i = 0; i < s->ticks; i++) {
+        unsigned j = i + 1 < s->ticks ? i + 1 : 0;
+        for (int c = 0; c < RGB_DITHER_CHANNELS; c++) {
+            int step = abs((int)s->level[j][c] - (int)s->level[i][c]);
+            if ((unsigned)step > max)
+                max = (unsigned)step;
+        }
+    }
+    return max;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Процессорное время всех потоков процесса, кроме главного, с
+static double other_threads_cpu_s(void) {
+    DIR *d = opendir("/proc/self/task");
+    struct dirent *e;
+    double sum = 0;
+    long clk = sysconf(_SC_CLK_TCK);
+
+    if (!d)
+        return 0;
+    while ((e = readdir(d))) {
+        char path[300];
+        unsigned long utime, stime;
+        if (e->d_name[0] < '0' || e->d_name[0] > '9' || atoi(e->d_name) == getpid())
+            continue;
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", e->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            continue;
+        // Поля 14 и 15 — utime и stime в тиках; имя процесса без пробелов
+        if (fscanf(f, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime,
+                   &stime) == 2)
+            sum += (double)(utime + stime) / clk;
+        fclose(f);
+    }
+    closedir(d);
+    return sum;
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 60;
+    int busy = argc > 2 && strcmp(argv[2], "busy") == 0;
+    rgb_anim_t rainbow = {.kind = RGB_ANIM_RAINBOW, .period_ms = 6000};
+    rgb_dither_stats_t st;
+
+    if (seconds < 1)
+        seconds = 1;
+
+    double t0 = now_s();
+    rgb_schedule_t *s = rgb_anim_build(&rainbow, RGB_DITHER_TICK_US);
+    double build = now_s() - t0;
+    if (!s) {
+        fprintf(stderr, "rgb_anim_build failed\n");
+        return 1;
+    }
+    printf("rainbow %u ms: %u ticks, %zu bytes, built in %.2f ms\n", rainbow.period_ms, s->ticks,
+           sizeof(*s) + s->ticks * sizeof(s->level[0]), build * 1e3);
+    printf("smoothness: max level step between ticks %u of %d\n", max_step(s), RGB_LEVEL_MAX);
+
+    rgb_dither_t *d = rgb_dither_new(RGB_DITHER_TICK_US, count_out, NULL);
+    if (!d) {
+        fprintf(stderr, "rgb_dither_new failed\n");
+        return 1;
+    }
+    printf("playing for %d s%s...\n", seconds, busy ? " with a busy main thread" : "");
+    fflush(stdout);
+
+    double cpu0 = other_threads_cpu_s();
+    t0 = now_s();
+    rgb_dither_play(d, s);
+    if (busy) {
+        volatile unsigned long spin = 0;
+        while (now_s() - t0 < seconds)
+            spin++;
+    } else {
+        sleep(seconds);
+    }
+    double wall = now_s() - t0;
+    double cpu = other_threads_cpu_s() - cpu0;
+    rgb_dither_get_stats(d, &st);
+    rgb_dither_free(d);
+
+    printf("engine cpu: %.3f%% of one core (%.3f s in %.1f s)\n", cpu * 100 / wall, cpu, wall);
+    printf("ticks: %lu (expected %.0f), output calls %lu, realtime %s\n", st.ticks,
+           wall * RGB_PWM_FREQUENCY, out_calls, st.realtime ? "yes" : "no");
+    printf("timing: %lu overruns, max wakeup late %lu us of %d us period\n", st.overruns,
+           st.max_late_us, RGB_DITHER_TICK_US);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "rgb_dither.h"
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define DITHER_RT_PRIORITY 50 // SCHED_FIFO, как у потока движения сервоприводов
+#define DITHER_MASK ((1u << RGB_DITHER_BITS) - 1)
+
+struct rgb_dither {
+    rgb_dither_out_fn out;
+    rgb_dither_flush_fn flush; // Пишет rgb_dither_set_flush (атомарно)
+    void *ctx;
+    long tick_ns;
+
+    // Уровни пишет rgb_dither_set (атомарно), остальное — только тики
+    unsigned level[RGB_DITHER_CHANNELS];
+    unsigned seen[RGB_DITHER_CHANNELS]; // Уровни последнего тика
+    unsigned acc[RGB_DITHER_CHANNELS];
+    unsigned duty[RGB_DITHER_CHANNELS];
+    unsigned long ticks, writes;
+
+    // Играющее расписание и позиция в нём — только тики
+    rgb_schedule_t *sched;
+    unsigned pos;
+
+    int threaded;
+    pthread_t thread;
+    pthread_mutex_t lock; // idle, quit, stats и передача расписаний
+    pthread_cond_t cond;
+    int idle, quit;
+    rgb_schedule_t *pending; // Новое расписание для потока
+    int has_pending;         // pending задан (NULL — остановить)
+    rgb_schedule_t *retired; // Прежнее расписание; освобождает следующий play
+    rgb_dither_stats_t stats;
+};
+
+static void *dither_main(void *arg);
+
+rgb_dither_t *rgb_dither_new(unsigned tick_us, rgb_dither_out_fn out, void *ctx) {
+    rgb_dither_t *d = calloc(1, sizeof(*d));
+
+    if (!d)
+        return NULL;
+    d->out = out;
+    d->ctx = ctx;
+    d->tick_ns = tick_us * 1000L;
+    for (int c = 0; c < RGB_DITHER_CHANNELS; c++) {
+        d->duty[c] = ~0u; // Первый тик выводит все каналы
+        d->seen[c] = ~0u;
+    }
+
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->cond, NULL);
+    if (tick_us && pthread_create(&d->thread, NULL, dither_main, d) != 0) {
+        pthread_cond_destroy(&d->cond);
+        pthread_mutex_destroy(&d->lock);
+        free(d);
+        return NULL;
+    }
+    d->threaded = tick_us != 0;
+    return d;
+}
+
+void rgb_dither_free(rgb_dither_t *d) {
+    if (!d)
+        return;
+
+    if (d->threaded) {
+        pthread_mutex_lock(&d->lock);
+        d->quit = 1;
+        pthread_cond_signal(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+        pthread_join(d->thread, NULL);
+    }
+    free(d->sched);
+    free(d->pending);
+    free(d->retired);
+    pthread_cond_destroy(&d->cond);
+    pthread_mutex_destroy(&d->lock);
+    free(d);
+}
+
+void rgb_dither_set(rgb_dither_t *d, unsigned channel, unsigned level) {
+    if (channel >= RGB_DITHER_CHANNELS)
+        return;
+    if (level > RGB_LEVEL_MAX)
+        level = RGB_LEVEL_MAX;
+
+    // Под блокировкой: поток проверяет уровни перед сном под ней же
+    pthread_mutex_lock(&d->lock);
+    __atomic_store_n(&d->level[channel], level, __ATOMIC_RELAXED);
+    if (d->idle)
+        pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+}
+
+// Принимает новое расписание (под блокировкой или без потока)
+static void dither_take_pending(rgb_dither_t *d) {
+    if (!d->has_pending)
+        return;
+    // Прежнее освобождает не поток тиков, а следующий play
+    free(d->retired);
+    d->retired = d->sched;
+    d->sched = d->pending;
+    d->pending = NULL;
+    d->has_pending = 0;
+    d->pos = 0;
+    for (int c = 0; c < RGB_DITHER_CHANNELS; c++)
+        d->seen[c] = ~0u; // После остановки вернуться к уровням rgb_dither_set
+}
+
+void rgb_dither_play(rgb_dither_t *d, rgb_schedule_t *s) {
+    rgb_schedule_t *drop[2];
+
+    if (s && s->ticks == 0) {
+        free(s);
+        s = NULL;
+    }
+    pthread_mutex_lock(&d->lock);
+    drop[0] = d->retired;
+    drop[1] = d->pending; // Ещё не принятое потоком
+    d->retired = NULL;
+    d->pending = s;
+    d->has_pending = 1;
+    if (!d->threaded)
+        dither_take_pending(d);
+    else if (d->idle)
+        pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    free(drop[0]);
+    free(drop[1]);
+}
+
+void rgb_dither_set_flush(rgb_dither_t *d, rgb_dither_flush_fn flush) {
+    __atomic_store_n(&d->flush, flush, __ATOMIC_RELEASE);
+}
+
+int rgb_dither_tick(rgb_dither_t *d) {
+    const unsigned short *sl = NULL;
+    unsigned frac_any = 0;
+    unsigned long writes = d->writes;
+    int playing = 0;
+
+    if (d->sched) {
+        sl = d->sched->level[d->pos];
+        if (d->pos + 1 < d->sched->ticks) {
+            d->pos++;
+            playing = 1;
+        } else if (d->sched->loop) {
+            d->pos = 0;
+            playing = 1;
+        }
+    }
+
+    for (unsigned c = 0; c < RGB_DITHER_CHANNELS; c++) {
+        unsigned level = sl ? sl[c] : __atomic_load_n(&d->level[c], __ATOMIC_RELAXED);
+        unsigned frac = level & DITHER_MASK;
+        // Сигма-дельта: перенос из накопленного остатка добавляет ступень
+        unsigned acc = d->acc[c] + frac;
+        unsigned duty = (level >> RGB_DITHER_BITS) + (acc >> RGB_DITHER_BITS);
+        d->acc[c] = acc & DITHER_MASK;
+        frac_any |= frac;
+        if (duty != d->duty[c] || level != d->seen[c]) {
+            d->duty[c] = duty;
+            d->out(d->ctx, c, duty, level);
+            d->writes++;
+        }
+        d->seen[c] = level;
+    }
+    rgb_dither_flush_fn flush = __atomic_load_n(&d->flush, __ATOMIC_ACQUIRE);
+    if (flush && d->writes != writes)
+        flush(d->ctx);
+    d->ticks++;
+    return playing || frac_any != 0;
+}
+
+void rgb_dither_get_stats(rgb_dither_t *d, rgb_dither_stats_t *st) {
+    pthread_mutex_lock(&d->lock);
+    *st = d->stats;
+    pthread_mutex_unlock(&d->lock);
+    if (!d->threaded) {
+        st->ticks = d->ticks;
+        st->writes = d->writes;
+    }
+}
+
+static void ts_add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static long ts_diff_ns(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec - b->tv_sec) * 1000000000L + (a->tv_nsec - b->tv_nsec);
+}
+
+// Уровень менялся после последнего тика (вызывать под блокировкой)
+static int dither_levels_changed(rgb_dither_t *d) {
+    if (d->has_pending)
+        return 1;
+    if (d->sched)
+        return 0; // Доигранное расписание держит свои уровни
+    for (int c = 0; c < RGB_DITHER_CHANNELS; c++)
+        if (__atomic_load_n(&d->level[c], __ATOMIC_RELAXED) != d->seen[c])
+            return 1;
+    return 0;
+}
+
+static void *dither_main(void *arg) {
+    rgb_dither_t *d = arg;
+    struct sched_param sp = {.sched_priority = DITHER_RT_PRIORITY};
+    struct timespec next, now;
+
+    // Приоритет реального времени, если он разрешён (root или CAP_SYS_NICE)
+    int rt = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    pthread_mutex_lock(&d->lock);
+    d->stats.realtime = rt;
+    while (!d->quit) {
+        dither_take_pending(d);
+        pthread_mutex_unlock(&d->lock);
+        int active = rgb_dither_tick(d);
+
+        long late = 0;
+        if (active) {
+            // Абсолютные сроки: опоздание одного тика не сдвигает остальные
+            ts_add_ns(&next, d->tick_ns);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (ts_diff_ns(&now, &next) > 0) {
+                late = -1;
+                next = now;
+            } else {
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                late = ts_diff_ns(&now, &next) / 1000;
+            }
+        }
+
+        pthread_mutex_lock(&d->lock);
+        d->stats.ticks = d->ticks;
+        d->stats.writes = d->writes;
+        if (late < 0)
+            d->stats.overruns++;
+        else if ((unsigned long)late > d->stats.max_late_us)
+            d->stats.max_late_us = late;
+        if (!active && !d->quit && !dither_levels_changed(d)) {
+            // Скважности постоянны: спим до нового уровня или расписания
+            d->idle = 1;
+            pthread_cond_wait(&d->cond, &d->lock);
+            d->idle = 0;
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return NULL;
+}
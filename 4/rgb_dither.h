@@ -0,0 +1,72 @@
+#ifndef RGB_DITHER_H
+#define RGB_DITHER_H
+
+// Яркость RGB с разрешением выше, чем у ШИМ pigpio. pigpio выбирает выходы
+// раз в 5 мкс, поэтому при 400 Гц у ШИМ всего 500 реальных ступеней. Уровень
+// канала задаётся в восемь раз точнее (RGB_LEVEL_MAX = 4000, около 12 бит):
+// целая часть — скважность ШИМ, дробная (RGB_DITHER_BITS бит) добавляет
+// ступень в части периодов ШИМ. Добавка считается сигма-дельтой: остаток
+// копится от периода к периоду, поэтому за 2^RGB_DITHER_BITS периодов
+// средняя скважность равна уровню точно, а шум уходит на высокие частоты.
+//
+// Тик — один период ШИМ: на канал сложение, сдвиг и маска, без плавающей
+// точки; вывод вызывается, только если скважность или уровень изменились.
+// Тики идут в своём потоке по абсолютным срокам; если дробных частей нет и
+// анимация не играет, поток спит до следующего rgb_dither_set.
+//
+// Анимация — заранее посчитанное расписание: уровни каналов на каждый тик
+// (rgb_anim.c строит его из описания). Пока оно играет, тик берёт уровни из
+// него, а не из rgb_dither_set; GUI только передаёт расписание потоку.
+
+#define RGB_DITHER_CHANNELS 3
+#define RGB_PWM_FREQUENCY 400 // Гц
+#define RGB_PWM_RANGE 500     // Реальный диапазон pigpio при 400 Гц и выборке 5 мкс
+#define RGB_DITHER_BITS 3     // Дробных бит уровня: полный цикл — 8 периодов ШИМ
+#define RGB_LEVEL_MAX (RGB_PWM_RANGE << RGB_DITHER_BITS)
+#define RGB_DITHER_TICK_US (1000000 / RGB_PWM_FREQUENCY)
+#define RGB_GAMMA 2.2         // Положение ползунка -> уровень: (v / 255)^RGB_GAMMA
+
+// Вывод канала channel из потока тиков: скважность 0..RGB_PWM_RANGE с
+// подмешиванием и уровень 0..RGB_LEVEL_MAX, из которого она получена
+// (выходу с большим разрешением, как аппаратный ШИМ, хватает уровня)
+typedef void (*rgb_dither_out_fn)(void *ctx, unsigned channel, unsigned duty, unsigned level);
+// Конец тика, в котором был хотя бы один вызов out: выходу, который
+// передает все каналы сразу (лента WS2812), — один кадр на тик
+typedef void (*rgb_dither_flush_fn)(void *ctx);
+
+// Расписание уровней: level[i] — уровни каналов на тике i
+typedef struct {
+    unsigned ticks;
+    int loop; // По кругу; иначе после конца остаётся последний уровень
+    unsigned short level[][RGB_DITHER_CHANNELS];
+} rgb_schedule_t;
+
+typedef struct {
+    int realtime;              // Поток получил SCHED_FIFO
+    unsigned long ticks;       // Тиков выполнено
+    unsigned long writes;      // Вызовов out (скважность изменилась)
+    unsigned long overruns;    // Тиков, начатых позже срока следующего
+    unsigned long max_late_us; // Наибольшее опоздание пробуждения
+} rgb_dither_stats_t;
+
+typedef struct rgb_dither rgb_dither_t;
+
+// tick_us — период тиков; 0 — без потока, тики вызывает сам вызывающий
+// (замер). Все каналы начинают с уровня 0.
+rgb_dither_t *rgb_dither_new(unsigned tick_us, rgb_dither_out_fn out, void *ctx);
+void rgb_dither_free(rgb_dither_t *d);
+// Задает вызов в конце тика (NULL — без него); можно вызывать из любого потока
+void rgb_dither_set_flush(rgb_dither_t *d, rgb_dither_flush_fn flush);
+
+// Уровень канала 0..RGB_LEVEL_MAX; можно вызывать из любого потока
+void rgb_dither_set(rgb_dither_t *d, unsigned channel, unsigned level);
+// Запускает расписание (владение переходит к rgb_dither) с начала
+// следующего тика; NULL — остановить, каналы вернутся к rgb_dither_set
+void rgb_dither_play(rgb_dither_t *d, rgb_schedule_t *s);
+// Один период ШИМ. 0 — дробных частей нет и анимация не играет:
+// следующие тики ничего не изменят.
+int rgb_dither_tick(rgb_dither_t *d);
+
+void rgb_dither_get_stats(rgb_dither_t *d, rgb_dither_stats_t *st);
+
+#endif // RGB_DITHER_H
@@ -0,0 +1,142 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "rgb_dither.h"
+#include "rgb_gamma.h"
+
+/**
+ * @file rgb_dither_bench.c
+ * @brief Замер вывода яркости: разрешение, цена тика и сроки потока.
+ *
+ *   ./rgb_dither_bench [секунд потока]   (по умолчанию 2)
+ *
+ * Железо не нужно: вместо gpioPWM вызовы только считаются.
+ *  1) разрешение — для каждого уровня 0..RGB_LEVEL_MAX средняя скважность за
+ *     полный цикл сигма-дельты должна точно равняться уровню; и сколько разных
+ *     яркостей дают 256 положений ползунка с гаммой при 8-битном ШИМ и с
+ *     подмешиванием;
+ *  2) цена тика — наносекунды на rgb_dither_tick при меняющихся уровнях и
+ *     какая это доля периода ШИМ;
+ *  3) поток — тики по абсолютным срокам: сколько выполнено, опоздания.
+ */
+
+static unsigned long out_calls;
+static unsigned out_sum;
+
+static void count_out(void *ctx, unsigned channel, unsigned duty, unsigned level) {
+    (void)ctx;
+    (void)channel;
+    (void)level;
+    out_calls++;
+    out_sum += duty;
+}
+
+// Последняя скважность канала 0: за тик, где она не менялась, — прежняя
+static unsigned last_duty;
+
+static void track_out(void *ctx, unsigned channel, unsigned duty, unsigned level) {
+    (void)ctx;
+    (void)level;
+    if (channel == 0)
+        last_duty = duty;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check_resolution(void) {
+    rgb_dither_t *d = rgb_dither_new(0, track_out, NULL);
+    unsigned cycle = 1u << RGB_DITHER_BITS;
+    int exact = 0;
+
+    for (unsigned level = 0; level <= RGB_LEVEL_MAX; level++) {
+        unsigned sum = 0;
+        rgb_dither_set(d, 0, level);
+        for (unsigned t = 0; t < cycle; t++) {
+            rgb_dither_tick(d);
+            sum += last_duty;
+        }
+        if (sum == level) // Средняя скважность sum / cycle == level / cycle
+            exact++;
+    }
+    rgb_dither_free(d);
+
+    // Разные яркости на 256 положений ползунка: гамма на 8-битном ШИМ (как
+    // было бы с диапазоном 255) и на уровнях с подмешиванием
+    int distinct8 = 0, distinct = 0;
+    long prev8 = -1, prev = -1;
+    for (int i = 0; i < 256; i++) {
+        long v8 = lround(pow(i / 255.0, 2.2) * 255);
+        if (v8 != prev8)
+            distinct8++;
+        if (rgb_gamma[i] != prev)
+            distinct++;
+        prev8 = v8;
+        prev = rgb_gamma[i];
+    }
+
+    printf("resolution: %d of %d levels exact over a %u-tick cycle (%.2f bits, PWM range %d)\n",
+           exact, RGB_LEVEL_MAX + 1, cycle, log2(RGB_LEVEL_MAX + 1.0), RGB_PWM_RANGE);
+    printf("gamma 2.2, 256 slider positions: %d distinct at 8 bit, %d with dithering\n", distinct8,
+           distinct);
+    printf("lowest step: 8 bit %.3f%%, dithered %.3f%% of full brightness\n\n", 100.0 / 255,
+           100.0 / RGB_LEVEL_MAX);
+}
+
+static void tick_cost(void) {
+    const long ticks = 10000000;
+    rgb_dither_t *d = rgb_dither_new(0, count_out, NULL);
+
+    // Уровни с дробной частью: скважность меняется почти каждый тик
+    rgb_dither_set(d, 0, 1234);
+    rgb_dither_set(d, 1, 2001);
+    rgb_dither_set(d, 2, 3);
+    out_calls = 0;
+    double t0 = now_ns();
+    for (long i = 0; i < ticks; i++)
+        rgb_dither_tick(d);
+    double per_tick = (now_ns() - t0) / ticks;
+    rgb_dither_free(d);
+
+    printf("tick: %.1f ns for %d channels, %.2f output calls/tick (checksum %u)\n", per_tick,
+           RGB_DITHER_CHANNELS, (double)out_calls / ticks, out_sum);
+    printf("      %.5f%% of the %d us PWM period\n\n", per_tick / (RGB_DITHER_TICK_US * 10.0),
+           RGB_DITHER_TICK_US);
+}
+
+static void thread_timing(int seconds) {
+    rgb_dither_stats_t st;
+    rgb_dither_t *d = rgb_dither_new(RGB_DITHER_TICK_US, count_out, NULL);
+
+    if (!d) {
+        printf("thread: could not start\n");
+        return;
+    }
+    rgb_dither_set(d, 0, 1234);
+    rgb_dither_set(d, 1, 2001);
+    rgb_dither_set(d, 2, 3);
+    sleep(seconds);
+    rgb_dither_get_stats(d, &st);
+    rgb_dither_free(d);
+
+    printf("thread: %lu ticks in %d s (expected %d), realtime %s\n", st.ticks, seconds,
+           seconds * RGB_PWM_FREQUENCY, st.realtime ? "yes" : "no");
+    printf("        %lu overruns, max wakeup late %lu us of %d us period\n", st.overruns,
+           st.max_late_us, RGB_DITHER_TICK_US);
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 2;
+
+    if (seconds < 1)
+        seconds = 1;
+    check_resolution();
+    tick_cost();
+    thread_timing(seconds);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <math.h>
+#include <stdio.h>
+#include "rgb_dither.h"
+
+/**
+ * @file rgb_gamma_gen.c
+ * @brief Генератор таблицы гамма-коррекции rgb_gamma.h (запускает Makefile).
+ *
+ * Глаз воспринимает яркость примерно как степень 1/2,2 от мощности, поэтому
+ * линейный ползунок дает резкие ступени внизу и почти незаметные вверху.
+ * Таблица переводит положение ползунка 0..255 в уровень 0..RGB_LEVEL_MAX
+ * по степени RGB_GAMMA (rgb_dither.h), так что в программе остается одно обращение к
+ * массиву без плавающей точки.
+ */
+
+int main(void) {
+    printf("// Создано rgb_gamma_gen.c (make), не редактировать.\n");
+    printf("// Положение ползунка 0..255 -> уровень 0..%d, гамма %.1f\n", RGB_LEVEL_MAX, RGB_GAMMA);
+    printf("#ifndef RGB_GAMMA_H\n#define RGB_GAMMA_H\n\n");
+    printf("static const unsigned short rgb_gamma[256] = {");
+    for (int i = 0; i < 256; i++) {
+        long level = lround(pow(i / 255.0, RGB_GAMMA) * RGB_LEVEL_MAX);
+        // Ненулевое положение ползунка — хотя бы наименьший уровень
+        if (i > 0 && level == 0)
+            level = 1;
+        printf("%s%4ld,", i % 12 ? " " : "\n    ", level);
+    }
+    printf("\n};\n\n#endif // RGB_GAMMA_H\n");
+    return 0;
+}
@@ -1,6 +1,14 @@
 #include <gtk/gtk.h> // Подключаем библиотеку GTK для создания графического интерфейса
 #include <pigpio.h> // Подключаем библиотеку pigpio для работы с GPIO и ШИМ
 #include <stdio.h>   // Подключаем стандартную библиотеку ввода/вывода для snprintf
+#include <stdlib.h>  // atol для --stress
+#include <string.h>  // strcmp для разбора командной строки
+#include <errno.h>   // errno для сообщения об ошибке ленты
+#include "hw_pwm.h"  // Аппаратный ШИМ ядра (../6): GPIO12/13/18/19 без pigpio
+#include "rgb_dither.h" // 12-битная яркость: подмешивание поверх ШИМ pigpio
+#include "rgb_anim.h"   // Анимации: расписания уровней для потока подмешивания
+#include "ws2812.h"     // Адресуемая лента WS2812 по SPI (--strip)
+#include "rgb_gamma.h"  // Таблица гамма-коррекции (создается make)
 
 // Определяем константы для номеров GPIO-пинов, связанных с каждым цветом.
 // Эти пины будут использоваться для ШИМ.
@@ -8,8 +16,11 @@
 #define GREEN_PIN  27
 #define BLUE_PIN   18
 
+// Период аппаратного ШИМ — та же частота, что у каналов pigpio
+#define RGB_PWM_PERIOD_NS (1000000000UL / RGB_PWM_FREQUENCY)
+
 // Глобальные указатели на виджеты GTK.
-// color_area: Виджет, который будет отображать текущий смешанный цвет.
+// color_area: Образец цвета — область рисования, которую закрашивает on_color_draw.
 // label_r, label_g, label_b: Метки для отображения числовых значений (0-255) каждого цвета.
 GtkWidget *color_area;
 GtkWidget *label_r, *label_g, *label_b;
@@ -19,10 +30,98 @@ GtkWidget *scale_r_global;
 GtkWidget *scale_g_global;
 GtkWidget *scale_b_global;
 
+// Каналы R, G, B: вывод, аппаратный ШИМ (NULL — через pigpio) и последнее записанное значение.
+// Пишем только изменившийся канал: ползунок двигает один цвет, остальные два не трогаем.
+static const unsigned color_pins[3] = {RED_PIN, GREEN_PIN, BLUE_PIN};
+static hw_pwm_t *color_hw[3];
+static int color_value[3] = {-1, -1, -1};
+
+// Поток тиков: единственный, кто пишет в выводы (и pigpio, и аппаратный ШИМ)
+static rgb_dither_t *dither;
+static unsigned pwm_duty[3] = {~0u, ~0u, ~0u}; // Последняя скважность gpioPWM
+
+// Играет анимация: движение ползунка ее останавливает
+static gboolean animating;
+
+// --strip: вместо трех выводов — лента WS2812, все пиксели одним цветом.
+// Тик потока тогда — не период ШИМ, а передача кадра ленты.
+static ws2812_t *strip;
+static uint8_t strip_rgb[3];
+static int strip_dirty; // strip_rgb изменился за текущий тик
+static unsigned tick_us = RGB_DITHER_TICK_US;
+
+// Цвет образца (0-255), который рисует on_color_draw
+static int swatch_rgb[3];
+
+// --stress: ползунки двигает цикл замера, ШИМ не выводится
+static gboolean dry_run;
+
 // --- Функции ---
 
-// Функция для обновления цвета виджета в GUI
+// Вывод канала из потока подмешивания. Аппаратному ШИМ хватает разрешения
+// для самого уровня; каналам pigpio — скважность с подмешиванием.
+static void dither_output(void *ctx, unsigned channel, unsigned duty, unsigned level) {
+    if (strip) {
+        // У WS2812 8 бит на цвет: уровень после гаммы переводим в 0-255.
+        // Подмешивание ленте не нужно: кадр уходит, только если цвет изменился,
+        // и один на тик — в dither_flush, когда записаны все три канала.
+        uint8_t v = (level * 255 + RGB_LEVEL_MAX / 2) / RGB_LEVEL_MAX;
+        if (v != strip_rgb[channel]) {
+            strip_rgb[channel] = v;
+            strip_dirty = 1;
+        }
+    } else if (color_hw[channel]) {
+        hw_pwm_set_duty(color_hw[channel],
+                        (unsigned long long)level * RGB_PWM_PERIOD_NS / RGB_LEVEL_MAX);
+    } else if (duty != pwm_duty[channel]) {
+        pwm_duty[channel] = duty;
+        gpioPWM(color_pins[channel], duty);
+    }
+}
+
+// Конец тика: лента получает цвет целиком, без кадра со смесью старых и
+// новых каналов
+static void dither_flush(void *ctx) {
+    if (!strip_dirty)
+        return;
+    strip_dirty = 0;
+    ws2812_fill(strip, strip_rgb[0], strip_rgb[1], strip_rgb[2]);
+    ws2812_show(strip);
+}
+
+// Задает яркость канала (0-255), если она изменилась. Положение ползунка
+// переводится таблицей гаммы в 12-битный уровень, который выводит поток тиков.
+static void set_channel(int i, int value) {
+    if (value == color_value[i])
+        return;
+    color_value[i] = value;
+    if (dry_run)
+        return;
+    rgb_dither_set(dither, i, rgb_gamma[value]);
+}
+
+// Рисует образец: заливка сохраненным цветом, без CSS и перестроения стилей
+static gboolean on_color_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    cairo_set_source_rgb(cr, swatch_rgb[0] / 255.0, swatch_rgb[1] / 255.0, swatch_rgb[2] / 255.0);
+    cairo_paint(cr);
+    return FALSE;
+}
+
+// Функция для обновления цвета виджета в GUI: запоминаем цвет и просим перерисовку.
+// Сама отрисовка — одна на кадр экрана, сколько бы событий ни пришло за кадр.
 void update_color_display(int r, int g, int b) {
+    if (r == swatch_rgb[0] && g == swatch_rgb[1] && b == swatch_rgb[2])
+        return;
+    swatch_rgb[0] = r;
+    swatch_rgb[1] = g;
+    swatch_rgb[2] = b;
+    gtk_widget_queue_draw(color_area);
+}
+
+// Прежний способ — новый GtkCssProvider на каждое событие. Провайдеры копятся в
+// контексте стиля и не удаляются, поэтому каждое следующее обновление дороже.
+// Оставлен только для сравнения в --stress-css.
+static void update_color_display_css(int r, int g, int b) {
     char css[128];
     // Формируем строку CSS, которая задает фоновый цвет виджета
     snprintf(css, sizeof(css), "#color_display { background-color: rgb(%d,%d,%d); }", r, g, b);
@@ -35,10 +134,19 @@ void update_color_display(int r, int g, int b) {
     g_object_unref(provider);
 }
 
+// Как показывать цвет: образец cairo или (--stress-css) прежний CSS
+static void (*show_color)(int r, int g, int b) = update_color_display;
+
 // Функция обратного вызова, вызываемая при изменении значения любого ползунка.
 // user_data теперь не используется для получения значений ползунков,
 // так как они глобальны.
 void on_scale_changed(GtkRange *range, gpointer user_data) {
+    // Ползунок снова задает цвет сам: анимацию останавливаем
+    if (animating) {
+        rgb_dither_play(dither, NULL);
+        animating = FALSE;
+    }
+
     // Получаем текущие значения со всех трех ползунков напрямую, так как они глобальны
     int r = (int)gtk_range_get_value(GTK_RANGE(scale_r_global));
     int g = (int)gtk_range_get_value(GTK_RANGE(scale_g_global));
@@ -55,13 +163,119 @@ void on_scale_changed(GtkRange *range, gpointer user_data) {
     snprintf(text, sizeof(text), "B: %d", b);
     gtk_label_set_text(GTK_LABEL(label_b), text);
 
-    // Отправляем ШИМ-сигналы на GPIO-пины с помощью pigpio
-    gpioPWM(RED_PIN, r);
-    gpioPWM(GREEN_PIN, g);
-    gpioPWM(BLUE_PIN, b);
+    // Отправляем ШИМ-сигналы на GPIO-пины (только изменившиеся каналы)
+    set_channel(0, r);
+    set_channel(1, g);
+    set_channel(2, b);
 
     // Обновляем цвет отображаемого виджета в GUI
-    update_color_display(r, g, b);
+    show_color(r, g, b);
+}
+
+/**
+ * @brief Обработчик кнопок анимации.
+ *
+ * Собирает описание анимации из текущего цвета ползунков, строит по нему
+ * расписание уровней и передает его потоку тиков. Дальше GTK в анимации не
+ * участвует: плавность не зависит от того, насколько занят интерфейс.
+ * Кнопка "Стоп" (kind < 0) возвращает светодиод к цвету ползунков.
+ */
+static void on_anim_clicked(GtkButton *button, gpointer user_data) {
+    int kind = GPOINTER_TO_INT(user_data);
+    unsigned char r = swatch_rgb[0], g = swatch_rgb[1], b = swatch_rgb[2];
+    rgb_anim_t a = {.kind = kind};
+
+    if (dry_run)
+        return;
+    if (kind < 0) {
+        rgb_dither_play(dither, NULL);
+        animating = FALSE;
+        return;
+    }
+    // Дыханию и стробу нужен видимый цвет: черный заменяем белым
+    if (r == 0 && g == 0 && b == 0)
+        r = g = b = 255;
+    switch (kind) {
+        case RGB_ANIM_FADE: // Текущий цвет -> дополнительный -> текущий, по кругу
+            a.loop = 1;
+            a.nkeys = 3;
+            a.keys[0] = (rgb_keyframe_t){0, {r, g, b}};
+            a.keys[1] = (rgb_keyframe_t){2000, {255 - r, 255 - g, 255 - b}};
+            a.keys[2] = (rgb_keyframe_t){4000, {r, g, b}};
+            break;
+        case RGB_ANIM_BREATHE:
+            a.period_ms = 4000;
+            break;
+        case RGB_ANIM_RAINBOW:
+            a.period_ms = 6000;
+            break;
+        case RGB_ANIM_STROBE:
+            a.period_ms = 250;
+            a.flash_pct = 20;
+            break;
+    }
+    a.rgb[0] = r;
+    a.rgb[1] = g;
+    a.rgb[2] = b;
+
+    rgb_schedule_t *s = rgb_anim_build(&a, tick_us);
+    if (s) {
+        rgb_dither_play(dither, s);
+        animating = TRUE;
+    }
+}
+
+// Резидентная память процесса (VmRSS), кБ
+static long rss_kb(void) {
+    char line[128];
+    long kb = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "VmRSS: %ld", &kb) == 1)
+            break;
+    fclose(f);
+    return kb;
+}
+
+/**
+ * @brief Нагрузочный замер: n обновлений через on_scale_changed.
+ *
+ * Ползунки двигаются по очереди, каждый раз на новое значение, так что каждое
+ * gtk_range_set_value вызывает on_scale_changed. Замер идет десятью частями;
+ * после каждой обрабатываются ожидающие события (перерисовка, перестроение
+ * стилей), и печатаются время на обновление и резидентная память — рост от
+ * части к части показывает, копится ли что-то за сеанс.
+ */
+static void run_stress(long n) {
+    GtkRange *scales[3] = {GTK_RANGE(scale_r_global), GTK_RANGE(scale_g_global),
+                           GTK_RANGE(scale_b_global)};
+    long chunk = n >= 10 ? n / 10 : 1;
+    long rss0 = rss_kb();
+    gint64 start = g_get_monotonic_time();
+
+    printf("%s: %ld updates via on_scale_changed\n",
+           show_color == update_color_display ? "cairo swatch" : "css provider", n);
+    printf("%10s %12s %10s\n", "updates", "us/update", "rss kB");
+    for (long done = 0; done < n;) {
+        gint64 t0 = g_get_monotonic_time();
+        long end = done + chunk < n ? done + chunk : n;
+        for (long i = done; i < end; i++) {
+            // Шаг 37 не кратен 256: у ползунка каждый раз новое значение
+            long j = i / 3;
+            gtk_range_set_value(scales[i % 3], (j * 37 + i % 3) % 256);
+        }
+        while (gtk_events_pending())
+            gtk_main_iteration();
+        printf("%10ld %12.2f %10ld\n", end, (double)(g_get_monotonic_time() - t0) / (end - done),
+               rss_kb());
+        fflush(stdout);
+        done = end;
+    }
+    printf("total %.2f us/update, rss %+ld kB\n", (double)(g_get_monotonic_time() - start) / n,
+           rss_kb() - rss0);
 }
 
 // --- Основная функция программы ---
@@ -70,10 +284,67 @@ int main(int argc, char *argv[]) {
     // Инициализация GTK. Должна быть вызвана первой.
     gtk_init(&argc, &argv);
 
+    // --- Параметры командной строки ---
+    //   --hw-pwm          каналы на GPIO12/13/18/19 — аппаратным ШИМ ядра
+    //   --stress [N]      замер N обновлений (по умолчанию 100000) без вывода ШИМ
+    //   --stress-css [N]  то же с прежним выводом цвета через GtkCssProvider
+    //   --strip N         лента WS2812 из N пикселей на SPI (MOSI — GPIO10)
+    //   --spi DEV         устройство spidev ленты (по умолчанию /dev/spidev0.0)
+    gboolean use_hw_pwm = FALSE;
+    long stress = 0;
+    unsigned strip_pixels = 0;
+    const char *spi_dev = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hw-pwm") == 0) {
+            use_hw_pwm = TRUE;
+        } else if (strcmp(argv[i], "--strip") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            strip_pixels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spi") == 0 && i + 1 < argc) {
+            spi_dev = argv[++i];
+        } else if (strcmp(argv[i], "--stress") == 0 || strcmp(argv[i], "--stress-css") == 0) {
+            if (strcmp(argv[i], "--stress-css") == 0)
+                show_color = update_color_display_css;
+            stress = i + 1 < argc && atol(argv[i + 1]) > 0 ? atol(argv[++i]) : 100000;
+            dry_run = TRUE;
+        } else {
+            g_printerr("Использование: %s [--hw-pwm | --strip N [--spi DEV]] [--stress [N] | --stress-css [N]]\n",
+                       argv[0]);
+            return 1;
+        }
+    }
+
+    // --- Аппаратный ШИМ (--hw-pwm) ---
+    // Каналы на GPIO12/13/18/19 ведет периферия ШИМ через sysfs ядра: без pigpio и его
+    // постоянной выборки каждые 5 мкс. Остальные каналы (и все, если sysfs недоступен) — через pigpio.
+    // --- Лента WS2812 (--strip) ---
+    // Выводы светодиода и pigpio тогда не нужны; поток тиков ведет ленту кадр за кадром
+    if (strip_pixels && !dry_run) {
+        strip = ws2812_open(spi_dev, strip_pixels);
+        if (!strip) {
+            g_printerr("Ошибка: не удалось открыть %s: %s\n", spi_dev ? spi_dev : WS2812_SPI_DEFAULT,
+                       g_strerror(errno));
+            return 1;
+        }
+        // Лента могла остаться гореть с прошлого запуска, а strip_rgb
+        // начинается с черного: первый тик кадра не отправит
+        ws2812_fill(strip, 0, 0, 0);
+        ws2812_show(strip);
+        if (ws2812_frame_us(strip) > tick_us)
+            tick_us = ws2812_frame_us(strip);
+    }
+
+    int need_pigpio = 0;
+    for (int i = 0; i < 3 && !dry_run && !strip; i++) {
+        if (use_hw_pwm)
+            color_hw[i] = hw_pwm_open(color_pins[i], RGB_PWM_PERIOD_NS);
+        if (!color_hw[i])
+            need_pigpio = 1;
+    }
+
     // --- Инициализация библиотеки pigpio ---
     // Это должно быть сделано перед любым использованием pigpio функций.
     // Если gpioInitialise() возвращает < 0, это означает ошибку (демон не запущен или недоступен).
-    if (gpioInitialise() < 0) {
+    if (need_pigpio && gpioInitialise() < 0) {
         g_printerr("Ошибка: Демон pigpiod не запущен или недоступен.\n");
         g_printerr("Пожалуйста, убедитесь, что pigpiod запущен (например, командой 'sudo pigpiod' или 'sudo systemctl start pigpiod').\n");
 
@@ -94,11 +365,23 @@ int main(int argc, char *argv[]) {
         return 1; // Завершаем программу с ошибкой
     }
 
-    // Устанавливаем диапазон ШИМ для каждого пина в 255.
-    // Это означает, что значения от 0 до 255 будут соответствовать 0% до 100% рабочего цикла.
-    gpioSetPWMrange(RED_PIN, 255);
-    gpioSetPWMrange(GREEN_PIN, 255);
-    gpioSetPWMrange(BLUE_PIN, 255);
+    // Частота и диапазон ШИМ каналов pigpio: при 400 Гц и выборке 5 мкс у pigpio
+    // RGB_PWM_RANGE (500) реальных ступеней, вдвое больше прежних 255. Дробную
+    // часть уровня добавляет поток подмешивания — раз в период ШИМ.
+    for (int i = 0; i < 3 && need_pigpio; i++) {
+        if (!color_hw[i]) {
+            gpioSetPWMfrequency(color_pins[i], RGB_PWM_FREQUENCY);
+            gpioSetPWMrange(color_pins[i], RGB_PWM_RANGE);
+        }
+    }
+    if (!dry_run && !(dither = rgb_dither_new(tick_us, dither_output, NULL))) {
+        g_printerr("Ошибка: не удалось запустить поток подмешивания.\n");
+        if (need_pigpio)
+            gpioTerminate();
+        return 1;
+    }
+    if (strip)
+        rgb_dither_set_flush(dither, dither_flush);
 
     // --- Создание главного окна GTK ---
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -113,9 +396,10 @@ int main(int argc, char *argv[]) {
     gtk_container_add(GTK_CONTAINER(window), vbox); // Добавляем vbox в главное окно
 
     // --- Виджет для отображения цвета ---
-    color_area = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0); // Создаем контейнер, который будет служить областью цвета
+    color_area = gtk_drawing_area_new(); // Образец цвета рисуем сами через cairo
     gtk_widget_set_size_request(color_area, 250, 150); // Увеличиваем размер области цвета
-    gtk_widget_set_name(color_area, "color_display"); // Присваиваем CSS-идентификатор для стилизации
+    gtk_widget_set_name(color_area, "color_display"); // CSS-идентификатор для прежнего способа (--stress-css)
+    g_signal_connect(color_area, "draw", G_CALLBACK(on_color_draw), NULL);
     gtk_box_pack_start(GTK_BOX(vbox), color_area, FALSE, FALSE, 0); // Добавляем в vbox
     gtk_widget_set_halign(color_area, GTK_ALIGN_CENTER); // Центрируем по горизонтали
 
@@ -155,6 +439,24 @@ int main(int argc, char *argv[]) {
     gtk_grid_attach(GTK_GRID(grid), scale_b_global,      1, 2, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), label_b,             2, 2, 1, 1);
 
+    // --- Кнопки анимаций ---
+    // Поток тиков проигрывает готовое расписание; GTK только отдает его
+    static const struct {
+        const char *label;
+        int kind;
+    } anims[] = {
+        {"Переход", RGB_ANIM_FADE},   {"Дыхание", RGB_ANIM_BREATHE}, {"Радуга", RGB_ANIM_RAINBOW},
+        {"Строб", RGB_ANIM_STROBE},   {"Стоп", -1},
+    };
+    GtkWidget *anim_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_widget_set_halign(anim_box, GTK_ALIGN_CENTER);
+    gtk_box_pack_start(GTK_BOX(vbox), anim_box, FALSE, FALSE, 0);
+    for (size_t i = 0; i < sizeof(anims) / sizeof(anims[0]); i++) {
+        GtkWidget *button = gtk_button_new_with_label(anims[i].label);
+        g_signal_connect(button, "clicked", G_CALLBACK(on_anim_clicked), GINT_TO_POINTER(anims[i].kind));
+        gtk_box_pack_start(GTK_BOX(anim_box), button, TRUE, TRUE, 0);
+    }
+
     // --- Подключение сигналов к ползункам ---
     // Теперь user_data не нужен, можно передать NULL
     g_signal_connect(scale_r_global, "value-changed", G_CALLBACK(on_scale_changed), NULL);
@@ -162,9 +464,22 @@ int main(int argc, char *argv[]) {
     g_signal_connect(scale_b_global, "value-changed", G_CALLBACK(on_scale_changed), NULL);
 
     gtk_widget_show_all(window);
-    gtk_main();
-
-    // --- Очистка ресурсов pigpio после завершения работы GUI ---
-    gpioTerminate();
+    if (stress > 0)
+        run_stress(stress);
+    else
+        gtk_main();
+
+    // --- Очистка ресурсов pigpio и аппаратного ШИМ после завершения работы GUI ---
+    rgb_dither_free(dither);
+    if (strip) {
+        // Гасим ленту: close дожидается передачи последнего кадра
+        ws2812_fill(strip, 0, 0, 0);
+        ws2812_show(strip);
+        ws2812_close(strip);
+    }
+    for (int i = 0; i < 3; i++)
+        hw_pwm_close(color_hw[i]);
+    if (need_pigpio)
+        gpioTerminate();
     return 0;
 }
\ No newline at end of file
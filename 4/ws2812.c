@@ -0,0 +1,281 @@
+#include "ws2812.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+// Байты SPI для трёх групп битов исходного байта (см. ws2812.h):
+//   байт 0 = 1 b7 0 1 b6 0 1 b5, байт 1 = 0 1 b4 0 1 b3 0 1,
+//   байт 2 = b2 0 1 b1 0 1 b0 0
+static const uint8_t enc_hi[8] = {0x92, 0x93, 0x9a, 0x9b, 0xd2, 0xd3, 0xda, 0xdb};
+static const uint8_t enc_mid[8] = {0x49, 0x4d, 0x69, 0x6d}; // Только индексы 0..3
+static const uint8_t enc_lo[8] = {0x24, 0x26, 0x34, 0x36, 0xa4, 0xa6, 0xb4, 0xb6};
+
+// Полная таблица: байт -> три байта SPI; заполняется при первом open
+static uint8_t enc_lut[256][3];
+static pthread_once_t enc_once = PTHREAD_ONCE_INIT;
+
+static void enc_lut_init(void) {
+    for (int b = 0; b < 256; b++) {
+        enc_lut[b][0] = enc_hi[b >> 5];
+        enc_lut[b][1] = enc_mid[(b >> 3) & 3];
+        enc_lut[b][2] = enc_lo[b & 7];
+    }
+}
+
+void ws2812_encode_lut(const uint8_t *in, size_t n, uint8_t *out) {
+    pthread_once(&enc_once, enc_lut_init);
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *e = enc_lut[in[i]];
+        out[0] = e[0];
+        out[1] = e[1];
+        out[2] = e[2];
+        out += 3;
+    }
+}
+
+#ifdef __ARM_NEON
+void ws2812_encode(const uint8_t *in, size_t n, uint8_t *out) {
+    size_t i = 0;
+#ifdef __aarch64__
+    const uint8x16_t hi = vcombine_u8(vld1_u8(enc_hi), vld1_u8(enc_hi));
+    const uint8x16_t mid = vcombine_u8(vld1_u8(enc_mid), vld1_u8(enc_mid));
+    const uint8x16_t lo = vcombine_u8(vld1_u8(enc_lo), vld1_u8(enc_lo));
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t x = vld1q_u8(in + i);
+        uint8x16x3_t y;
+        y.val[0] = vqtbl1q_u8(hi, vshrq_n_u8(x, 5));
+        y.val[1] = vqtbl1q_u8(mid, vandq_u8(vshrq_n_u8(x, 3), vdupq_n_u8(3)));
+        y.val[2] = vqtbl1q_u8(lo, vandq_u8(x, vdupq_n_u8(7)));
+        vst3q_u8(out + 3 * i, y); // Чередование: out[3k + j] = y.val[j][k]
+    }
+#else
+    const uint8x8_t hi = vld1_u8(enc_hi), mid = vld1_u8(enc_mid), lo = vld1_u8(enc_lo);
+    for (; i + 8 <= n; i += 8) {
+        uint8x8_t x = vld1_u8(in + i);
+        uint8x8x3_t y;
+        y.val[0] = vtbl1_u8(hi, vshr_n_u8(x, 5));
+        y.val[1] = vtbl1_u8(mid, vand_u8(vshr_n_u8(x, 3), vdup_n_u8(3)));
+        y.val[2] = vtbl1_u8(lo, vand_u8(x, vdup_n_u8(7)));
+        vst3_u8(out + 3 * i, y);
+    }
+#endif
+    ws2812_encode_lut(in + i, n - i, out + 3 * i);
+}
+
+const char *ws2812_encoder(void) {
+    return "neon";
+}
+#else
+void ws2812_encode(const uint8_t *in, size_t n, uint8_t *out) {
+    ws2812_encode_lut(in, n, out);
+}
+
+const char *ws2812_encoder(void) {
+    return "lut";
+}
+#endif
+
+struct ws2812 {
+    int fd; // -1 — без устройства
+    unsigned npixels;
+    uint8_t *pixels;  // Задний буфер G, R, B
+    uint8_t *spi[2];  // Закодированные кадры с нулями в конце
+    size_t spi_len;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int inflight;     // Буфер SPI, который передаётся (-1 — никакой)
+    int pending;      // Буфер, ждущий передачи (-1 — никакой)
+    int quit;
+    ws2812_stats_t stats;
+};
+
+static void *ws2812_main(void *arg);
+
+ws2812_t *ws2812_open(const char *dev, unsigned npixels) {
+    int err;
+
+    if (npixels == 0 || npixels > WS2812_MAX_PIXELS) {
+        errno = EINVAL;
+        return NULL;
+    }
+    pthread_once(&enc_once, enc_lut_init);
+
+    ws2812_t *s = calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->fd = -1;
+    s->npixels = npixels;
+    s->inflight = s->pending = -1;
+    s->spi_len = npixels * 9 + WS2812_RESET_BYTES;
+    s->pixels = calloc(npixels, 3);
+    s->spi[0] = calloc(1, s->spi_len); // Нули в конце — пауза защёлкивания
+    s->spi[1] = calloc(1, s->spi_len);
+    if (!s->pixels || !s->spi[0] || !s->spi[1])
+        goto fail;
+
+    if (!dev)
+        dev = WS2812_SPI_DEFAULT;
+    if (*dev) {
+        uint8_t mode = SPI_MODE_0, bits = 8;
+        uint32_t hz = WS2812_SPI_HZ;
+        s->fd = open(dev, O_RDWR | O_CLOEXEC);
+        if (s->fd < 0 || ioctl(s->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+            ioctl(s->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+            ioctl(s->fd, SPI_IOC_WR_MAX_SPEED_HZ, &hz) < 0)
+            goto fail;
+        pthread_mutex_init(&s->lock, NULL);
+        pthread_cond_init(&s->cond, NULL);
+        if (pthread_create(&s->thread, NULL, ws2812_main, s) != 0) {
+            pthread_cond_destroy(&s->cond);
+            pthread_mutex_destroy(&s->lock);
+            goto fail;
+        }
+    }
+    return s;
+
+fail:
+    err = errno;
+    if (s->fd >= 0)
+        close(s->fd);
+    free(s->pixels);
+    free(s->spi[0]);
+    free(s->spi[1]);
+    free(s);
+    errno = err;
+    return NULL;
+}
+
+void ws2812_close(ws2812_t *s) {
+    if (!s)
+        return;
+    if (s->fd >= 0) {
+        pthread_mutex_lock(&s->lock);
+        s->quit = 1;
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+        pthread_join(s->thread, NULL);
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->lock);
+        close(s->fd);
+    }
+    free(s->pixels);
+    free(s->spi[0]);
+    free(s->spi[1]);
+    free(s);
+}
+
+unsigned ws2812_pixels(ws2812_t *s) {
+    return s->npixels;
+}
+
+uint8_t *ws2812_buffer(ws2812_t *s) {
+    return s->pixels;
+}
+
+void ws2812_set(ws2812_t *s, unsigned pixel, uint8_t r, uint8_t g, uint8_t b) {
+    if (pixel >= s->npixels)
+        return;
+    uint8_t *p = s->pixels + 3 * pixel;
+    p[0] = g;
+    p[1] = r;
+    p[2] = b;
+}
+
+void ws2812_fill(ws2812_t *s, uint8_t r, uint8_t g, uint8_t b) {
+    for (unsigned i = 0; i < s->npixels; i++)
+        ws2812_set(s, i, r, g, b);
+}
+
+static long elapsed_ns(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1000000000L + (b->tv_nsec - a->tv_nsec);
+}
+
+int ws2812_show(ws2812_t *s) {
+    struct timespec t0, t1;
+
+    if (s->fd < 0) {
+        // Без устройства: только кодирование
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        ws2812_encode(s->pixels, s->npixels * 3, s->spi[0]);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if ((unsigned long)elapsed_ns(&t0, &t1) > s->stats.encode_ns_max)
+            s->stats.encode_ns_max = elapsed_ns(&t0, &t1);
+        s->stats.frames++;
+        return 0;
+    }
+
+    // Кодируем в буфер, который не передаётся; под блокировкой, чтобы
+    // поток не взял его недописанным (кодирование — микросекунды)
+    pthread_mutex_lock(&s->lock);
+    int target = s->inflight == 0 ? 1 : 0;
+    if (s->pending == target)
+        s->stats.replaced++;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ws2812_encode(s->pixels, s->npixels * 3, s->spi[target]);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if ((unsigned long)elapsed_ns(&t0, &t1) > s->stats.encode_ns_max)
+        s->stats.encode_ns_max = elapsed_ns(&t0, &t1);
+    s->pending = target;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+}
+
+unsigned ws2812_frame_us(ws2812_t *s) {
+    return (unsigned)((unsigned long long)s->spi_len * 8 * 1000000 / WS2812_SPI_HZ);
+}
+
+void ws2812_get_stats(ws2812_t *s, ws2812_stats_t *st) {
+    if (s->fd < 0) {
+        *st = s->stats;
+        return;
+    }
+    pthread_mutex_lock(&s->lock);
+    *st = s->stats;
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void *ws2812_main(void *arg) {
+    ws2812_t *s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        // Перед выходом передаём последний кадр (например, погасить ленту)
+        while (s->pending < 0 && !s->quit)
+            pthread_cond_wait(&s->cond, &s->lock);
+        if (s->pending < 0)
+            break;
+        s->inflight = s->pending;
+        s->pending = -1;
+        pthread_mutex_unlock(&s->lock);
+
+        // Весь кадр — одно сообщение, одна передача
+        struct spi_ioc_transfer tr;
+        memset(&tr, 0, sizeof(tr));
+        tr.tx_buf = (uintptr_t)s->spi[s->inflight];
+        tr.len = s->spi_len;
+        tr.speed_hz = WS2812_SPI_HZ;
+        tr.bits_per_word = 8;
+        int res = ioctl(s->fd, SPI_IOC_MESSAGE(1), &tr);
+
+        pthread_mutex_lock(&s->lock);
+        s->inflight = -1;
+        if (res < 0)
+            s->stats.errors++;
+        else
+            s->stats.frames++;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
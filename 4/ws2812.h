@@ -0,0 +1,67 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Лента адресуемых светодиодов WS2812/WS2811 через SPI (MOSI — GPIO10,
+// /dev/spidev0.0). Бит данных WS2812 — три бита SPI на 2,4 МГц (по 417 нс):
+// 1 -> 110, 0 -> 100; байт цвета — три байта SPI. Кадр — все пиксели в
+// порядке G, R, B и нули в конце: низкий уровень дольше 300 мкс защёлкивает
+// цвета (WS2812B новых партий ждут 280 мкс).
+//
+// Кодирование — по таблице: в байте SPI 0 участвуют биты 7..5 исходного
+// байта, в байте 1 — биты 4..3, в байте 2 — биты 2..0, так что три таблицы
+// по 8 элементов дают все три байта. На ARM с NEON 16 (AArch64) или 8
+// (ARMv7) байтов кодируются разом: три табличных выборки и чередующая
+// запись vst3; без NEON — таблица на 256 байтов.
+//
+// Кадры двойной буферизации: ws2812_show кодирует пиксели в свободный буфер
+// SPI и отдаёт его потоку передачи; пока передаётся один кадр, следующий
+// уже можно рисовать и кодировать. Передача — одна SPI_IOC_MESSAGE на
+// кадр; если поток ещё занят, непереданный кадр заменяется новым.
+//
+// Буфер spidev по умолчанию 4096 байтов (примерно 440 пикселей); для
+// длинных лент в /boot/cmdline.txt нужен spidev.bufsiz=65536.
+
+#define WS2812_SPI_DEFAULT "/dev/spidev0.0"
+#define WS2812_SPI_HZ 2400000
+#define WS2812_RESET_BYTES 96 // 320 мкс нулей на 2,4 МГц
+#define WS2812_MAX_PIXELS 5000
+
+typedef struct {
+    unsigned long frames;   // Кадров передано
+    unsigned long replaced; // Кадров, заменённых новым до передачи
+    unsigned long errors;   // Ошибок ioctl
+    unsigned long encode_ns_max; // Наибольшее время кодирования кадра
+} ws2812_stats_t;
+
+typedef struct ws2812 ws2812_t;
+
+// Открывает spidev (dev NULL — WS2812_SPI_DEFAULT, "" — без устройства:
+// только кодирование, для замеров). NULL — ошибка (errno).
+ws2812_t *ws2812_open(const char *dev, unsigned npixels);
+// Дожидается передачи последнего кадра и закрывает устройство
+void ws2812_close(ws2812_t *s);
+
+unsigned ws2812_pixels(ws2812_t *s);
+// Задний буфер: npixels * 3 байтов G, R, B. Рисовать можно, пока
+// передаётся предыдущий кадр.
+uint8_t *ws2812_buffer(ws2812_t *s);
+void ws2812_set(ws2812_t *s, unsigned pixel, uint8_t r, uint8_t g, uint8_t b);
+void ws2812_fill(ws2812_t *s, uint8_t r, uint8_t g, uint8_t b);
+// Кодирует задний буфер и ставит кадр в передачу; не ждёт её. 0 — успех.
+int ws2812_show(ws2812_t *s);
+// Время передачи кадра по SPI вместе с паузой защёлкивания, мкс
+unsigned ws2812_frame_us(ws2812_t *s);
+
+void ws2812_get_stats(ws2812_t *s, ws2812_stats_t *st);
+
+// Кодирование n байтов в 3 * n байтов SPI: лучшее доступное и по таблице
+// на 256 байтов (для сравнения в замере)
+void ws2812_encode(const uint8_t *in, size_t n, uint8_t *out);
+void ws2812_encode_lut(const uint8_t *in, size_t n, uint8_t *out);
+// Имя используемого кодирования: "neon" или "lut"
+const char *ws2812_encoder(void);
+
+#endif // WS2812_H
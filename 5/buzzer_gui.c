@@ -1,10 +1,17 @@
 #include <gtk/gtk.h>    // Включаем заголовочный файл для библиотеки GTK+ (для создания графического интерфейса пользователя)
 #include <gpiod.h>    // Включаем заголовочный файл для библиотеки libgpiod (для работы с GPIO на Linux-системах)
-#include <unistd.h>     // Включаем заголовочный файл для стандартных функций Unix, таких как usleep (задержки в микросекундах)
+#include "melody_player.h" // Проигрыватель мелодий: играет ноты по расписанию в отдельном потоке
+#include "melody_lib.h"    // Библиотека мелодий: RTTTL и скомпилированные файлы *.mel
+#ifdef USE_PIGPIO
+#include <pigpio.h>         // Волны pigpio для пассивного зуммера (сборка с make PIGPIO=1)
+#include "tone_engine.h"
+#endif
 
 // --- Константы для настройки GPIO ---
 #define CHIP_NAME "gpiochip0" // Имя GPIO-чипа, который мы будем использовать. На Raspberry Pi это обычно "gpiochip0".
 #define BUZZER_LINE 17        // Номер линии GPIO (пина), к которой подключен активный зуммер. Здесь это GPIO17.
+#define MELODY_DIR "melodies" // Каталог с мелодиями по умолчанию (можно передать другой первым аргументом).
+#define PASSIVE_LINE 18       // GPIO пассивного зуммера в режиме --passive.
 
 // --- Глобальные переменные для работы с gpiod ---
 // Эти переменные объявлены как static, чтобы они были доступны только в этом файле
@@ -13,7 +20,20 @@ static struct gpiod_chip *chip; // Указатель на структуру, 
 static struct gpiod_line *line; // Указатель на структуру, представляющую конкретную линию GPIO (пин).
 
 // --- Глобальная переменная для хранения выбранной мелодии ---
-static int selected_melody = 1; // Хранит номер мелодии, выбранной пользователем через радиокнопки. По умолчанию выбрана Мелодия 1.
+static int selected_melody = 0; // Хранит индекс мелодии в библиотеке, выбранной пользователем через радиокнопки. По умолчанию выбрана первая.
+
+// --- Проигрыватель и виджеты, показывающие ход воспроизведения ---
+static melody_player_t *player;     // Поток, который играет мелодии по расписанию
+static GtkWidget *progress_bar;      // Прогресс текущей мелодии
+static GtkWidget *status_label;      // Какая мелодия играет
+#ifdef USE_PIGPIO
+static tone_engine_t *tone;          // Тоны пассивного зуммера (--passive); NULL — активный зуммер
+#endif
+
+// --- Мелодии ---
+// Загружаются при запуске из каталога MELODY_DIR (см. melody_lib.h).
+// Каждая мелодия — список нот {частота, длительность в мс}. Частота 0 — пауза.
+static melody_lib_t library;
 
 // --- Функции управления зуммером ---
 
@@ -36,41 +56,97 @@ void buzzer_off() {
 }
 
 /**
- * @brief Воспроизводит одну из трех предопределенных мелодий на зуммере.
- * @param melody Номер мелодии для воспроизведения (1, 2 или 3).
+ * @brief Выход проигрывателя: включает или выключает зуммер.
+ * Вызывается из потока проигрывателя в момент смены ноты.
+ * @param ctx Не используется.
+ * @param freq_hz Частота ноты; 0 — тишина.
+ */
+static void buzzer_output(void *ctx, unsigned freq_hz) {
+    gpiod_line_set_value(line, freq_hz ? 1 : 0);
+}
+
+#ifdef USE_PIGPIO
+/**
+ * @brief Выход проигрывателя в режиме --passive: ничего не делает,
+ * потому что звук выдаёт DMA (см. on_player_progress).
  */
-void play_melody(int melody) {
-    // Используем оператор switch для выбора нужного паттерна мелодии.
-    switch (melody) {
-        case 1: // Мелодия 1: Два писка разной длины
-            buzzer_on();    // Зуммер ВКЛ
-            usleep(200000); // Задержка 200 миллисекунд (200,000 микросекунд)
-            buzzer_off();   // Зуммер ВЫКЛ
-            usleep(100000); // Пауза 100 миллисекунд
-            buzzer_on();    // Зуммер ВКЛ
-            usleep(300000); // Задержка 300 миллисекунд
-            buzzer_off();   // Зуммер ВЫКЛ
-            break;          // Выход из switch
-        case 2: // Мелодия 2: Четыре коротких, равномерных писка
-            for (int i = 0; i < 4; ++i) { // Повторяем 4 раза
-                buzzer_on();    // Зуммер ВКЛ
-                usleep(150000); // Задержка 150 миллисекунд
-                buzzer_off();   // Зуммер ВЫКЛ
-                usleep(150000); // Пауза 150 миллисекунд
-            }
-            break;          // Выход из switch
-        case 3: // Мелодия 3: Два длинных писка
-            buzzer_on();    // Зуммер ВКЛ
-            usleep(500000); // Задержка 500 миллисекунд
-            buzzer_off();   // Зуммер ВЫКЛ
-            usleep(100000); // Пауза 100 миллисекунд
-            buzzer_on();    // Зуммер ВКЛ
-            usleep(500000); // Задержка 500 миллисекунд
-            buzzer_off();   // Зуммер ВЫКЛ
-            break;          // Выход из switch
-        default: // Если передан неизвестный номер мелодии, ничего не делаем.
+static void passive_output(void *ctx, unsigned freq_hz) {
+}
+#endif
+
+// Ход воспроизведения, который поток проигрывателя передаёт в GUI-поток
+struct play_progress {
+    int id;     // Номер мелодии
+    int event;  // MELODY_EV_*
+    int note;   // Номер текущей ноты
+    int count;  // Всего нот
+};
+
+/**
+ * @brief Обновляет прогресс и метку статуса в главном цикле GTK.
+ * @param data Указатель на struct play_progress (освобождается здесь).
+ * @return G_SOURCE_REMOVE, чтобы функция выполнилась один раз.
+ */
+static gboolean update_progress(gpointer data) {
+    struct play_progress *pr = data;
+    char text[MELODY_NAME_MAX + 32];
+
+    switch (pr->event) {
+        case MELODY_EV_START:
+        case MELODY_EV_NOTE:
+            snprintf(text, sizeof(text), "Играет: %s", library.items[pr->id].name);
+            gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progress_bar),
+                                          pr->count ? (double)pr->note / pr->count : 0);
+            break;
+        case MELODY_EV_DONE:
+            snprintf(text, sizeof(text), "Доиграна: %s", library.items[pr->id].name);
+            gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progress_bar), 1.0);
+            break;
+        default:
+            snprintf(text, sizeof(text), "Остановлена: %s", library.items[pr->id].name);
+            gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progress_bar), 0.0);
             break;
     }
+    gtk_label_set_text(GTK_LABEL(status_label), text);
+
+    g_free(pr);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Обратный вызов проигрывателя о ходе воспроизведения.
+ * Выполняется в потоке проигрывателя, поэтому только копирует данные
+ * и передаёт их в главный цикл GTK.
+ */
+static void on_player_progress(void *user_data, int id, int event, int note, int count) {
+#ifdef USE_PIGPIO
+    // Пассивный зуммер: мелодию целиком играет DMA, а проигрыватель только
+    // ведёт расписание для прогресса и очереди.
+    if (tone && event == MELODY_EV_START)
+        tone_engine_play(tone, library.items[id].notes, library.items[id].count);
+    else if (tone && event == MELODY_EV_STOP)
+        tone_engine_stop(tone);
+#endif
+    struct play_progress *pr = g_new(struct play_progress, 1);
+    pr->id = id;
+    pr->event = event;
+    pr->note = note;
+    pr->count = count;
+    g_idle_add(update_progress, pr);
+}
+
+/**
+ * @brief Передаёт выбранную мелодию проигрывателю. Не блокирует GUI:
+ * мелодия играет в отдельном потоке.
+ * @param melody Индекс мелодии в библиотеке.
+ * @param mode MELODY_REPLACE — прервать текущую, MELODY_QUEUE — сыграть после неё.
+ */
+void play_melody(int melody, int mode) {
+    if (melody < 0 || melody >= library.count) // Если передан неизвестный номер мелодии, ничего не делаем.
+        return;
+    if (melody_player_play(player, library.items[melody].notes, library.items[melody].count,
+                           melody, mode) != 0)
+        gtk_label_set_text(GTK_LABEL(status_label), "Очередь мелодий заполнена");
 }
 
 // --- Функции обратного вызова для GUI (GTK+) ---
@@ -78,13 +154,13 @@ void play_melody(int melody) {
 /**
  * @brief Функция обратного вызова, вызываемая при переключении состояния радиокнопки.
  * @param button Указатель на GtkToggleButton, который вызвал событие.
- * @param user_data Пользовательские данные, переданные при подключении сигнала (здесь - номер мелодии).
+ * @param user_data Пользовательские данные, переданные при подключении сигнала (здесь - индекс мелодии).
  */
 void on_melody_selected(GtkToggleButton *button, gpointer user_data) {
     // Проверяем, активна ли (выбрана) текущая радиокнопка.
     if (gtk_toggle_button_get_active(button)) {
         // Если кнопка активна, обновляем глобальную переменную selected_melody
-        // значением, которое было передано как user_data (номер мелодии).
+        // значением, которое было передано как user_data (индекс мелодии).
         selected_melody = GPOINTER_TO_INT(user_data);
     }
 }
@@ -96,7 +172,26 @@ void on_melody_selected(GtkToggleButton *button, gpointer user_data) {
  */
 void on_play_clicked(GtkButton *button, gpointer user_data) {
     // Вызываем функцию play_melody с номером мелодии, который хранится в selected_melody.
-    play_melody(selected_melody);
+    // Уже играющая мелодия прерывается, поэтому повторные нажатия не копятся.
+    play_melody(selected_melody, MELODY_REPLACE);
+}
+
+/**
+ * @brief Функция обратного вызова кнопки "В очередь": мелодия сыграет после текущей.
+ * @param button Указатель на GtkButton, который вызвал событие.
+ * @param user_data Не используется (NULL).
+ */
+void on_queue_clicked(GtkButton *button, gpointer user_data) {
+    play_melody(selected_melody, MELODY_QUEUE);
+}
+
+/**
+ * @brief Функция обратного вызова кнопки "Стоп": прерывает мелодию и очищает очередь.
+ * @param button Указатель на GtkButton, который вызвал событие.
+ * @param user_data Не используется (NULL).
+ */
+void on_stop_clicked(GtkButton *button, gpointer user_data) {
+    melody_player_stop(player);
 }
 
 /**
@@ -106,6 +201,17 @@ void on_play_clicked(GtkButton *button, gpointer user_data) {
  * @param data Не используется в данной функции (NULL).
  */
 void on_destroy(GtkWidget *widget, gpointer data) {
+    // Останавливаем поток проигрывателя до освобождения линии: он пишет в неё.
+    // Статистика опоздания фронтов нот выводится в терминал.
+    melody_player_print_jitter(player, stdout);
+    melody_player_free(player);
+#ifdef USE_PIGPIO
+    if (tone) { // Проигрыватель остановлен, волны больше никто не запустит.
+        tone_engine_free(tone);
+        gpioTerminate();
+    }
+#endif
+    melody_lib_free(&library); // Ноты больше никто не читает: можно снять отображения файлов.
     buzzer_off();             // Убеждаемся, что зуммер выключен при завершении работы.
     gpiod_line_release(line); // Освобождаем запрошенную линию GPIO.
                               // Это очень важно, чтобы другие программы могли использовать этот пин.
@@ -119,13 +225,29 @@ void on_destroy(GtkWidget *widget, gpointer data) {
  * @brief Точка входа в программу. Инициализирует GTK+ и libgpiod,
  * создает графический интерфейс и запускает основной цикл обработки событий.
  * @param argc Количество аргументов командной строки.
- * @param argv Массив строк аргументов командной строки.
+ * @param argv Массив строк аргументов командной строки: каталог с мелодиями
+ *             и --passive (пассивный зуммер на PASSIVE_LINE через pigpio).
  * @return Код завершения программы (0 при успешном выполнении, 1 при ошибке).
  */
 int main(int argc, char *argv[]) {
     // Инициализация библиотеки GTK+. Должна быть вызвана первой для любых GTK-приложений.
     gtk_init(&argc, &argv);
 
+    // --- Разбор аргументов ---
+    const char *melody_dir = MELODY_DIR;
+    int passive = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--passive") == 0)
+            passive = 1;
+        else
+            melody_dir = argv[i];
+    }
+
+    // --- Загрузка библиотеки мелодий ---
+    // Файлы *.mel отображаются в память без разбора, *.rtttl разбираются при загрузке.
+    if (melody_lib_load(&library, melody_dir) < 0)
+        g_printerr("Failed to open melody directory %s\n", melody_dir);
+
     // --- Инициализация libgpiod ---
     // Открываем GPIO-чип по его имени (например, "gpiochip0" на Raspberry Pi).
     chip = gpiod_chip_open_by_name(CHIP_NAME);
@@ -146,6 +268,38 @@ int main(int argc, char *argv[]) {
         return 1; // Завершаем программу с кодом ошибки.
     }
 
+    // --- Пассивный зуммер ---
+    // Меандр нужной частоты и ритм выдаёт DMA через волны pigpio. pigpio
+    // требует root и не работает одновременно с демоном pigpiod.
+    melody_output_fn output = buzzer_output;
+    if (passive) {
+#ifdef USE_PIGPIO
+        if (gpioInitialise() < 0 || !(tone = tone_engine_new(PASSIVE_LINE))) {
+            g_printerr("Failed to initialise pigpio for passive buzzer\n");
+            gpiod_line_release(line);
+            gpiod_chip_close(chip);
+            return 1;
+        }
+        output = passive_output;
+#else
+        g_printerr("Built without pigpio: rebuild with 'make PIGPIO=1' for --passive\n");
+        gpiod_line_release(line);
+        gpiod_chip_close(chip);
+        return 1;
+#endif
+    }
+
+    // --- Запуск проигрывателя мелодий ---
+    // Поток проигрывателя выставляет уровни на линии по абсолютному расписанию,
+    // а о ходе воспроизведения сообщает через on_player_progress.
+    player = melody_player_new(output, NULL, on_player_progress, NULL);
+    if (!player) {
+        g_printerr("Failed to start melody player\n");
+        gpiod_line_release(line);
+        gpiod_chip_close(chip);
+        return 1;
+    }
+
     // --- Создание главного окна GTK+ ---
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL); // Создаем новое окно верхнего уровня.
     gtk_window_set_title(GTK_WINDOW(window), "Buzzer Melody"); // Устанавливаем заголовок окна.
@@ -157,19 +311,20 @@ int main(int argc, char *argv[]) {
     gtk_container_add(GTK_CONTAINER(window), vbox); // Добавляем этот контейнер в главное окно.
 
     // --- Создание радиокнопок для выбора мелодий ---
-    // Создаем первую радиокнопку "Мелодия 1". NULL в первом аргументе означает, что это начало новой группы радиокнопок.
-    GtkWidget *rb1 = gtk_radio_button_new_with_label(NULL, "Мелодия 1");
-    // Создаем вторую радиокнопку "Мелодия 2" и связываем ее с rb1, чтобы они были в одной группе.
-    GtkWidget *rb2 = gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(rb1), "Мелодия 2");
-    // Создаем третью радиокнопку "Мелодия 3" и также связываем ее с rb1.
-    GtkWidget *rb3 = gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(rb1), "Мелодия 3");
-
-    // Подключаем сигнал "toggled" (переключение состояния) каждой радиокнопки к функции on_melody_selected.
-    // GINT_TO_POINTER(X) преобразует целое число X в указатель, который передается как user_data.
-    // Это позволяет on_melody_selected узнать, какая мелодия была выбрана.
-    g_signal_connect(rb1, "toggled", G_CALLBACK(on_melody_selected), GINT_TO_POINTER(1));
-    g_signal_connect(rb2, "toggled", G_CALLBACK(on_melody_selected), GINT_TO_POINTER(2));
-    g_signal_connect(rb3, "toggled", G_CALLBACK(on_melody_selected), GINT_TO_POINTER(3));
+    // По одной радиокнопке на мелодию библиотеки, все в одной группе с первой.
+    // GINT_TO_POINTER(i) передаёт индекс мелодии в on_melody_selected как user_data.
+    GtkWidget *first_rb = NULL;
+    for (int i = 0; i < library.count; i++) {
+        GtkWidget *rb = first_rb
+            ? gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(first_rb), library.items[i].name)
+            : gtk_radio_button_new_with_label(NULL, library.items[i].name);
+        if (!first_rb)
+            first_rb = rb;
+        g_signal_connect(rb, "toggled", G_CALLBACK(on_melody_selected), GINT_TO_POINTER(i));
+        gtk_box_pack_start(GTK_BOX(vbox), rb, FALSE, FALSE, 5);
+    }
+    if (!first_rb) // Каталог пуст или не найден — подсказываем, где искать мелодии.
+        gtk_box_pack_start(GTK_BOX(vbox), gtk_label_new("Мелодии не найдены"), FALSE, FALSE, 5);
 
     // --- Создание кнопки "Проиграть" ---
     GtkWidget *play_btn = gtk_button_new_with_label("Проиграть"); // Создаем кнопку с меткой "Проиграть".
@@ -177,14 +332,29 @@ int main(int argc, char *argv[]) {
     // NULL в user_data означает, что никакие специфичные данные не передаются.
     g_signal_connect(play_btn, "clicked", G_CALLBACK(on_play_clicked), NULL);
 
+    // --- Кнопки "В очередь" и "Стоп" ---
+    GtkWidget *queue_btn = gtk_button_new_with_label("В очередь");
+    g_signal_connect(queue_btn, "clicked", G_CALLBACK(on_queue_clicked), NULL);
+    GtkWidget *stop_btn = gtk_button_new_with_label("Стоп");
+    g_signal_connect(stop_btn, "clicked", G_CALLBACK(on_stop_clicked), NULL);
+
+    // Горизонтальный контейнер для кнопок управления
+    GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_box_pack_start(GTK_BOX(button_box), play_btn, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(button_box), queue_btn, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(button_box), stop_btn, TRUE, TRUE, 0);
+
+    // --- Прогресс и статус воспроизведения ---
+    progress_bar = gtk_progress_bar_new();
+    status_label = gtk_label_new("Выберите мелодию");
+
     // --- Упаковка виджетов в вертикальный контейнер ---
-    // gtk_box_pack_start добавляет виджет в начало контейнера.
+    // gtk_box_pack_start добавляет виджет в конец ряда (радиокнопки уже добавлены выше).
     // FALSE, FALSE - не расширять виджет, не занимать лишнее пространство.
     // 5 или 10 - дополнительный отступ в пикселях.
-    gtk_box_pack_start(GTK_BOX(vbox), rb1, FALSE, FALSE, 5);
-    gtk_box_pack_start(GTK_BOX(vbox), rb2, FALSE, FALSE, 5);
-    gtk_box_pack_start(GTK_BOX(vbox), rb3, FALSE, FALSE, 5);
-    gtk_box_pack_start(GTK_BOX(vbox), play_btn, FALSE, FALSE, 10);
+    gtk_box_pack_start(GTK_BOX(vbox), button_box, FALSE, FALSE, 10);
+    gtk_box_pack_start(GTK_BOX(vbox), progress_bar, FALSE, FALSE, 5);
+    gtk_box_pack_start(GTK_BOX(vbox), status_label, FALSE, FALSE, 5);
 
     // --- Подключение функции для обработки закрытия окна ---
     // Подключаем сигнал "destroy" (когда окно закрывается) к функции on_destroy.
@@ -0,0 +1,353 @@
+#include "melody_lib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Нот в одной мелодии RTTTL, больше не разбираем
+#define MELODY_MAX_NOTES 1024
+
+static const char mel_magic[4] = {'M', 'E', 'L', '1'};
+
+// Заголовок записи *.mel, за ним имя и ноты
+struct mel_header {
+    char magic[4];
+    uint16_t count;
+    uint8_t name_len;
+    uint8_t reserved;
+};
+
+// Отображённый в память файл *.mel
+struct melody_map {
+    struct melody_map *next;
+    void *addr;
+    size_t len;
+};
+
+// Частоты нот 4-й октавы в сотых долях герца, от C до B.
+// Другие октавы получаются сдвигом: октава выше — частота вдвое больше.
+static const uint32_t octave4_centihz[12] = {
+    26163, 27718, 29366, 31113, 32963, 34923, 36999, 39200, 41530, 44000, 46616, 49388,
+};
+
+// Полутон от C для букв a..h (h — немецкое обозначение си)
+static const int8_t letter_semitone[8] = {9, 11, 0, 2, 4, 5, 7, 11};
+
+static unsigned note_freq(int semitone, int octave) {
+    uint32_t f = octave4_centihz[semitone];
+    if (octave >= 4)
+        f <<= octave - 4;
+    else
+        f >>= 4 - octave;
+    return (f + 50) / 100;
+}
+
+static const char *skip_spaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+static const char *parse_uint(const char *p, const char *end, int *value) {
+    int v = 0;
+    const char *start = p;
+    while (p < end && *p >= '0' && *p <= '9' && v < 100000)
+        v = v * 10 + (*p++ - '0');
+    if (p == start)
+        return NULL;
+    *value = v;
+    return p;
+}
+
+static int valid_duration(int d) {
+    return d == 1 || d == 2 || d == 4 || d == 8 || d == 16 || d == 32;
+}
+
+int rtttl_parse(const char *text, size_t len, char name[MELODY_NAME_MAX],
+                melody_note_t *notes, int max_notes) {
+    const char *p = text, *end = text + len;
+    int def_dur = 4, def_oct = 6, bpm = 63;
+
+    // Имя
+    const char *colon = memchr(p, ':', len);
+    if (!colon)
+        return -1;
+    p = skip_spaces(p, colon);
+    size_t name_len = colon - p;
+    while (name_len > 0 && (p[name_len - 1] == ' ' || p[name_len - 1] == '\t'))
+        name_len--;
+    if (name_len >= MELODY_NAME_MAX)
+        name_len = MELODY_NAME_MAX - 1;
+    memcpy(name, p, name_len);
+    name[name_len] = '\0';
+    p = colon + 1;
+
+    // Значения по умолчанию: d=, o=, b=
+    colon = memchr(p, ':', end - p);
+    if (!colon)
+        return -1;
+    while (p < colon) {
+        int value;
+        p = skip_spaces(p, colon);
+        if (p == colon)
+            break;
+        char key = *p++;
+        p = skip_spaces(p, colon);
+        if (p == colon || *p++ != '=')
+            return -1;
+        p = skip_spaces(p, colon);
+        if (!(p = parse_uint(p, colon, &value)))
+            return -1;
+        if (key == 'd' || key == 'D')
+            def_dur = value;
+        else if (key == 'o' || key == 'O')
+            def_oct = value;
+        else if (key == 'b' || key == 'B')
+            bpm = value;
+        else
+            return -1;
+        p = skip_spaces(p, colon);
+        if (p < colon && *p++ != ',')
+            return -1;
+    }
+    if (!valid_duration(def_dur) || def_oct < 3 || def_oct > 8 || bpm <= 0)
+        return -1;
+    p = colon + 1;
+
+    // Ноты: [длительность]буква[#][.][октава][.]
+    unsigned whole_ms = 4 * 60000 / bpm;
+    int n = 0;
+    while (p < end) {
+        int dur = def_dur, oct = def_oct, dotted = 0, semitone = -1;
+        const char *q;
+
+        p = skip_spaces(p, end);
+        if (p == end)
+            break;
+        if ((q = parse_uint(p, end, &dur)))
+            p = q;
+        if (p == end || !valid_duration(dur))
+            return -1;
+
+        char c = *p++ | 0x20; // в нижний регистр
+        if (c >= 'a' && c <= 'h')
+            semitone = letter_semitone[c - 'a'];
+        else if (c != 'p')
+            return -1;
+        if (p < end && *p == '#') {
+            if (semitone < 0)
+                return -1;
+            semitone++;
+            p++;
+        }
+        if (p < end && *p == '.') {
+            dotted = 1;
+            p++;
+        }
+        if ((q = parse_uint(p, end, &oct)))
+            p = q;
+        if (p < end && *p == '.') {
+            dotted = 1;
+            p++;
+        }
+        if (oct < 3 || oct > 8)
+            return -1;
+        p = skip_spaces(p, end);
+        if (p < end && *p++ != ',')
+            return -1;
+
+        if (n == max_notes)
+            return -1;
+        unsigned ms = whole_ms / dur;
+        if (dotted)
+            ms += ms / 2;
+        if (semitone == 12) { // b# — это c следующей октавы
+            semitone = 0;
+            oct++;
+        }
+        notes[n].freq_hz = semitone < 0 ? 0 : note_freq(semitone, oct);
+        notes[n].duration_ms = ms > 0xFFFF ? 0xFFFF : ms;
+        n++;
+    }
+    return n;
+}
+
+static size_t align4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+size_t melody_record_size(const char *name, int count) {
+    size_t name_len = strnlen(name, MELODY_NAME_MAX - 1);
+    return sizeof(struct mel_header) + align4(name_len) + count * sizeof(melody_note_t);
+}
+
+size_t melody_record_write(void *buf, const char *name, const melody_note_t *notes, int count) {
+    struct mel_header h;
+    size_t name_len = strnlen(name, MELODY_NAME_MAX - 1);
+    uint8_t *out = buf;
+
+    memcpy(h.magic, mel_magic, sizeof(h.magic));
+    h.count = count;
+    h.name_len = name_len;
+    h.reserved = 0;
+    memcpy(out, &h, sizeof(h));
+    out += sizeof(h);
+    memset(out, 0, align4(name_len));
+    memcpy(out, name, name_len);
+    out += align4(name_len);
+    memcpy(out, notes, count * sizeof(melody_note_t));
+    return melody_record_size(name, count);
+}
+
+// Добавляет мелодию в библиотеку (ноты не копируются)
+static int lib_append(melody_lib_t *lib, const char *name, size_t name_len,
+                      const melody_note_t *notes, int count) {
+    if (lib->count == lib->capacity) {
+        int cap = lib->capacity ? lib->capacity * 2 : 16;
+        melody_t *items = realloc(lib->items, cap * sizeof(*items));
+        if (!items)
+            return -1;
+        lib->items = items;
+        lib->capacity = cap;
+    }
+    melody_t *m = &lib->items[lib->count++];
+    if (name_len >= MELODY_NAME_MAX)
+        name_len = MELODY_NAME_MAX - 1;
+    memcpy(m->name, name, name_len);
+    m->name[name_len] = '\0';
+    m->notes = notes;
+    m->count = count;
+    return 0;
+}
+
+int melody_lib_add_rtttl(melody_lib_t *lib, const char *text, size_t len) {
+    melody_note_t notes[MELODY_MAX_NOTES];
+    char name[MELODY_NAME_MAX];
+    const char *p = text, *end = text + len;
+    int added = 0;
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        const char *s = skip_spaces(p, eol);
+
+        if (s < eol && *s != '#') {
+            int n = rtttl_parse(s, eol - s, name, notes, MELODY_MAX_NOTES);
+            if (n <= 0) {
+                fprintf(stderr, "Bad RTTTL melody: %.*s\n", (int)(eol - s), s);
+            } else {
+                melody_note_t *copy = malloc(n * sizeof(*copy));
+                melody_note_t **owned = realloc(lib->owned, (lib->nowned + 1) * sizeof(*owned));
+                if (!copy || !owned) {
+                    free(copy);
+                    if (owned)
+                        lib->owned = owned;
+                    return -1;
+                }
+                lib->owned = owned;
+                memcpy(copy, notes, n * sizeof(*copy));
+                lib->owned[lib->nowned++] = copy;
+                if (lib_append(lib, name, strlen(name), copy, n) < 0)
+                    return -1;
+                added++;
+            }
+        }
+        p = eol + 1;
+    }
+    return added;
+}
+
+int melody_lib_add_compiled(melody_lib_t *lib, const void *data, size_t len) {
+    const uint8_t *p = data, *end = p + len;
+    int added = 0;
+
+    while ((size_t)(end - p) >= sizeof(struct mel_header)) {
+        struct mel_header h;
+        memcpy(&h, p, sizeof(h));
+        if (memcmp(h.magic, mel_magic, sizeof(h.magic)) != 0)
+            return -1;
+        size_t size = sizeof(h) + align4(h.name_len) + h.count * sizeof(melody_note_t);
+        if (size > (size_t)(end - p))
+            return -1;
+        if (lib_append(lib, (const char *)p + sizeof(h), h.name_len,
+                       (const melody_note_t *)(p + sizeof(h) + align4(h.name_len)), h.count) < 0)
+            return -1;
+        p += size;
+        added++;
+    }
+    return added;
+}
+
+static int melody_file_filter(const struct dirent *d) {
+    const char *ext = strrchr(d->d_name, '.');
+    return ext && (strcmp(ext, ".mel") == 0 || strcmp(ext, ".rtttl") == 0 ||
+                   strcmp(ext, ".txt") == 0);
+}
+
+int melody_lib_load(melody_lib_t *lib, const char *dir) {
+    struct dirent **list;
+    char path[512];
+
+    int nfiles = scandir(dir, &list, melody_file_filter, alphasort);
+    if (nfiles < 0)
+        return -1;
+
+    for (int i = 0; i < nfiles; i++) {
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, list[i]->d_name);
+        int fd = open(path, O_RDONLY);
+        if (fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0) {
+            if (fd >= 0)
+                close(fd);
+            free(list[i]);
+            continue;
+        }
+        void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            perror(path);
+            free(list[i]);
+            continue;
+        }
+
+        if (strcmp(strrchr(list[i]->d_name, '.'), ".mel") == 0) {
+            // Ноты остаются в отображении файла, поэтому держим его до free
+            struct melody_map *map = malloc(sizeof(*map));
+            if (!map || melody_lib_add_compiled(lib, addr, st.st_size) < 0)
+                fprintf(stderr, "Bad compiled melody file: %s\n", path);
+            if (map) {
+                map->addr = addr;
+                map->len = st.st_size;
+                map->next = lib->maps;
+                lib->maps = map;
+            } else {
+                munmap(addr, st.st_size);
+            }
+        } else {
+            melody_lib_add_rtttl(lib, addr, st.st_size);
+            munmap(addr, st.st_size);
+        }
+        free(list[i]);
+    }
+    free(list);
+    return lib->count;
+}
+
+void melody_lib_free(melody_lib_t *lib) {
+    while (lib->maps) {
+        struct melody_map *next = lib->maps->next;
+        munmap(lib->maps->addr, lib->maps->len);
+        free(lib->maps);
+        lib->maps = next;
+    }
+    for (int i = 0; i < lib->nowned; i++)
+        free(lib->owned[i]);
+    free(lib->owned);
+    free(lib->items);
+    memset(lib, 0, sizeof(*lib));
+}
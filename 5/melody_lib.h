@@ -0,0 +1,63 @@
+#ifndef MELODY_LIB_H
+#define MELODY_LIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "melody_player.h"
+
+// ===== RTTTL =====
+// Формат мелодий мобильных телефонов: "имя:d=4,o=6,b=63:8c,16p,c.6,a#5".
+// Длительность ноты — доля целой (1..32), точка удлиняет в 1,5 раза,
+// p — пауза. Целая нота длится 4 удара при темпе b ударов в минуту.
+
+#define MELODY_NAME_MAX 64
+
+// Разбирает одну мелодию RTTTL из text (len байт, без перевода строки).
+// Имя копируется в name, ноты — в notes (не больше max_notes).
+// Возвращает число нот или -1 при ошибке разбора.
+int rtttl_parse(const char *text, size_t len, char name[MELODY_NAME_MAX],
+                melody_note_t *notes, int max_notes);
+
+// ===== Скомпилированные мелодии (*.mel) =====
+// Последовательность записей, каждая выровнена на 4 байта:
+//   "MEL1", uint16 count, uint8 name_len, uint8 0, имя (дополнено до 4),
+//   count нот melody_note_t {uint16 freq_hz, uint16 duration_ms}.
+// Числа — в порядке байтов процессора (little-endian на Raspberry Pi).
+// Ноты из отображённого в память файла используются без копирования.
+
+// Размер записи для мелодии с таким именем и числом нот
+size_t melody_record_size(const char *name, int count);
+// Записывает запись в buf (не меньше melody_record_size байт).
+// Возвращает размер записи.
+size_t melody_record_write(void *buf, const char *name, const melody_note_t *notes, int count);
+
+// ===== Библиотека мелодий =====
+
+typedef struct {
+    char name[MELODY_NAME_MAX];
+    const melody_note_t *notes;
+    int count;
+} melody_t;
+
+typedef struct {
+    melody_t *items;
+    int count;
+    int capacity;
+    // Отображения файлов *.mel и ноты, разобранные из RTTTL
+    struct melody_map *maps;
+    melody_note_t **owned;
+    int nowned;
+} melody_lib_t;
+
+// Загружает все мелодии каталога в порядке имён файлов: *.mel через mmap
+// без копирования, *.rtttl и *.txt — по строке RTTTL на мелодию
+// (пустые строки и строки с '#' пропускаются). Возвращает число мелодий
+// или -1, если каталог не открылся.
+int melody_lib_load(melody_lib_t *lib, const char *dir);
+// Разбирает текст RTTTL (несколько строк) и добавляет мелодии в библиотеку
+int melody_lib_add_rtttl(melody_lib_t *lib, const char *text, size_t len);
+// Добавляет записи *.mel из буфера; буфер должен жить дольше библиотеки
+int melody_lib_add_compiled(melody_lib_t *lib, const void *data, size_t len);
+void melody_lib_free(melody_lib_t *lib);
+
+#endif // MELODY_LIB_H
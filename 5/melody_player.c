@@ -0,0 +1,276 @@
+#include "melody_player.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// Сон до срока дробится на куски не длиннее 10 мс, чтобы остановка и
+// замена мелодии срабатывали быстро. Сам срок абсолютный, поэтому
+// дробление не сдвигает фронты.
+#define MELODY_SLICE_NS 10000000L
+
+// Приоритет потока проигрывателя, если система разрешает SCHED_FIFO
+#define MELODY_RT_PRIORITY 50
+
+struct melody {
+    int id;
+    int n;
+    melody_note_t notes[];
+};
+
+struct melody_player {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // Очередь мелодий (кольцевой буфер), защищена lock
+    struct melody *queue[MELODY_QUEUE_MAX];
+    int qhead, qlen;
+    int quit;
+    // Прервать текущую мелодию (stop или replace)
+    atomic_int interrupt;
+
+    melody_output_fn out;
+    void *out_ctx;
+    melody_progress_fn progress;
+    void *user_data;
+
+    melody_jitter_t jitter; // защищена lock
+};
+
+static void player_clear_queue(melody_player_t *p);
+static void *player_main(void *arg);
+
+melody_player_t *melody_player_new(melody_output_fn out, void *out_ctx,
+                                   melody_progress_fn progress, void *user_data) {
+    melody_player_t *p = calloc(1, sizeof(*p));
+    if (!p)
+        return NULL;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    atomic_init(&p->interrupt, 0);
+    p->out = out;
+    p->out_ctx = out_ctx;
+    p->progress = progress;
+    p->user_data = user_data;
+
+    if (pthread_create(&p->thread, NULL, player_main, p) != 0) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+void melody_player_free(melody_player_t *p) {
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    atomic_store(&p->interrupt, 1);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    player_clear_queue(p);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
+
+// Очищает очередь; вызывается под lock
+static void player_clear_queue(melody_player_t *p) {
+    while (p->qlen > 0) {
+        free(p->queue[p->qhead]);
+        p->qhead = (p->qhead + 1) % MELODY_QUEUE_MAX;
+        p->qlen--;
+    }
+}
+
+int melody_player_play(melody_player_t *p, const melody_note_t *notes, int n, int id, int mode) {
+    struct melody *m = malloc(sizeof(*m) + n * sizeof(m->notes[0]));
+    if (!m)
+        return -1;
+    m->id = id;
+    m->n = n;
+    memcpy(m->notes, notes, n * sizeof(m->notes[0]));
+
+    pthread_mutex_lock(&p->lock);
+    if (mode == MELODY_REPLACE) {
+        player_clear_queue(p);
+        atomic_store(&p->interrupt, 1);
+    } else if (p->qlen == MELODY_QUEUE_MAX) {
+        pthread_mutex_unlock(&p->lock);
+        free(m);
+        return -1;
+    }
+    p->queue[(p->qhead + p->qlen) % MELODY_QUEUE_MAX] = m;
+    p->qlen++;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    return 0;
+}
+
+void melody_player_stop(melody_player_t *p) {
+    pthread_mutex_lock(&p->lock);
+    player_clear_queue(p);
+    atomic_store(&p->interrupt, 1);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void melody_player_get_jitter(melody_player_t *p, melody_jitter_t *st) {
+    pthread_mutex_lock(&p->lock);
+    *st = p->jitter;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void melody_player_reset_jitter(melody_player_t *p) {
+    pthread_mutex_lock(&p->lock);
+    memset(&p->jitter, 0, sizeof(p->jitter));
+    pthread_mutex_unlock(&p->lock);
+}
+
+void melody_player_print_jitter(melody_player_t *p, FILE *out) {
+    melody_jitter_t st;
+
+    melody_player_get_jitter(p, &st);
+    fprintf(out, "Melody edge lateness: %lu edges, mean %lu us, max %lu us\n", st.edges,
+            st.edges ? st.total_us / st.edges : 0, st.max_us);
+    for (int b = 0; b < MELODY_JITTER_BUCKETS; b++) {
+        if (!st.hist[b])
+            continue;
+        unsigned long lo = b ? 1UL << (b - 1) : 0;
+        unsigned long hi = b ? (1UL << b) - 1 : 0;
+        fprintf(out, "%6lu..%-6lu %10lu\n", lo, hi, st.hist[b]);
+    }
+}
+
+// ===== Поток проигрывателя =====
+
+static void ts_add_ms(struct timespec *ts, unsigned ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += ms % 1000 * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static long ts_diff_ns(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec - b->tv_sec) * 1000000000L + (a->tv_nsec - b->tv_nsec);
+}
+
+// Спит до абсолютного срока. Возвращает -1, если мелодию прервали.
+static int player_sleep_until(melody_player_t *p, const struct timespec *deadline) {
+    struct timespec now, t;
+
+    for (;;) {
+        if (atomic_load(&p->interrupt))
+            return -1;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long left = ts_diff_ns(deadline, &now);
+        if (left <= 0)
+            return 0;
+        if (left > MELODY_SLICE_NS) {
+            t = now;
+            t.tv_nsec += MELODY_SLICE_NS;
+            if (t.tv_nsec >= 1000000000L) {
+                t.tv_sec++;
+                t.tv_nsec -= 1000000000L;
+            }
+        } else {
+            t = *deadline;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+    }
+}
+
+// Выставляет выход и учитывает опоздание фронта относительно срока
+static void player_edge(melody_player_t *p, unsigned freq, const struct timespec *deadline) {
+    struct timespec now;
+
+    p->out(p->out_ctx, freq);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long late = ts_diff_ns(&now, deadline) / 1000;
+    unsigned long us = late > 0 ? late : 0;
+
+    int b = 0;
+    for (unsigned long v = us; v && b < MELODY_JITTER_BUCKETS - 1; v >>= 1)
+        b++;
+
+    pthread_mutex_lock(&p->lock);
+    p->jitter.edges++;
+    p->jitter.total_us += us;
+    if (us > p->jitter.max_us)
+        p->jitter.max_us = us;
+    p->jitter.hist[b]++;
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void player_report(melody_player_t *p, int id, int event, int note, int count) {
+    if (p->progress)
+        p->progress(p->user_data, id, event, note, count);
+}
+
+// Играет мелодию начиная со срока *deadline; по возвращении *deadline —
+// срок конца мелодии. Возвращает -1, если мелодию прервали.
+static int player_play(melody_player_t *p, const struct melody *m, struct timespec *deadline) {
+    player_report(p, m->id, MELODY_EV_START, 0, m->n);
+    for (int i = 0; i < m->n; i++) {
+        if (player_sleep_until(p, deadline) < 0)
+            goto stopped;
+        player_edge(p, m->notes[i].freq_hz, deadline);
+        player_report(p, m->id, MELODY_EV_NOTE, i, m->n);
+        ts_add_ms(deadline, m->notes[i].duration_ms);
+    }
+    if (player_sleep_until(p, deadline) < 0)
+        goto stopped;
+    player_edge(p, 0, deadline);
+    player_report(p, m->id, MELODY_EV_DONE, m->n, m->n);
+    return 0;
+
+stopped:
+    p->out(p->out_ctx, 0);
+    player_report(p, m->id, MELODY_EV_STOP, 0, m->n);
+    return -1;
+}
+
+static void *player_main(void *arg) {
+    melody_player_t *p = arg;
+    struct timespec deadline;
+    int chained = 0;
+
+    // Реальное время, если разрешено (root или CAP_SYS_NICE); иначе
+    // остаёмся в обычном планировщике
+    struct sched_param sp = {.sched_priority = MELODY_RT_PRIORITY};
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        if (p->qlen == 0) {
+            chained = 0;
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+        struct melody *m = p->queue[p->qhead];
+        p->qhead = (p->qhead + 1) % MELODY_QUEUE_MAX;
+        p->qlen--;
+        atomic_store(&p->interrupt, 0);
+        pthread_mutex_unlock(&p->lock);
+
+        // Мелодия из очереди начинается ровно в срок конца предыдущей
+        if (!chained)
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+        chained = player_play(p, m, &deadline) == 0;
+        free(m);
+
+        pthread_mutex_lock(&p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
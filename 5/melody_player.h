@@ -0,0 +1,61 @@
+#ifndef MELODY_PLAYER_H
+#define MELODY_PLAYER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Нота мелодии: частота (0 — тишина) и длительность.
+// Активный зуммер сам задаёт высоту тона, для него важно только freq != 0.
+typedef struct {
+    uint16_t freq_hz;
+    uint16_t duration_ms;
+} melody_note_t;
+
+// Как новая мелодия сочетается с уже играющей
+#define MELODY_REPLACE 0 // Прервать текущую, очистить очередь и играть новую
+#define MELODY_QUEUE   1 // Сыграть после текущей и уже стоящих в очереди
+
+// Длина очереди мелодий
+#define MELODY_QUEUE_MAX 8
+
+// События для обратного вызова о ходе воспроизведения
+#define MELODY_EV_START 0 // Мелодия начала играть
+#define MELODY_EV_NOTE  1 // Началась нота note
+#define MELODY_EV_DONE  2 // Мелодия доиграна
+#define MELODY_EV_STOP  3 // Мелодия прервана
+
+// Опоздание фронтов (смены ноты) относительно расписания, мкс.
+// Гистограмма с логарифмическими корзинами: 0 — 0 мкс, b — от 2^(b-1)
+// до 2^b - 1 мкс, последняя собирает всё остальное.
+#define MELODY_JITTER_BUCKETS 16
+typedef struct {
+    unsigned long edges;
+    unsigned long total_us;
+    unsigned long max_us;
+    unsigned long hist[MELODY_JITTER_BUCKETS];
+} melody_jitter_t;
+
+typedef struct melody_player melody_player_t;
+
+// Выставляет выход: freq_hz == 0 — выключить, иначе звучать.
+// Вызывается из потока проигрывателя.
+typedef void (*melody_output_fn)(void *ctx, unsigned freq_hz);
+// Ход воспроизведения. Вызывается из потока проигрывателя, поэтому
+// GUI должен передавать результат в главный цикл (g_idle_add).
+typedef void (*melody_progress_fn)(void *user_data, int id, int event, int note, int count);
+
+melody_player_t *melody_player_new(melody_output_fn out, void *out_ctx,
+                                   melody_progress_fn progress, void *user_data);
+void melody_player_free(melody_player_t *p);
+
+// Ставит мелодию из n нот (копируется) с номером id. Не блокируется.
+// Возвращает 0 или -1, если очередь заполнена.
+int melody_player_play(melody_player_t *p, const melody_note_t *notes, int n, int id, int mode);
+// Прерывает текущую мелодию и очищает очередь
+void melody_player_stop(melody_player_t *p);
+
+void melody_player_get_jitter(melody_player_t *p, melody_jitter_t *st);
+void melody_player_reset_jitter(melody_player_t *p);
+void melody_player_print_jitter(melody_player_t *p, FILE *out);
+
+#endif // MELODY_PLAYER_H
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "melody_lib.h"
+
+/**
+ * @file melody_tool.c
+ * @brief Компиляция мелодий RTTTL в формат *.mel и замер загрузки.
+ *
+ *   ./melody_tool compile melodies.rtttl melodies.mel
+ *   ./melody_tool bench [мелодий]
+ *
+ * В режиме bench генерируется библиотека из сотен мелодий RTTTL и
+ * замеряется разбор, компиляция и загрузка обоих форматов из каталога,
+ * чтобы видеть, сколько библиотека добавляет ко времени запуска buzzer_gui.
+ */
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Записывает все мелодии библиотеки в файл *.mel
+static int write_compiled(const melody_lib_t *lib, const char *path) {
+    size_t size = 0;
+    for (int i = 0; i < lib->count; i++)
+        size += melody_record_size(lib->items[i].name, lib->items[i].count);
+
+    char *buf = malloc(size ? size : 1);
+    if (!buf)
+        return -1;
+    size_t off = 0;
+    for (int i = 0; i < lib->count; i++)
+        off += melody_record_write(buf + off, lib->items[i].name, lib->items[i].notes,
+                                   lib->items[i].count);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        free(buf);
+        return -1;
+    }
+    int status = fwrite(buf, 1, size, f) == size ? 0 : -1;
+    if (fclose(f) != 0)
+        status = -1;
+    free(buf);
+    return status;
+}
+
+static int cmd_compile(const char *in, const char *out) {
+    melody_lib_t lib = {0};
+    FILE *f = fopen(in, "rb");
+    if (!f) {
+        perror(in);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+    char *text = malloc(len > 0 ? len : 1);
+    if (!text || fread(text, 1, len, f) != (size_t)len) {
+        fclose(f);
+        free(text);
+        return 1;
+    }
+    fclose(f);
+
+    melody_lib_add_rtttl(&lib, text, len);
+    free(text);
+    int status = write_compiled(&lib, out);
+    printf("%s: %d melodies\n", out, lib.count);
+    melody_lib_free(&lib);
+    return status ? 1 : 0;
+}
+
+// Генерирует n мелодий RTTTL по 48 нот (псевдослучайно, но повторяемо)
+static char *make_library(int n, size_t *len) {
+    static const char *letters[] = {"c", "c#", "d", "d#", "e", "f", "f#", "g", "g#", "a", "a#", "b", "p"};
+    static const char *durs[] = {"", "4", "8", "16", "2"};
+    size_t cap = (size_t)n * 512 + 1;
+    char *text = malloc(cap);
+    size_t off = 0;
+    unsigned seed = 12345;
+
+    if (!text)
+        return NULL;
+    for (int i = 0; i < n; i++) {
+        off += snprintf(text + off, cap - off, "Melody %d:d=8,o=5,b=%d:", i, 90 + i % 120);
+        for (int j = 0; j < 48; j++) {
+            seed = seed * 1103515245 + 12345;
+            unsigned r = seed >> 8;
+            off += snprintf(text + off, cap - off, "%s%s%s%s%s", j ? "," : "", durs[r % 5],
+                            letters[(r >> 4) % 13], (r >> 8) % 7 == 0 ? "." : "",
+                            (r >> 12) % 3 == 0 ? "6" : "");
+        }
+        text[off++] = '\n';
+    }
+    *len = off;
+    return text;
+}
+
+static int cmd_bench(int n) {
+    char dir[] = "/tmp/melody_bench.XXXXXX";
+    char path[64];
+    size_t len;
+    char *text = make_library(n, &len);
+    melody_lib_t lib = {0}, compiled = {0}, from_dir = {0};
+
+    if (!text || !mkdtemp(dir))
+        return 1;
+
+    // Разбор RTTTL
+    double t0 = now_sec();
+    melody_lib_add_rtttl(&lib, text, len);
+    double t_parse = now_sec() - t0;
+
+    // Компиляция в *.mel (в памяти)
+    size_t size = 0;
+    for (int i = 0; i < lib.count; i++)
+        size += melody_record_size(lib.items[i].name, lib.items[i].count);
+    char *buf = malloc(size);
+    if (!buf)
+        return 1;
+    t0 = now_sec();
+    size_t off = 0;
+    for (int i = 0; i < lib.count; i++)
+        off += melody_record_write(buf + off, lib.items[i].name, lib.items[i].notes,
+                                   lib.items[i].count);
+    double t_compile = now_sec() - t0;
+
+    // Индексация скомпилированного буфера
+    t0 = now_sec();
+    melody_lib_add_compiled(&compiled, buf, size);
+    double t_index = now_sec() - t0;
+
+    // Загрузка из каталога: сначала только RTTTL, затем только *.mel
+    snprintf(path, sizeof(path), "%s/lib.rtttl", dir);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return 1;
+    fwrite(text, 1, len, f);
+    fclose(f);
+    t0 = now_sec();
+    melody_lib_load(&from_dir, dir);
+    double t_load_rtttl = now_sec() - t0;
+    melody_lib_free(&from_dir);
+    unlink(path);
+
+    snprintf(path, sizeof(path), "%s/lib.mel", dir);
+    write_compiled(&lib, path);
+    t0 = now_sec();
+    melody_lib_load(&from_dir, dir);
+    double t_load_mel = now_sec() - t0;
+
+    int same = from_dir.count == lib.count;
+    for (int i = 0; same && i < lib.count; i++) {
+        same = from_dir.items[i].count == lib.items[i].count &&
+               memcmp(from_dir.items[i].notes, lib.items[i].notes,
+                      lib.items[i].count * sizeof(melody_note_t)) == 0;
+    }
+
+    printf("%d melodies, %zu bytes RTTTL, %zu bytes compiled\n", lib.count, len, size);
+    printf("%-22s %10s %14s\n", "stage", "total ms", "us/melody");
+    printf("%-22s %10.3f %14.2f\n", "parse RTTTL", t_parse * 1e3, t_parse * 1e6 / n);
+    printf("%-22s %10.3f %14.2f\n", "compile to .mel", t_compile * 1e3, t_compile * 1e6 / n);
+    printf("%-22s %10.3f %14.2f\n", "index .mel buffer", t_index * 1e3, t_index * 1e6 / n);
+    printf("%-22s %10.3f %14.2f\n", "load dir (.rtttl)", t_load_rtttl * 1e3, t_load_rtttl * 1e6 / n);
+    printf("%-22s %10.3f %14.2f\n", "load dir (.mel, mmap)", t_load_mel * 1e3, t_load_mel * 1e6 / n);
+    if (!same)
+        fprintf(stderr, "compiled melodies differ from parsed ones\n");
+
+    melody_lib_free(&from_dir);
+    unlink(path);
+    rmdir(dir);
+    melody_lib_free(&compiled);
+    melody_lib_free(&lib);
+    free(buf);
+    free(text);
+    return same ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[1], "compile") == 0)
+        return cmd_compile(argv[2], argv[3]);
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        int n = argc > 2 ? atoi(argv[2]) : 500;
+        return cmd_bench(n > 0 ? n : 500);
+    }
+    fprintf(stderr, "Usage: %s compile <in.rtttl> <out.mel>\n"
+                    "       %s bench [melodies]\n", argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,345 @@
+#include "tone_engine.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <pigpio.h>
+
+// Больше байт gpioWaveChain за один вызов не принимает
+#define TONE_CHAIN_MAX 600
+// Волн pigpio не больше 250 (номер волны в цепочке — один байт)
+#define TONE_WAVES_MAX 250
+// Счётчик повтора и задержка в цепочке — 16-битные
+#define TONE_REPEAT_MAX 65535
+#define TONE_DELAY_MAX 65535
+
+// Поток просыпается за 2 мс до конца куска и дальше опрашивает
+// gpioWaveTxBusy каждые 20 мкс, чтобы зазор между кусками был мал
+#define TONE_EARLY_NS 2000000L
+#define TONE_POLL_NS 20000L
+
+// Волна одного периода меандра
+struct tone_wave {
+    unsigned period_us;
+    int wid;
+};
+
+// Кусок цепочки для одного вызова gpioWaveChain
+struct tone_chunk {
+    int off, len;
+    unsigned long us; // Длительность куска
+};
+
+struct tone_engine {
+    unsigned gpio;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int quit;
+
+    // Текущая мелодия: цепочка, порезанная на куски, защищена lock.
+    // Кусок next ещё не отправлен; chunk_end — ожидаемый конец отправленного.
+    char *chain;
+    int chain_len, chain_cap;
+    struct tone_chunk *chunks;
+    int nchunks, chunks_cap, next;
+    struct timespec chunk_end;
+    // Меняется при каждом play/stop, чтобы поток не отправил чужой кусок
+    atomic_uint gen;
+
+    struct tone_wave waves[TONE_WAVES_MAX];
+    int nwaves;
+
+    tone_stats_t stats;
+};
+
+static void *tone_main(void *arg);
+
+tone_engine_t *tone_engine_new(unsigned gpio) {
+    tone_engine_t *t = calloc(1, sizeof(*t));
+    pthread_condattr_t ca;
+
+    if (!t)
+        return NULL;
+    t->gpio = gpio;
+    atomic_init(&t->gen, 0);
+    gpioSetMode(gpio, PI_OUTPUT);
+    gpioWrite(gpio, 0);
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->cond, &ca);
+    pthread_condattr_destroy(&ca);
+
+    if (pthread_create(&t->thread, NULL, tone_main, t) != 0) {
+        pthread_cond_destroy(&t->cond);
+        pthread_mutex_destroy(&t->lock);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void tone_engine_free(tone_engine_t *t) {
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    t->quit = 1;
+    gpioWaveTxStop(); // Поток может ждать конца куска в опросе
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+
+    gpioWrite(t->gpio, 0);
+    for (int i = 0; i < t->nwaves; i++)
+        gpioWaveDelete(t->waves[i].wid);
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->lock);
+    free(t->chain);
+    free(t->chunks);
+    free(t);
+}
+
+// ===== Построение цепочки (под lock) =====
+
+// Номер волны для периода; строит волну, если её ещё нет
+static int tone_wave(tone_engine_t *t, unsigned period_us) {
+    for (int i = 0; i < t->nwaves; i++) {
+        if (t->waves[i].period_us == period_us) {
+            t->stats.waves_reused++;
+            return t->waves[i].wid;
+        }
+    }
+    if (t->nwaves == TONE_WAVES_MAX)
+        return -1;
+
+    unsigned mask = 1u << t->gpio;
+    gpioPulse_t pulses[2] = {
+        {mask, 0, period_us / 2},
+        {0, mask, period_us - period_us / 2},
+    };
+    gpioWaveAddNew();
+    if (gpioWaveAddGeneric(2, pulses) < 0)
+        return -1;
+    int wid = gpioWaveCreate();
+    if (wid < 0)
+        return wid;
+
+    t->waves[t->nwaves].period_us = period_us;
+    t->waves[t->nwaves].wid = wid;
+    t->nwaves++;
+    t->stats.waves_created++;
+    return wid;
+}
+
+static void tone_flush_waves(tone_engine_t *t) {
+    gpioWaveClear();
+    t->nwaves = 0;
+    t->stats.cache_flushes++;
+}
+
+// Добавляет команду цепочки длительностью us. Команда целиком попадает
+// в один кусок: если не влезает в текущий, начинается новый.
+static int chain_put(tone_engine_t *t, const char *cmd, int len, unsigned long us) {
+    if (t->chain_len + len > t->chain_cap) {
+        int cap = t->chain_cap ? t->chain_cap * 2 : 1024;
+        char *chain = realloc(t->chain, cap);
+        if (!chain)
+            return -1;
+        t->chain = chain;
+        t->chain_cap = cap;
+    }
+    struct tone_chunk *c = t->nchunks ? &t->chunks[t->nchunks - 1] : NULL;
+    if (!c || c->len + len > TONE_CHAIN_MAX) {
+        if (t->nchunks == t->chunks_cap) {
+            int cap = t->chunks_cap ? t->chunks_cap * 2 : 4;
+            struct tone_chunk *chunks = realloc(t->chunks, cap * sizeof(*chunks));
+            if (!chunks)
+                return -1;
+            t->chunks = chunks;
+            t->chunks_cap = cap;
+        }
+        c = &t->chunks[t->nchunks++];
+        c->off = t->chain_len;
+        c->len = 0;
+        c->us = 0;
+    }
+    memcpy(t->chain + t->chain_len, cmd, len);
+    t->chain_len += len;
+    c->len += len;
+    c->us += us;
+    return 0;
+}
+
+// Звук: волна wid повторяется cycles раз
+static int chain_tone(tone_engine_t *t, int wid, unsigned period_us, unsigned long cycles) {
+    while (cycles > 0) {
+        unsigned n = cycles > TONE_REPEAT_MAX ? TONE_REPEAT_MAX : cycles;
+        int status;
+        if (n == 1) {
+            char cmd[1] = {wid};
+            status = chain_put(t, cmd, sizeof(cmd), period_us);
+        } else {
+            // 255 0 — начало цикла, 255 1 x y — повторить x + 256*y раз
+            char cmd[7] = {255, 0, wid, 255, 1, n & 0xFF, n >> 8};
+            status = chain_put(t, cmd, sizeof(cmd), (unsigned long)n * period_us);
+        }
+        if (status < 0)
+            return status;
+        cycles -= n;
+    }
+    return 0;
+}
+
+// Тишина: 255 2 x y — задержка x + 256*y мкс
+static int chain_delay(tone_engine_t *t, unsigned long us) {
+    while (us > 0) {
+        unsigned n = us > TONE_DELAY_MAX ? TONE_DELAY_MAX : us;
+        char cmd[4] = {255, 2, n & 0xFF, n >> 8};
+        if (chain_put(t, cmd, sizeof(cmd), n) < 0)
+            return -1;
+        us -= n;
+    }
+    return 0;
+}
+
+// Строит цепочку для мелодии. Нота длится целое число периодов, а
+// остаток переносится на следующую ноту: ошибка ритма не накапливается
+// и в любой момент меньше половины периода.
+static int tone_build(tone_engine_t *t, const melody_note_t *notes, int n) {
+    unsigned long long target = 0, placed = 0;
+
+    t->chain_len = 0;
+    t->nchunks = 0;
+    t->next = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned freq = notes[i].freq_hz;
+        target += notes[i].duration_ms * 1000ULL;
+        if (target <= placed)
+            continue;
+        unsigned long long left = target - placed;
+        int status;
+
+        if (freq && freq <= TONE_MAX_FREQ) {
+            unsigned period = (1000000 + freq / 2) / freq;
+            int wid = tone_wave(t, period);
+            if (wid < 0)
+                return wid;
+            unsigned long cycles = (left + period / 2) / period;
+            status = chain_tone(t, wid, period, cycles);
+            placed += (unsigned long long)cycles * period;
+        } else {
+            status = chain_delay(t, left);
+            placed = target;
+        }
+        if (status < 0)
+            return status;
+    }
+    return 0;
+}
+
+// Отправляет следующий кусок; вызывается под lock
+static int tone_send(tone_engine_t *t) {
+    struct tone_chunk *c = &t->chunks[t->next++];
+    int status = gpioWaveChain(t->chain + c->off, c->len);
+    if (status < 0) {
+        t->nchunks = t->next = 0;
+        return status;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t->chunk_end);
+    t->chunk_end.tv_sec += c->us / 1000000;
+    t->chunk_end.tv_nsec += c->us % 1000000 * 1000L;
+    if (t->chunk_end.tv_nsec >= 1000000000L) {
+        t->chunk_end.tv_sec++;
+        t->chunk_end.tv_nsec -= 1000000000L;
+    }
+    t->stats.chains++;
+    t->stats.chain_bytes += c->len;
+    return 0;
+}
+
+int tone_engine_play(tone_engine_t *t, const melody_note_t *notes, int n) {
+    pthread_mutex_lock(&t->lock);
+    atomic_fetch_add(&t->gen, 1);
+    gpioWaveTxStop();
+    gpioWrite(t->gpio, 0);
+
+    int status = tone_build(t, notes, n);
+    if (status < 0 && t->nwaves > 0) {
+        // Кончились волны или память DMA: сносим кеш и строим заново.
+        // Волны можно удалять, потому что передача остановлена.
+        tone_flush_waves(t);
+        status = tone_build(t, notes, n);
+    }
+    if (status < 0)
+        t->nchunks = t->next = 0;
+    else if (t->nchunks > 0)
+        status = tone_send(t);
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return status;
+}
+
+void tone_engine_stop(tone_engine_t *t) {
+    pthread_mutex_lock(&t->lock);
+    atomic_fetch_add(&t->gen, 1);
+    t->nchunks = t->next = 0;
+    gpioWaveTxStop();
+    gpioWrite(t->gpio, 0);
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+}
+
+int tone_engine_busy(tone_engine_t *t) {
+    pthread_mutex_lock(&t->lock);
+    int busy = t->next < t->nchunks || gpioWaveTxBusy();
+    pthread_mutex_unlock(&t->lock);
+    return busy;
+}
+
+void tone_engine_get_stats(tone_engine_t *t, tone_stats_t *st) {
+    pthread_mutex_lock(&t->lock);
+    *st = t->stats;
+    pthread_mutex_unlock(&t->lock);
+}
+
+// ===== Поток, досылающий куски длинной цепочки =====
+
+static void *tone_main(void *arg) {
+    tone_engine_t *t = arg;
+    const struct timespec poll = {0, TONE_POLL_NS};
+
+    pthread_mutex_lock(&t->lock);
+    while (!t->quit) {
+        if (t->next >= t->nchunks) {
+            pthread_cond_wait(&t->cond, &t->lock);
+            continue;
+        }
+
+        // Спим почти до конца отправленного куска; play/stop будят раньше
+        struct timespec wake = t->chunk_end;
+        wake.tv_nsec -= TONE_EARLY_NS;
+        if (wake.tv_nsec < 0) {
+            wake.tv_sec--;
+            wake.tv_nsec += 1000000000L;
+        }
+        if (pthread_cond_timedwait(&t->cond, &t->lock, &wake) != ETIMEDOUT)
+            continue;
+
+        // Остаток дожидаемся опросом без блокировки: play и stop не ждут нас
+        unsigned gen = atomic_load(&t->gen);
+        pthread_mutex_unlock(&t->lock);
+        while (atomic_load(&t->gen) == gen && gpioWaveTxBusy())
+            nanosleep(&poll, NULL);
+        pthread_mutex_lock(&t->lock);
+
+        if (!t->quit && atomic_load(&t->gen) == gen && t->next < t->nchunks)
+            tone_send(t);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
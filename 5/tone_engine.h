@@ -0,0 +1,46 @@
+#ifndef TONE_ENGINE_H
+#define TONE_ENGINE_H
+
+#include "melody_player.h"
+
+// ===== Тоны для пассивного зуммера через волны pigpio =====
+// Пассивный зуммер звучит только от меандра нужной частоты. Для каждой
+// частоты строится волна pigpio из одного периода (высокий + низкий
+// уровень), ноты мелодии — повторы этой волны в цепочке gpioWaveChain,
+// паузы — задержки цепочки. Меандр и ритм выдаёт DMA, процессор не нужен.
+//
+// Волны кешируются по частоте и переиспользуются между мелодиями.
+// Цепочка длиннее, чем принимает gpioWaveChain (600 байт), режется на
+// куски по границам нот; следующий кусок отправляет поток движка сразу
+// после окончания предыдущего.
+//
+// Перед tone_engine_new программа должна вызвать gpioInitialise().
+
+// Самая высокая частота, которую берётся играть движок (период 50 мкс)
+#define TONE_MAX_FREQ 20000
+
+typedef struct {
+    unsigned long waves_created; // Волн построено
+    unsigned long waves_reused;  // Нот, сыгранных уже готовой волной
+    unsigned long cache_flushes; // Сколько раз кеш волн очищался целиком
+    unsigned long chains;        // Кусков цепочки отправлено
+    unsigned long chain_bytes;   // Байт в этих кусках
+} tone_stats_t;
+
+typedef struct tone_engine tone_engine_t;
+
+tone_engine_t *tone_engine_new(unsigned gpio);
+void tone_engine_free(tone_engine_t *t);
+
+// Прерывает текущую мелодию и начинает играть n нот. Не блокируется:
+// ноты копируются в цепочку, играет DMA. Возвращает 0 или отрицательный
+// код ошибки pigpio (например, если в мелодии слишком много разных частот).
+int tone_engine_play(tone_engine_t *t, const melody_note_t *notes, int n);
+// Прерывает мелодию и оставляет выход в низком уровне
+void tone_engine_stop(tone_engine_t *t);
+// 1, пока мелодия играет
+int tone_engine_busy(tone_engine_t *t);
+
+void tone_engine_get_stats(tone_engine_t *t, tone_stats_t *st);
+
+#endif // TONE_ENGINE_H
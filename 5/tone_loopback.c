@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <pigpio.h>
+#include "tone_engine.h"
+
+/**
+ * @file tone_loopback.c
+ * @brief Замер точности тонов: выход зуммера соединяется проводом со входом.
+ *
+ *   sudo ./tone_loopback [выход [вход]]     (по умолчанию GPIO18 -> GPIO23)
+ *
+ * Тестовая мелодия играется дважды: волнами pigpio (tone_engine, DMA) и
+ * программно — поток переключает выход по абсолютным срокам полупериодов,
+ * как это делал бы проигрыватель без DMA. Вход опрашивается pigpio с шагом
+ * 1 мкс; по фронтам считаются частота каждой ноты, разброс периодов и
+ * опоздание начала ноты относительно расписания.
+ */
+
+#define DEFAULT_OUT 18
+#define DEFAULT_IN 23
+#define MAX_EDGES 65536
+// Тишина дольше этого разделяет ноты
+#define NOTE_GAP_US 20000
+
+#define TONE_MS 300
+#define REST_MS 100
+
+static const unsigned test_freqs[] = {262, 440, 523, 880, 1047, 2093, 3136, 4186};
+#define NTEST (int)(sizeof(test_freqs) / sizeof(test_freqs[0]))
+
+static melody_note_t test_melody[2 * NTEST];
+static unsigned out_gpio = DEFAULT_OUT;
+
+static uint32_t edges[MAX_EDGES]; // Моменты фронтов вверх, мкс (тики pigpio)
+static atomic_int nedges;
+
+static void on_edge(int gpio, int level, uint32_t tick) {
+    if (level != 1)
+        return;
+    int i = atomic_fetch_add(&nedges, 1);
+    if (i < MAX_EDGES)
+        edges[i] = tick;
+}
+
+static void ts_add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static int ts_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Программный меандр по тому же расписанию: каждый полупериод —
+// clock_nanosleep до абсолютного срока и gpioWrite
+static void *software_tones(void *arg) {
+    struct timespec t, end;
+    struct sched_param sp = {.sched_priority = 50};
+
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    for (int i = 0; i < 2 * NTEST; i++) {
+        const melody_note_t *m = &test_melody[i];
+        end = t;
+        ts_add_ns(&end, m->duration_ms * 1000000L);
+        if (m->freq_hz) {
+            long half = 500000000L / m->freq_hz;
+            int level = 1;
+            while (ts_before(&t, &end)) {
+                gpioWrite(out_gpio, level);
+                level = !level;
+                ts_add_ns(&t, half);
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+            }
+            gpioWrite(out_gpio, 0);
+        }
+        t = end;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+    }
+    return NULL;
+}
+
+// Разбирает фронты по нотам и печатает отчёт
+static void report(const char *title) {
+    int n = atomic_load(&nedges);
+    double worst_err = 0, worst_jit = 0, worst_onset = 0;
+
+    if (n > MAX_EDGES)
+        n = MAX_EDGES;
+    printf("\n%s: %d rising edges\n", title, n);
+    printf("%8s %10s %9s %10s %10s %10s\n", "note Hz", "meas Hz", "err %", "jit rms us",
+           "jit max us", "onset us");
+
+    int start = 0;
+    uint32_t first_onset = n ? edges[0] : 0;
+    for (int note = 0; note < NTEST && start < n; note++) {
+        // Нота — фронты до первой паузы длиннее NOTE_GAP_US
+        int end = start + 1;
+        while (end < n && (uint32_t)(edges[end] - edges[end - 1]) < NOTE_GAP_US)
+            end++;
+        int periods = end - start - 1;
+        if (periods < 2) {
+            start = end;
+            continue;
+        }
+
+        double mean = (double)(uint32_t)(edges[end - 1] - edges[start]) / periods;
+        double sq = 0, max_dev = 0;
+        for (int i = start + 1; i < end; i++) {
+            double dev = (uint32_t)(edges[i] - edges[i - 1]) - mean;
+            sq += dev * dev;
+            if (fabs(dev) > max_dev)
+                max_dev = fabs(dev);
+        }
+        double freq = 1e6 / mean;
+        double err = (freq - test_freqs[note]) * 100.0 / test_freqs[note];
+        double rms = sqrt(sq / periods);
+        // Начало ноты относительно начала первой, минус расписание
+        double onset = (double)(uint32_t)(edges[start] - first_onset) -
+                       note * (TONE_MS + REST_MS) * 1000.0;
+
+        printf("%8u %10.2f %9.3f %10.2f %10.1f %10.0f\n", test_freqs[note], freq, err, rms,
+               max_dev, onset);
+        if (fabs(err) > worst_err)
+            worst_err = fabs(err);
+        if (max_dev > worst_jit)
+            worst_jit = max_dev;
+        if (fabs(onset) > worst_onset)
+            worst_onset = fabs(onset);
+        start = end;
+    }
+    printf("worst: freq error %.3f %%, period deviation %.1f us, onset error %.0f us\n",
+           worst_err, worst_jit, worst_onset);
+}
+
+static void capture_start(unsigned in_gpio) {
+    atomic_store(&nedges, 0);
+    gpioSetAlertFunc(in_gpio, on_edge);
+}
+
+static void capture_stop(unsigned in_gpio) {
+    usleep(50000); // Последние фронты ещё в буфере pigpio
+    gpioSetAlertFunc(in_gpio, NULL);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned in_gpio = DEFAULT_IN;
+    pthread_t thread;
+
+    if (argc > 1)
+        out_gpio = atoi(argv[1]);
+    if (argc > 2)
+        in_gpio = atoi(argv[2]);
+
+    for (int i = 0; i < NTEST; i++) {
+        test_melody[2 * i].freq_hz = test_freqs[i];
+        test_melody[2 * i].duration_ms = TONE_MS;
+        test_melody[2 * i + 1].freq_hz = 0;
+        test_melody[2 * i + 1].duration_ms = REST_MS;
+    }
+
+    // Шаг опроса входов 1 мкс (по умолчанию 5), источник — PCM, чтобы
+    // не мешать аудио на PWM
+    gpioCfgClock(1, 1, 0);
+    if (gpioInitialise() < 0) {
+        fprintf(stderr, "Failed to initialise pigpio (run as root, pigpiod must be stopped)\n");
+        return 1;
+    }
+    gpioSetMode(in_gpio, PI_INPUT);
+    gpioSetPullUpDown(in_gpio, PI_PUD_DOWN);
+
+    tone_engine_t *tone = tone_engine_new(out_gpio);
+    if (!tone) {
+        gpioTerminate();
+        return 1;
+    }
+    printf("Loopback GPIO%u -> GPIO%u, %d notes of %d ms\n", out_gpio, in_gpio, NTEST, TONE_MS);
+
+    capture_start(in_gpio);
+    if (tone_engine_play(tone, test_melody, 2 * NTEST) < 0)
+        fprintf(stderr, "tone_engine_play failed\n");
+    while (tone_engine_busy(tone))
+        usleep(10000);
+    capture_stop(in_gpio);
+    report("pigpio waves (DMA)");
+
+    tone_stats_t st;
+    tone_engine_get_stats(tone, &st);
+    printf("waves created %lu, reused %lu, chains %lu (%lu bytes)\n", st.waves_created,
+           st.waves_reused, st.chains, st.chain_bytes);
+    tone_engine_free(tone);
+
+    capture_start(in_gpio);
+    pthread_create(&thread, NULL, software_tones, NULL);
+    pthread_join(thread, NULL);
+    capture_stop(in_gpio);
+    report("software timing (clock_nanosleep + gpioWrite)");
+
+    gpioTerminate();
+    return 0;
+}
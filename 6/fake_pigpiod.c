@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * @file fake_pigpiod.c
+ * @brief Заглушка демона pigpiod для проверки servo_gui и клиента без железа.
+ *
+ *   ./fake_pigpiod [порт | /путь/к/сокету]      (по умолчанию порт 8888)
+ *
+ * Принимает команды по протоколу pigpiod (16 байт запрос, 16 байт ответ) и
+ * отвечает так же, как демон: SERVO проверяет номер GPIO (0..31) и ширину
+ * импульса (0 или 500..2500 мкс), MODES/WRITE/PWM — номер GPIO и значение,
+ * TICK возвращает время в мкс, неизвестные команды — ошибку. Слушает только
+ * 127.0.0.1. При завершении (Ctrl+C) печатает число команд и последний
+ * импульс каждого GPIO. pigs тоже работает с заглушкой через PIGPIO_PORT.
+ *
+ * Волны (WVNEW, WVAG, WVCRE, WVTXM, WVTAT, WVDEL, WVHLT) хранятся как у
+ * демона: id — наименьший свободный, режимы _SYNC переключаются в конце
+ * цикла текущей волны по часам заглушки. Удаление передаваемой волны
+ * считается отдельно — настоящий демон от этого выдал бы мусор на выходах.
+ * При завершении для передаваемой волны печатается импульс каждого GPIO.
+ */
+
+#define MAX_CLIENTS 16
+#define MAX_WAVES 250   // Как PI_MAX_WAVES
+#define MAX_PULSES 2048 // Импульсов в одной волне (у демона ограничено числом DMA-блоков)
+
+// Коды ошибок pigpio
+#define PI_BAD_USER_GPIO -2
+#define PI_BAD_MODE -4
+#define PI_BAD_LEVEL -5
+#define PI_BAD_PULSEWIDTH -7
+#define PI_BAD_DUTYCYCLE -8
+#define PI_TOO_MANY_PULSES -36
+#define PI_BAD_WAVE_ID -66
+#define PI_EMPTY_WAVEFORM -69
+#define PI_NO_WAVEFORM_ID -70
+#define PI_BAD_WAVE_MODE -33
+#define PI_NO_TX_WAVE 9999
+#define PI_UNKNOWN_COMMAND -123 // Любой отрицательный код: pigs печатает его как ошибку
+
+struct msg {
+    uint32_t cmd, p1, p2, p3;
+};
+
+// gpioPulse_t: маски поднимаемых и опускаемых GPIO, пауза после, мкс
+struct pulse {
+    uint32_t on, off, delay;
+};
+
+struct wave {
+    int used;
+    int n;
+    struct pulse *pulses;
+    uint64_t length_us;
+};
+
+static volatile sig_atomic_t quit;
+static unsigned long commands, errors;
+static int servo_pulse[32];
+
+// Волны: добавляемая (WVAG), созданные, передаваемая и следующая по _SYNC
+static struct pulse pending[MAX_PULSES];
+static int npending;
+static struct wave waves[MAX_WAVES];
+static int tx_wave = -1, tx_next = -1;
+static uint64_t tx_start, switch_at; // Начало цикла tx_wave и момент переключения, мкс
+static unsigned long waves_created, deleted_busy;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// Применяет отложенное переключение волны, если его время пришло
+static void tx_update(void) {
+    if (tx_next >= 0 && now_us() >= switch_at) {
+        tx_wave = tx_next;
+        tx_start = switch_at;
+        tx_next = -1;
+    }
+}
+
+static int32_t wave_send(int id, unsigned mode) {
+    if (id >= MAX_WAVES || !waves[id].used)
+        return PI_BAD_WAVE_ID;
+    if (mode > 3)
+        return PI_BAD_WAVE_MODE;
+    tx_update();
+    uint64_t now = now_us();
+    if ((mode & 2) && tx_wave >= 0) {
+        // _SYNC: с конца текущего цикла передаваемой волны
+        uint64_t len = waves[tx_wave].length_us;
+        tx_next = id;
+        switch_at = tx_start + ((now - tx_start) / len + 1) * len;
+    } else {
+        tx_wave = id;
+        tx_next = -1;
+        tx_start = now;
+    }
+    return waves[id].n;
+}
+
+static int32_t wave_delete(int id) {
+    if (id >= MAX_WAVES || !waves[id].used)
+        return PI_BAD_WAVE_ID;
+    tx_update();
+    if (id == tx_wave || id == tx_next)
+        deleted_busy++;
+    free(waves[id].pulses);
+    memset(&waves[id], 0, sizeof(waves[id]));
+    return 0;
+}
+
+static int32_t wave_create(void) {
+    if (npending == 0)
+        return PI_EMPTY_WAVEFORM;
+    for (int id = 0; id < MAX_WAVES; id++) {
+        if (waves[id].used)
+            continue;
+        waves[id].pulses = malloc(npending * sizeof(pending[0]));
+        if (!waves[id].pulses)
+            return PI_NO_WAVEFORM_ID;
+        memcpy(waves[id].pulses, pending, npending * sizeof(pending[0]));
+        waves[id].n = npending;
+        waves[id].length_us = 0;
+        for (int i = 0; i < npending; i++)
+            waves[id].length_us += pending[i].delay;
+        if (waves[id].length_us == 0)
+            waves[id].length_us = 1;
+        waves[id].used = 1;
+        npending = 0;
+        waves_created++;
+        return id;
+    }
+    return PI_NO_WAVEFORM_ID;
+}
+
+static void on_signal(int sig) {
+    quit = 1;
+}
+
+static int32_t execute(const struct msg *m, const uint8_t *ext) {
+    struct timespec ts;
+
+    switch (m->cmd) {
+        case 0: // MODES
+            if (m->p1 > 53)
+                return PI_BAD_USER_GPIO;
+            return m->p2 > 7 ? PI_BAD_MODE : 0;
+        case 4: // WRITE
+            if (m->p1 > 53)
+                return PI_BAD_USER_GPIO;
+            return m->p2 > 1 ? PI_BAD_LEVEL : 0;
+        case 5: // PWM
+            if (m->p1 > 31)
+                return PI_BAD_USER_GPIO;
+            return m->p2 > 255 ? PI_BAD_DUTYCYCLE : 0;
+        case 8: // SERVO
+            if (m->p1 > 31)
+                return PI_BAD_USER_GPIO;
+            if (m->p2 != 0 && (m->p2 < 500 || m->p2 > 2500))
+                return PI_BAD_PULSEWIDTH;
+            servo_pulse[m->p1] = m->p2;
+            return 0;
+        case 16: // TICK
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int32_t)(uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+        case 28: // WVAG
+            if (m->p3 % sizeof(struct pulse) != 0)
+                return PI_TOO_MANY_PULSES;
+            if (npending + m->p3 / sizeof(struct pulse) > MAX_PULSES)
+                return PI_TOO_MANY_PULSES;
+            // Импульсы добавляются в конец (демон ещё сливает их по времени)
+            memcpy(pending + npending, ext, m->p3);
+            npending += m->p3 / sizeof(struct pulse);
+            return npending;
+        case 33: // WVHLT
+            tx_wave = tx_next = -1;
+            return 0;
+        case 49: // WVCRE
+            return wave_create();
+        case 50: // WVDEL
+            return wave_delete(m->p1);
+        case 53: // WVNEW
+            npending = 0;
+            return 0;
+        case 100: // WVTXM
+            return wave_send(m->p1, m->p2);
+        case 101: // WVTAT
+            tx_update();
+            return tx_wave >= 0 ? tx_wave : PI_NO_TX_WAVE;
+        default:
+            return PI_UNKNOWN_COMMAND;
+    }
+}
+
+// Входной буфер клиента: команды могут прийти по частям
+struct client {
+    int fd;
+    uint8_t buf[4096];
+    size_t len;
+};
+
+// Обрабатывает всё, что пришло от клиента; -1 — клиент отключился
+static int serve(struct client *c) {
+    ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+    if (n <= 0)
+        return -1;
+    c->len += n;
+
+    struct msg out[sizeof(c->buf) / sizeof(struct msg)];
+    size_t off = 0, nout = 0;
+    while (c->len - off >= sizeof(struct msg)) {
+        struct msg m;
+        memcpy(&m, c->buf + off, sizeof(m));
+        // Расширение команды (p3 байт) заглушке не нужно; ждём, пока придёт целиком
+        if (c->len - off - sizeof(m) < m.p3)
+            break;
+        off += sizeof(m) + m.p3;
+
+        int32_t res = execute(&m, c->buf + off - m.p3);
+        commands++;
+        if (res < 0 && m.cmd != 16)
+            errors++;
+        out[nout] = m;
+        out[nout].p3 = (uint32_t)res;
+        nout++;
+    }
+    memmove(c->buf, c->buf + off, c->len - off);
+    c->len -= off;
+    if (c->len == sizeof(c->buf))
+        return -1; // Расширение больше буфера
+
+    // Ответы на всю пачку — одним send, как отвечает настоящий демон на конвейер
+    const uint8_t *p = (const uint8_t *)out;
+    size_t left = nout * sizeof(struct msg);
+    while (left > 0) {
+        ssize_t w = send(c->fd, p, left, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return -1;
+        p += w;
+        left -= w;
+    }
+    return 0;
+}
+
+static int listen_on(const char *where) {
+    int fd;
+
+    if (where[0] == '/') {
+        struct sockaddr_un sa = {.sun_family = AF_UNIX};
+        if (strlen(where) >= sizeof(sa.sun_path))
+            return -1;
+        strcpy(sa.sun_path, where);
+        unlink(where);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+            return -1;
+    } else {
+        struct sockaddr_in sa = {.sin_family = AF_INET};
+        int one = 1;
+        sa.sin_port = htons(atoi(where));
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+            return -1;
+    }
+    return listen(fd, 8) < 0 ? -1 : fd;
+}
+
+int main(int argc, char *argv[]) {
+    const char *where = argc > 1 ? argv[1] : "8888";
+    struct client clients[MAX_CLIENTS];
+    struct pollfd pfd[MAX_CLIENTS + 1];
+    int nclients = 0;
+
+    int lfd = listen_on(where);
+    if (lfd < 0) {
+        perror(where);
+        return 1;
+    }
+
+    struct sigaction sa = {.sa_handler = on_signal};
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    printf("fake pigpiod listening on %s\n", where);
+    fflush(stdout);
+
+    while (!quit) {
+        pfd[0].fd = lfd;
+        pfd[0].events = POLLIN;
+        for (int i = 0; i < nclients; i++) {
+            pfd[i + 1].fd = clients[i].fd;
+            pfd[i + 1].events = POLLIN;
+        }
+        if (poll(pfd, nclients + 1, -1) < 0)
+            continue; // EINTR: проверяем quit
+
+        for (int i = nclients - 1; i >= 0; i--) {
+            if (!(pfd[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if (serve(&clients[i]) < 0) {
+                close(clients[i].fd);
+                clients[i] = clients[--nclients];
+            }
+        }
+        if (pfd[0].revents & POLLIN) {
+            int fd = accept(lfd, NULL, NULL);
+            if (fd >= 0 && nclients < MAX_CLIENTS) {
+                clients[nclients].fd = fd;
+                clients[nclients].len = 0;
+                nclients++;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    printf("\n%lu commands, %lu errors\n", commands, errors);
+    for (int g = 0; g < 32; g++) {
+        if (servo_pulse[g])
+            printf("GPIO%d servo %d us\n", g, servo_pulse[g]);
+    }
+    if (waves_created) {
+        int alive = 0;
+        for (int id = 0; id < MAX_WAVES; id++)
+            alive += waves[id].used;
+        printf("%lu waves created, %d not deleted, %lu deleted while transmitting\n",
+               waves_created, alive, deleted_busy);
+    }
+    tx_update();
+    if (tx_wave >= 0) {
+        // Время от подъёма до опускания каждого GPIO в передаваемой волне
+        struct wave *w = &waves[tx_wave];
+        uint64_t t = 0, rise[32] = {0};
+        printf("wave %d: %llu us\n", tx_wave, (unsigned long long)w->length_us);
+        for (int i = 0; i < w->n; i++) {
+            for (int g = 0; g < 32; g++) {
+                if (w->pulses[i].on & (1u << g))
+                    rise[g] = t;
+                if (w->pulses[i].off & (1u << g))
+                    printf("GPIO%d wave pulse %llu us\n", g, (unsigned long long)(t - rise[g]));
+            }
+            t += w->pulses[i].delay;
+        }
+    }
+    if (where[0] == '/')
+        unlink(where);
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "hw_pwm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// После export каталог канала создаёт ядро, а права на файлы выставляет
+// udev чуть позже; столько ждём, пока файлы откроются
+#define EXPORT_WAIT_MS 1000
+
+struct hw_pwm {
+    char dir[128];    // .../pwmchipN/pwmM
+    char chip[96];
+    int channel;
+    int exported;     // Экспорт делали мы — снимаем при закрытии
+    int duty_fd;
+    int enable_fd;
+    unsigned long period_ns;
+    unsigned long duty_ns;
+    unsigned long writes;
+};
+
+static unsigned channels_open; // Каналы, открытые в этом процессе
+
+int hw_pwm_channel(unsigned gpio) {
+    switch (gpio) {
+        case 12: case 18: return 0;
+        case 13: case 19: return 1;
+        default: return -1;
+    }
+}
+
+// Записывает число в открытый файл sysfs с начала
+static int write_ulong(int fd, unsigned long value) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%lu", value);
+    return pwrite(fd, buf, len, 0) == len ? 0 : -1;
+}
+
+static int write_file(const char *dir, const char *name, unsigned long value) {
+    char path[160];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    int res = write_ulong(fd, value);
+    int err = errno;
+    close(fd);
+    errno = err;
+    return res;
+}
+
+// Открывает файл канала, дожидаясь udev после export
+static int open_attr(const char *dir, const char *name) {
+    char path[160];
+    struct timespec pause = {0, 10 * 1000000L};
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    for (int waited = 0;; waited += 10) {
+        int fd = open(path, O_WRONLY | O_CLOEXEC);
+        if (fd >= 0 || (errno != ENOENT && errno != EACCES) || waited >= EXPORT_WAIT_MS)
+            return fd;
+        nanosleep(&pause, NULL);
+    }
+}
+
+hw_pwm_t *hw_pwm_open(unsigned gpio, unsigned long period_ns) {
+    int channel = hw_pwm_channel(gpio);
+    const char *chip = getenv("HW_PWM_CHIP");
+    int err;
+
+    if (channel < 0 || period_ns == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (channels_open & (1u << channel)) {
+        errno = EBUSY; // GPIO12 и GPIO18 (13 и 19) — один и тот же канал
+        return NULL;
+    }
+    if (!chip || !*chip)
+        chip = HW_PWM_DEFAULT_CHIP;
+
+    hw_pwm_t *p = calloc(1, sizeof(*p));
+    if (!p)
+        return NULL;
+    p->channel = channel;
+    p->duty_fd = p->enable_fd = -1;
+    snprintf(p->chip, sizeof(p->chip), "%s", chip);
+    snprintf(p->dir, sizeof(p->dir), "%s/pwm%d", chip, channel);
+
+    if (access(p->dir, F_OK) != 0) {
+        if (write_file(chip, "export", channel) < 0)
+            goto fail;
+        p->exported = 1;
+    }
+    p->duty_fd = open_attr(p->dir, "duty_cycle");
+    p->enable_fd = open_attr(p->dir, "enable");
+    if (p->duty_fd < 0 || p->enable_fd < 0)
+        goto fail;
+
+    // Скважность не может превышать период: сначала обнуляем её (ошибка
+    // возможна, если период ещё 0), затем период, затем включаем
+    write_ulong(p->duty_fd, 0);
+    if (write_file(p->dir, "period", period_ns) < 0 || write_ulong(p->duty_fd, 0) < 0 ||
+        write_ulong(p->enable_fd, 1) < 0)
+        goto fail;
+    p->period_ns = period_ns;
+    channels_open |= 1u << channel;
+    return p;
+
+fail:
+    err = errno;
+    if (p->duty_fd >= 0)
+        close(p->duty_fd);
+    if (p->enable_fd >= 0)
+        close(p->enable_fd);
+    if (p->exported)
+        write_file(chip, "unexport", channel);
+    free(p);
+    errno = err;
+    return NULL;
+}
+
+void hw_pwm_close(hw_pwm_t *p) {
+    if (!p)
+        return;
+    write_ulong(p->enable_fd, 0);
+    close(p->duty_fd);
+    close(p->enable_fd);
+    if (p->exported)
+        write_file(p->chip, "unexport", p->channel);
+    channels_open &= ~(1u << p->channel);
+    free(p);
+}
+
+int hw_pwm_set_duty(hw_pwm_t *p, unsigned long duty_ns) {
+    if (duty_ns > p->period_ns)
+        duty_ns = p->period_ns;
+    if (duty_ns == p->duty_ns)
+        return 0;
+    if (write_ulong(p->duty_fd, duty_ns) < 0)
+        return -1;
+    p->duty_ns = duty_ns;
+    p->writes++;
+    return 0;
+}
+
+unsigned long hw_pwm_period(hw_pwm_t *p) {
+    return p->period_ns;
+}
+
+unsigned long hw_pwm_writes(hw_pwm_t *p) {
+    return p->writes;
+}
@@ -0,0 +1,36 @@
+#ifndef HW_PWM_H
+#define HW_PWM_H
+
+// Аппаратный ШИМ BCM2835 через sysfs ядра (/sys/class/pwm). Два канала:
+// PWM0 выводится на GPIO12 или GPIO18, PWM1 — на GPIO13 или GPIO19. Какой
+// вывод подключён к каналу, задаёт оверлей в /boot/config.txt, например
+//   dtoverlay=pwm-2chan,pin=18,func=2,pin2=19,func2=2
+// Импульсы формирует периферия сама: ни демона, ни потоков, процессор в
+// простое не тратится.
+//
+// Файлы канала открываются один раз; запись (pwrite) — только когда
+// значение меняется. Чип — /sys/class/pwm/pwmchip0 или переменная
+// окружения HW_PWM_CHIP.
+
+#define HW_PWM_DEFAULT_CHIP "/sys/class/pwm/pwmchip0"
+
+typedef struct hw_pwm hw_pwm_t;
+
+// Канал PWM для GPIO: 0, 1 или -1, если у вывода нет аппаратного ШИМ
+int hw_pwm_channel(unsigned gpio);
+
+// Экспортирует канал, задаёт период и включает выход с нулевой
+// скважностью. NULL — у GPIO нет канала, канал уже занят другим GPIO
+// этого процесса или sysfs недоступен (errno).
+hw_pwm_t *hw_pwm_open(unsigned gpio, unsigned long period_ns);
+// Выключает выход, закрывает файлы и снимает экспорт, если его делал open
+void hw_pwm_close(hw_pwm_t *p);
+
+// Длительность импульса, нс (не больше периода). 0 — записано или не
+// изменилось, -1 — ошибка записи (errno).
+int hw_pwm_set_duty(hw_pwm_t *p, unsigned long duty_ns);
+unsigned long hw_pwm_period(hw_pwm_t *p);
+// Сколько раз значение действительно записывалось
+unsigned long hw_pwm_writes(hw_pwm_t *p);
+
+#endif // HW_PWM_H
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "pigpiod_client.h"
+#include "servo_output.h"
+#include "servo_wave.h"
+
+/**
+ * @file pigpiod_bench.c
+ * @brief Сравнение способов отправить SERVO демону pigpiod.
+ *
+ *   ./pigpiod_bench [команд]      (адрес демона — PIGPIO_ADDR, PIGPIO_PORT)
+ *
+ * 1. system("pigs s 17 N") — как servo_gui делал раньше: sh + pigs на команду.
+ * 2. Клиент, синхронно: команда и ожидание ответа.
+ * 3. Клиент, конвейер: пачки по 32 команды одним write, затем ответы.
+ *
+ * Для каждого способа — команд в секунду, задержка (среднее, p50, p99,
+ * максимум) и процессорное время на команду, включая дочерние процессы.
+ *
+ * Затем имитируется перетаскивание ползунка: 1 с событий value-changed
+ * с частотой DRAG_HZ — каждое событие командой и через servo_output
+ * (не чаще раза за кадр 20 мс). Сравниваются команды, write и процессор.
+ *
+ * Наконец, обновление всех каналов в кадре для 1..16 сервоприводов:
+ * командой SERVO на канал (конвейером, один write) и одной волной
+ * (servo_wave). Для каждого числа каналов — команд и write на кадр,
+ * время обновления и процессор. Кадры идут с периодом 20 мс, как у
+ * выходного каскада: волна с _SYNC переключается только в конце цикла.
+ * Без железа замер идёт через заглушку: make bench запускает fake_pigpiod.
+ */
+
+#define SERVO_GPIO 17
+#define BATCH 32
+#define DRAG_HZ 1000
+#define SCALE_FRAMES 25 // Кадров на каждое число каналов (0,5 с)
+
+// GPIO для замера масштабирования: свободные на 40-контактном разъёме
+static const unsigned scale_gpios[] = {4, 5, 6, 12, 13, 16, 17, 18,
+                                       19, 20, 21, 22, 23, 24, 25, 26};
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Процессорное время своё и дочерних процессов, мкс
+static double cpu_us(void) {
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    return (self.ru_utime.tv_sec + self.ru_stime.tv_sec + children.ru_utime.tv_sec +
+            children.ru_stime.tv_sec) * 1e6 +
+           self.ru_utime.tv_usec + self.ru_stime.tv_usec + children.ru_utime.tv_usec +
+           children.ru_stime.tv_usec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// lat — задержка каждой команды (для конвейера — пачки, делённой на её размер)
+static void report(const char *name, int n, double wall_us, double cpu, double *lat, int nlat) {
+    double sum = 0;
+    for (int i = 0; i < nlat; i++)
+        sum += lat[i];
+    qsort(lat, nlat, sizeof(lat[0]), cmp_double);
+    printf("%-22s %7d %12.0f %9.1f %9.1f %9.1f %9.1f %10.1f\n", name, n, n * 1e6 / wall_us,
+           sum / nlat, lat[nlat / 2], lat[nlat * 99 / 100], lat[nlat - 1], cpu / n);
+}
+
+static int pulse(int i) {
+    return 500 + (i * 10) % 2001;
+}
+
+static void sleep_until(struct timespec *t, long ns) {
+    t->tv_nsec += ns;
+    while (t->tv_nsec >= 1000000000L) {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000L;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL);
+}
+
+// Перетаскивание: DRAG_HZ событий в течение секунды. out == NULL —
+// команда на каждое событие, как без выходного каскада; direct == 0 и
+// out == NULL — только сами события (процессор цикла замера).
+static void drag(const char *name, pigpiod_t *pi, servo_output_t *out, int direct) {
+    pigpiod_stats_t before, after;
+    struct timespec t;
+
+    pigpiod_sync(pi);
+    pigpiod_get_stats(pi, &before);
+    double c0 = cpu_us();
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    for (int i = 0; i < DRAG_HZ; i++) {
+        int pw = 500 + i * 2000 / DRAG_HZ;
+        if (out) {
+            servo_output_set(out, SERVO_GPIO, pw);
+        } else if (direct) {
+            pigpiod_send_servo(pi, SERVO_GPIO, pw);
+            pigpiod_flush(pi);
+            pigpiod_poll(pi);
+        }
+        sleep_until(&t, 1000000000L / DRAG_HZ);
+    }
+    sleep_until(&t, 2L * SERVO_FRAME_US * 1000); // Последний кадр каскада
+    pigpiod_sync(pi);
+    double cpu = cpu_us() - c0;
+    pigpiod_get_stats(pi, &after);
+
+    printf("%-22s %7d %9lu %9lu %12.0f", name, DRAG_HZ, after.sent - before.sent,
+           after.writes - before.writes, cpu);
+    if (out) {
+        servo_output_stats_t st;
+        servo_output_get_stats(out, &st);
+        printf("  (dropped %lu, max lag %lu us)", st.dropped, st.max_lag_us);
+    }
+    printf("\n");
+}
+
+// SCALE_FRAMES кадров, в каждом меняются все nch каналов; wave == NULL —
+// командами SERVO
+static void frames(const char *name, pigpiod_t *pi, servo_wave_t *wave, int nch) {
+    unsigned pw[SERVO_WAVE_GPIOS] = {0};
+    uint32_t mask = 0;
+    pigpiod_stats_t before, after;
+    struct timespec t;
+    double busy = 0;
+    int errors = 0;
+
+    for (int c = 0; c < nch; c++)
+        mask |= 1u << scale_gpios[c];
+    pigpiod_sync(pi);
+    pigpiod_get_stats(pi, &before);
+    double c0 = cpu_us();
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    for (int f = 0; f < SCALE_FRAMES; f++) {
+        for (int c = 0; c < nch; c++)
+            pw[scale_gpios[c]] = 500 + (f * 80 + c * 125) % 2001;
+        double t0 = now_us();
+        if (wave) {
+            if (servo_wave_update(wave, pi, pw, mask) != 0)
+                errors++;
+        } else {
+            for (int c = 0; c < nch; c++)
+                pigpiod_send_servo(pi, scale_gpios[c], pw[scale_gpios[c]]);
+            if (pigpiod_sync(pi) < 0)
+                errors++;
+        }
+        busy += now_us() - t0;
+        sleep_until(&t, SERVO_FRAME_US * 1000L);
+    }
+    double cpu = cpu_us() - c0;
+    pigpiod_get_stats(pi, &after);
+
+    printf("%-22s %8d %10.1f %12.1f %9.1f %12.1f", name, nch,
+           (double)(after.sent - before.sent) / SCALE_FRAMES,
+           (double)(after.writes - before.writes) / SCALE_FRAMES, busy / SCALE_FRAMES,
+           cpu / SCALE_FRAMES);
+    if (errors)
+        printf("  (%d failed)", errors);
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    char cmd[64];
+
+    if (n < BATCH)
+        n = BATCH;
+    double *lat = malloc(n * sizeof(*lat));
+    pigpiod_t *pi = pigpiod_open(NULL, NULL);
+    if (!lat || !pi) {
+        fprintf(stderr, "Failed to connect to pigpiod (PIGPIO_ADDR/PIGPIO_PORT)\n");
+        return 1;
+    }
+
+    printf("%-22s %7s %12s %9s %9s %9s %9s %10s\n", "method", "cmds", "cmds/s", "mean us",
+           "p50 us", "p99 us", "max us", "cpu us/cmd");
+
+    // 1. system(): процесс на команду. Он медленный, поэтому команд в 10 раз меньше.
+    int ns = n / 10 > 10 ? n / 10 : 10;
+    snprintf(cmd, sizeof(cmd), "pigs s %d %d >/dev/null 2>&1", SERVO_GPIO, pulse(0));
+    int st = system(cmd);
+    // pigs не установлен: замеряем хотя бы sh + exec пустой программы
+    int have_pigs = !(WIFEXITED(st) && WEXITSTATUS(st) == 127);
+    double c0 = cpu_us(), t0 = now_us();
+    for (int i = 0; i < ns; i++) {
+        if (have_pigs)
+            snprintf(cmd, sizeof(cmd), "pigs s %d %d >/dev/null 2>&1", SERVO_GPIO, pulse(i));
+        else
+            snprintf(cmd, sizeof(cmd), "true");
+        double t = now_us();
+        system(cmd);
+        lat[i] = now_us() - t;
+    }
+    report(have_pigs ? "system(\"pigs s ...\")" : "system(\"true\") (no pigs)", ns,
+           now_us() - t0, cpu_us() - c0, lat, ns);
+
+    // 2. Клиент, синхронно
+    int errors = 0;
+    c0 = cpu_us();
+    t0 = now_us();
+    for (int i = 0; i < n; i++) {
+        double t = now_us();
+        if (pigpiod_servo(pi, SERVO_GPIO, pulse(i)) < 0)
+            errors++;
+        lat[i] = now_us() - t;
+    }
+    report("socket, sync", n, now_us() - t0, cpu_us() - c0, lat, n);
+
+    // 3. Клиент, конвейер
+    int nb = n / BATCH;
+    c0 = cpu_us();
+    t0 = now_us();
+    for (int b = 0; b < nb; b++) {
+        double t = now_us();
+        for (int i = 0; i < BATCH; i++)
+            pigpiod_send_servo(pi, SERVO_GPIO, pulse(b * BATCH + i));
+        if (pigpiod_sync(pi) < 0)
+            errors++;
+        lat[b] = (now_us() - t) / BATCH;
+    }
+    report("socket, pipelined x32", nb * BATCH, now_us() - t0, cpu_us() - c0, lat, nb);
+
+    // Перетаскивание ползунка
+    printf("\n%-22s %7s %9s %9s %12s\n", "drag, 1 s", "events", "commands", "writes", "cpu us");
+    drag("events only", pi, NULL, 0);
+    drag("every event", pi, NULL, 1);
+    servo_output_t *out = servo_output_new(pi, SERVO_FRAME_US);
+    drag("servo_output, 20 ms", pi, out, 0);
+    servo_output_free(out);
+
+    // Масштабирование по числу каналов
+    printf("\n%-22s %8s %10s %12s %9s %12s\n", "frame update", "channels", "cmds/frame",
+           "writes/frame", "us/frame", "cpu us/frame");
+    servo_wave_t *wave = servo_wave_new(SERVO_FRAME_US);
+    for (int nch = 1; nch <= 16; nch *= 2)
+        frames("servo commands", pi, NULL, nch);
+    for (int nch = 1; nch <= 16; nch *= 2)
+        frames("one wave", pi, wave, nch);
+    servo_wave_stats_t ws;
+    servo_wave_get_stats(wave, &ws);
+    printf("waves: %lu started, %lu deleted, %lu deferred, %lu errors\n", ws.updates, ws.deleted,
+           ws.skipped, ws.errors);
+    servo_wave_stop(wave, pi);
+    servo_wave_free(wave);
+    // SERVO 0 освобождает выходы после замера командами
+    for (int c = 0; c < 16; c++)
+        pigpiod_send_servo(pi, scale_gpios[c], 0);
+    pigpiod_sync(pi);
+
+    // Ошибка сообщается по каждой команде: неверный импульс
+    int res = pigpiod_servo(pi, SERVO_GPIO, 3000);
+    printf("servo 3000 us -> %d (%s)\n", res, pigpiod_strerror(res));
+
+    pigpiod_stats_t s;
+    pigpiod_get_stats(pi, &s);
+    printf("client: %lu sent, %lu replies, %lu errors, %lu writes\n", s.sent, s.replies,
+           s.errors, s.writes);
+    pigpiod_close(pi);
+    free(lat);
+    return errors || res >= 0 ? 1 : 0;
+}
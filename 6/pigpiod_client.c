@@ -0,0 +1,373 @@
+#include "pigpiod_client.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Команда или ответ pigpiod; в ответе p3 — результат
+struct pigpiod_msg {
+    uint32_t cmd, p1, p2, p3;
+};
+
+// Команда в пути: заголовок и куда положить результат
+struct pigpiod_req {
+    struct pigpiod_msg msg;
+    int *res;
+};
+
+// Ответов, читаемых одним recv
+#define PIGPIOD_RX_MSGS 64
+
+struct pigpiod {
+    int fd;
+    pthread_mutex_t lock;
+    int broken; // Соединение потеряно, все вызовы возвращают PIGPIOD_ERR_IO
+
+    // Команды без ответа — кольцо; последние unsent ещё в буфере, не записаны
+    struct pigpiod_req ring[PIGPIOD_PIPELINE_MAX];
+    int head, count, unsent;
+
+    // Незаписанные команды вместе с расширениями, как они уйдут в сокет
+    uint8_t tx[PIGPIOD_PIPELINE_MAX * sizeof(struct pigpiod_msg) + PIGPIOD_EXT_MAX];
+    size_t tx_len;
+
+    // Недочитанный хвост ответов
+    uint8_t rx[PIGPIOD_RX_MSGS * sizeof(struct pigpiod_msg)];
+    size_t rx_len;
+
+    int last_res;    // Результат последнего прочитанного ответа
+    int first_error; // Первая ошибка с начала pigpiod_sync
+
+    pigpiod_error_cb error_cb;
+    void *user_data;
+    pigpiod_stats_t stats;
+};
+
+static int pigpiod_connect(const char *addr, const char *port) {
+    if (addr[0] == '/') {
+        struct sockaddr_un sa = {.sun_family = AF_UNIX};
+        if (strlen(addr) >= sizeof(sa.sun_path))
+            return -1;
+        strcpy(sa.sun_path, addr);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM}, *res, *ai;
+    if (getaddrinfo(addr, port, &hints, &res) != 0)
+        return -1;
+    int fd = -1;
+    for (ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        // Команды маленькие: без Nagle каждая уходит сразу
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+pigpiod_t *pigpiod_open(const char *addr, const char *port) {
+    if (!addr)
+        addr = getenv("PIGPIO_ADDR");
+    if (!addr || !*addr)
+        addr = PIGPIOD_DEFAULT_ADDR;
+    if (!port)
+        port = getenv("PIGPIO_PORT");
+    if (!port || !*port)
+        port = PIGPIOD_DEFAULT_PORT;
+
+    int fd = pigpiod_connect(addr, port);
+    if (fd < 0)
+        return NULL;
+
+    pigpiod_t *pi = calloc(1, sizeof(*pi));
+    if (!pi) {
+        close(fd);
+        return NULL;
+    }
+    pi->fd = fd;
+    pthread_mutex_init(&pi->lock, NULL);
+    return pi;
+}
+
+void pigpiod_close(pigpiod_t *pi) {
+    if (!pi)
+        return;
+    close(pi->fd);
+    pthread_mutex_destroy(&pi->lock);
+    free(pi);
+}
+
+int pigpiod_fd(pigpiod_t *pi) {
+    return pi->fd;
+}
+
+void pigpiod_set_error_cb(pigpiod_t *pi, pigpiod_error_cb cb, void *user_data) {
+    pthread_mutex_lock(&pi->lock);
+    pi->error_cb = cb;
+    pi->user_data = user_data;
+    pthread_mutex_unlock(&pi->lock);
+}
+
+// ===== Под блокировкой =====
+
+static int pigpiod_fail(pigpiod_t *pi) {
+    pi->broken = 1;
+    return PIGPIOD_ERR_IO;
+}
+
+// Записывает буферизованные команды одним write (или несколькими,
+// если сокет принял не всё)
+static int do_flush(pigpiod_t *pi) {
+    if (pi->broken)
+        return PIGPIOD_ERR_IO;
+    if (pi->unsent == 0)
+        return 0;
+
+    const uint8_t *p = pi->tx;
+    size_t left = pi->tx_len;
+    while (left > 0) {
+        ssize_t n = send(pi->fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return pigpiod_fail(pi);
+        pi->stats.writes++;
+        p += n;
+        left -= n;
+    }
+    pi->stats.sent += pi->unsent;
+    pi->unsent = 0;
+    pi->tx_len = 0;
+    return 0;
+}
+
+// Разбирает целые ответы из rx
+static int handle_replies(pigpiod_t *pi) {
+    size_t off = 0;
+    int handled = 0;
+
+    while (pi->rx_len - off >= sizeof(struct pigpiod_msg)) {
+        struct pigpiod_msg reply, *req;
+        memcpy(&reply, pi->rx + off, sizeof(reply));
+        off += sizeof(reply);
+
+        if (pi->count - pi->unsent <= 0)
+            return pigpiod_fail(pi); // Ответ без запроса
+        req = &pi->ring[pi->head].msg;
+        if (reply.cmd != req->cmd)
+            return pigpiod_fail(pi);
+
+        int res = (int32_t)reply.p3;
+        pi->last_res = res;
+        if (pi->ring[pi->head].res)
+            *pi->ring[pi->head].res = res;
+        pi->stats.replies++;
+        if (res < 0) {
+            pi->stats.errors++;
+            if (!pi->first_error)
+                pi->first_error = res;
+            if (pi->error_cb)
+                pi->error_cb(pi, req->cmd, req->p1, req->p2, res, pi->user_data);
+        }
+        pi->head = (pi->head + 1) % PIGPIOD_PIPELINE_MAX;
+        pi->count--;
+        handled++;
+    }
+    memmove(pi->rx, pi->rx + off, pi->rx_len - off);
+    pi->rx_len -= off;
+    return handled;
+}
+
+// Читает ответы; block — ждать хотя бы одного, если ничего не пришло
+static int read_replies(pigpiod_t *pi, int block) {
+    if (pi->broken)
+        return PIGPIOD_ERR_IO;
+    if (pi->count - pi->unsent == 0) {
+        // Ответов не ждём, но сокет мог закрыться: иначе наблюдатель за
+        // дескриптором (G_IO_HUP) срабатывал бы без конца
+        uint8_t byte;
+        if (!block && recv(pi->fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) == 0)
+            return pigpiod_fail(pi);
+        return 0;
+    }
+
+    // Больше, чем ждём, не читаем: в сокете не может быть лишнего
+    size_t want = (pi->count - pi->unsent) * sizeof(struct pigpiod_msg) - pi->rx_len;
+    if (want > sizeof(pi->rx) - pi->rx_len)
+        want = sizeof(pi->rx) - pi->rx_len;
+    ssize_t n;
+    do {
+        n = recv(pi->fd, pi->rx + pi->rx_len, want, block ? 0 : MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && !block && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    if (n <= 0)
+        return pigpiod_fail(pi);
+    pi->rx_len += n;
+    return handle_replies(pi);
+}
+
+static int do_send(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2, const void *ext,
+                   unsigned len, int *res) {
+    if (res)
+        *res = PIGPIOD_ERR_IO; // Пока нет ответа
+    if (pi->broken)
+        return PIGPIOD_ERR_IO;
+    if (len > PIGPIOD_EXT_MAX)
+        return PIGPIOD_ERR_EXT;
+    // Нет места в буфере: сначала отправляем накопленное
+    if (pi->tx_len + sizeof(struct pigpiod_msg) + len > sizeof(pi->tx)) {
+        int status = do_flush(pi);
+        if (status < 0)
+            return status;
+    }
+    // Конвейер полон: отправляем буфер и ждём, пока освободится место
+    while (pi->count == PIGPIOD_PIPELINE_MAX) {
+        int status = do_flush(pi);
+        if (status == 0)
+            status = read_replies(pi, 1);
+        if (status < 0)
+            return status;
+    }
+    struct pigpiod_req *r = &pi->ring[(pi->head + pi->count) % PIGPIOD_PIPELINE_MAX];
+    r->msg.cmd = cmd;
+    r->msg.p1 = p1;
+    r->msg.p2 = p2;
+    r->msg.p3 = len;
+    r->res = res;
+    memcpy(pi->tx + pi->tx_len, &r->msg, sizeof(r->msg));
+    pi->tx_len += sizeof(r->msg);
+    if (len) {
+        memcpy(pi->tx + pi->tx_len, ext, len);
+        pi->tx_len += len;
+    }
+    pi->count++;
+    pi->unsent++;
+    return 0;
+}
+
+static int do_sync(pigpiod_t *pi) {
+    int status = do_flush(pi);
+    while (status >= 0 && pi->count > 0)
+        status = read_replies(pi, 1);
+    return status < 0 ? status : 0;
+}
+
+// ===== Открытые функции =====
+
+int pigpiod_command(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2) {
+    return pigpiod_command_ext(pi, cmd, p1, p2, NULL, 0);
+}
+
+int pigpiod_command_ext(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2, const void *ext,
+                        unsigned len) {
+    pthread_mutex_lock(&pi->lock);
+    int status = do_send(pi, cmd, p1, p2, ext, len, NULL);
+    if (status == 0)
+        status = do_sync(pi);
+    if (status == 0)
+        status = pi->last_res; // Команда была последней в конвейере
+    pthread_mutex_unlock(&pi->lock);
+    return status;
+}
+
+int pigpiod_servo(pigpiod_t *pi, unsigned gpio, unsigned pulsewidth) {
+    return pigpiod_command(pi, PIGPIOD_CMD_SERVO, gpio, pulsewidth);
+}
+
+int pigpiod_send(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2) {
+    return pigpiod_send_ext(pi, cmd, p1, p2, NULL, 0, NULL);
+}
+
+int pigpiod_send_ext(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2, const void *ext,
+                     unsigned len, int *res) {
+    pthread_mutex_lock(&pi->lock);
+    int status = do_send(pi, cmd, p1, p2, ext, len, res);
+    pthread_mutex_unlock(&pi->lock);
+    return status;
+}
+
+int pigpiod_send_servo(pigpiod_t *pi, unsigned gpio, unsigned pulsewidth) {
+    return pigpiod_send(pi, PIGPIOD_CMD_SERVO, gpio, pulsewidth);
+}
+
+int pigpiod_flush(pigpiod_t *pi) {
+    pthread_mutex_lock(&pi->lock);
+    int status = do_flush(pi);
+    pthread_mutex_unlock(&pi->lock);
+    return status;
+}
+
+int pigpiod_poll(pigpiod_t *pi) {
+    pthread_mutex_lock(&pi->lock);
+    int status = read_replies(pi, 0);
+    pthread_mutex_unlock(&pi->lock);
+    return status;
+}
+
+int pigpiod_sync(pigpiod_t *pi) {
+    pthread_mutex_lock(&pi->lock);
+    pi->first_error = 0;
+    int status = do_sync(pi);
+    if (status == 0)
+        status = pi->first_error;
+    pthread_mutex_unlock(&pi->lock);
+    return status;
+}
+
+int pigpiod_pending(pigpiod_t *pi) {
+    pthread_mutex_lock(&pi->lock);
+    int n = pi->count;
+    pthread_mutex_unlock(&pi->lock);
+    return n;
+}
+
+void pigpiod_get_stats(pigpiod_t *pi, pigpiod_stats_t *st) {
+    pthread_mutex_lock(&pi->lock);
+    *st = pi->stats;
+    pthread_mutex_unlock(&pi->lock);
+}
+
+const char *pigpiod_strerror(int res) {
+    switch (res) {
+        case 0: return "OK";
+        case PIGPIOD_ERR_IO: return "connection to pigpiod lost";
+        case PIGPIOD_ERR_EXT: return "command extension too long";
+        case -2: return "bad gpio (PI_BAD_USER_GPIO)";
+        case -3: return "bad gpio (PI_BAD_GPIO)";
+        case -4: return "bad mode (PI_BAD_MODE)";
+        case -5: return "bad level (PI_BAD_LEVEL)";
+        case -7: return "bad pulsewidth (PI_BAD_PULSEWIDTH)";
+        case -8: return "bad dutycycle (PI_BAD_DUTYCYCLE)";
+        case -33: return "bad wave mode (PI_BAD_WAVE_MODE)";
+        case -41: return "gpio not permitted (PI_NOT_PERMITTED)";
+        case -36: return "too many pulses (PI_TOO_MANY_PULSES)";
+        case -66: return "bad wave id (PI_BAD_WAVE_ID)";
+        case -67: return "too many DMA control blocks (PI_TOO_MANY_CBS)";
+        case -69: return "empty waveform (PI_EMPTY_WAVEFORM)";
+        case -70: return "no waveform id (PI_NO_WAVEFORM_ID)";
+        case -93: return "not a servo gpio (PI_NOT_SERVO_GPIO)";
+        default: return res < 0 ? "pigpio error" : "OK";
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef PIGPIOD_CLIENT_H
+#define PIGPIOD_CLIENT_H
+
+// Клиент демона pigpiod по его сокетному протоколу (как pigs, но без
+// запуска процесса на каждую команду). Команда — 16 байт
+// {cmd, p1, p2, p3}, ответ — 16 байт {cmd, p1, p2, res}, все поля uint32
+// в порядке байтов процессора; res < 0 — код ошибки pigpio.
+//
+// Соединение одно на всё время работы. Команды можно отправлять
+// конвейером: pigpiod_send только кладёт команду в буфер, pigpiod_flush
+// отправляет накопленное одним write, ответы читаются позже
+// (pigpiod_poll без ожидания или pigpiod_sync с ожиданием).
+// Команда может нести расширение — p3 байт данных после заголовка
+// (импульсы WVAG и т. п.). Команды с расширенным ответом (I2CRD,
+// SERRB и т. п.) не поддерживаются.
+//
+// Все функции можно вызывать из разных потоков.
+
+// Адрес и порт по умолчанию; переменные окружения PIGPIO_ADDR и
+// PIGPIO_PORT, как у pigs, их переопределяют. Адрес, начинающийся с '/',
+// — путь Unix-сокета (например, у fake_pigpiod).
+#define PIGPIOD_DEFAULT_ADDR "localhost"
+#define PIGPIOD_DEFAULT_PORT "8888"
+
+// Номера команд pigpiod
+#define PIGPIOD_CMD_MODES 0  // p1 = gpio, p2 = режим
+#define PIGPIOD_CMD_WRITE 4  // p1 = gpio, p2 = уровень
+#define PIGPIOD_CMD_PWM   5  // p1 = gpio, p2 = скважность 0..255
+#define PIGPIOD_CMD_SERVO 8  // p1 = gpio, p2 = импульс 0 или 500..2500 мкс
+#define PIGPIOD_CMD_TICK  16 // res = тик pigpio, мкс
+#define PIGPIOD_CMD_WVAG  28 // Расширение — импульсы {on, off, delay}; res = импульсов в волне
+#define PIGPIOD_CMD_WVHLT 33 // Остановить волну
+#define PIGPIOD_CMD_WVCRE 49 // Создать волну из добавленных импульсов; res = id волны
+#define PIGPIOD_CMD_WVDEL 50 // p1 = id волны
+#define PIGPIOD_CMD_WVNEW 53 // Начать новую волну (без удаления созданных)
+#define PIGPIOD_CMD_WVTXM 100 // p1 = id волны, p2 = режим PIGPIOD_WAVE_MODE_*
+#define PIGPIOD_CMD_WVTAT 101 // res = id передаваемой волны
+
+// Режимы WVTXM; _SYNC — переключиться в конце цикла текущей волны
+#define PIGPIOD_WAVE_MODE_ONE_SHOT 0
+#define PIGPIOD_WAVE_MODE_REPEAT 1
+#define PIGPIOD_WAVE_MODE_ONE_SHOT_SYNC 2
+#define PIGPIOD_WAVE_MODE_REPEAT_SYNC 3
+
+// Ответы WVTAT, не являющиеся id волны
+#define PIGPIOD_NO_TX_WAVE 9999
+#define PIGPIOD_WAVE_NOT_FOUND 9998
+
+// Ошибка соединения (не код pigpio): демон недоступен или закрыл сокет
+#define PIGPIOD_ERR_IO (-10000)
+// Расширение длиннее PIGPIOD_EXT_MAX (команда не отправлена)
+#define PIGPIOD_ERR_EXT (-10001)
+
+// Наибольшее расширение одной команды, байт
+#define PIGPIOD_EXT_MAX 4096
+
+// Команд в пути: больше pigpiod_send сначала дожидается ответов
+#define PIGPIOD_PIPELINE_MAX 256
+
+typedef struct pigpiod pigpiod_t;
+
+typedef struct {
+    unsigned long sent;    // Команд отправлено
+    unsigned long replies; // Ответов получено
+    unsigned long errors;  // Ответов с res < 0
+    unsigned long writes;  // Системных вызовов write
+} pigpiod_stats_t;
+
+// Вызывается для каждого ответа с ошибкой (res < 0) из потока, который
+// читал ответы. Вызывать функции клиента из него нельзя.
+typedef void (*pigpiod_error_cb)(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2,
+                                 int res, void *user_data);
+
+// addr/port == NULL — из окружения или по умолчанию. NULL при ошибке.
+pigpiod_t *pigpiod_open(const char *addr, const char *port);
+void pigpiod_close(pigpiod_t *pi);
+// Дескриптор сокета, например для g_unix_fd_add (готов к чтению — есть ответы)
+int pigpiod_fd(pigpiod_t *pi);
+void pigpiod_set_error_cb(pigpiod_t *pi, pigpiod_error_cb cb, void *user_data);
+
+// Синхронно: отправляет команду, дожидается её ответа (и всех ранее
+// отправленных) и возвращает res или PIGPIOD_ERR_IO
+int pigpiod_command(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2);
+int pigpiod_servo(pigpiod_t *pi, unsigned gpio, unsigned pulsewidth);
+// То же с расширением из len байт
+int pigpiod_command_ext(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2, const void *ext,
+                        unsigned len);
+
+// Конвейер: команда в буфер (0 или PIGPIOD_ERR_IO)
+int pigpiod_send(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2);
+int pigpiod_send_servo(pigpiod_t *pi, unsigned gpio, unsigned pulsewidth);
+// Конвейер с расширением (ext/len) и местом для результата: *res
+// получает ответ демона, когда тот прочитан (самое позднее — в
+// pigpiod_sync), до того — PIGPIOD_ERR_IO. ext и res могут быть NULL.
+// res должен оставаться доступным до прочтения ответа.
+int pigpiod_send_ext(pigpiod_t *pi, unsigned cmd, unsigned p1, unsigned p2, const void *ext,
+                     unsigned len, int *res);
+// Отправляет буфер одним write
+int pigpiod_flush(pigpiod_t *pi);
+// Читает пришедшие ответы без ожидания; возвращает их число или PIGPIOD_ERR_IO
+int pigpiod_poll(pigpiod_t *pi);
+// Отправляет буфер и ждёт все ответы. Возвращает 0, первый код ошибки
+// среди ответов или PIGPIOD_ERR_IO.
+int pigpiod_sync(pigpiod_t *pi);
+// Команд, отправленных или буферизованных, но ещё без ответа
+int pigpiod_pending(pigpiod_t *pi);
+
+void pigpiod_get_stats(pigpiod_t *pi, pigpiod_stats_t *st);
+// Текст для кода ошибки pigpio или PIGPIOD_ERR_IO
+const char *pigpiod_strerror(int res);
+
+#endif // PIGPIOD_CLIENT_H
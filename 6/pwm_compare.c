@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "hw_pwm.h"
+#include "pigpiod_client.h"
+#ifdef USE_PIGPIO
+#include <pigpio.h>
+#endif
+
+/**
+ * @file pwm_compare.c
+ * @brief Сравнение способов формировать ШИМ: что выбрать для установки.
+ *
+ *   ./pwm_compare [GPIO [секунд простоя [обновлений]]]   (по умолчанию 18 5 2000)
+ *
+ * Способы:
+ *   none    — ничего не запущено (фон системы);
+ *   hw      — аппаратный ШИМ ядра через sysfs (hw_pwm.c), только GPIO12/13/18/19;
+ *   pigpiod — команды демону pigpiod по сокету (как servo_gui);
+ *   pigpio  — библиотека pigpio внутри процесса (как rgb_pwm_gui), если
+ *             собрано с PIGPIO=1; запускать через sudo без pigpiod.
+ *
+ * Для каждого способа — процессор в простое (импульс задан, обновлений
+ * нет) за заданное время: сам процесс, процесс pigpiod (если запущен) и
+ * вся система по /proc/stat, в процентах одного ядра. Затем задержка
+ * обновления: столько-то смен импульса сервопривода подряд, время вызова
+ * (среднее, p50, p99, максимум) и сколько записей/команд реально ушло.
+ * Недоступный способ пропускается с причиной.
+ */
+
+#define FRAME_NS 20000000UL // Кадр сервопривода, 50 Гц
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double self_cpu_us(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + ru.ru_utime.tv_usec +
+           ru.ru_stime.tv_usec;
+}
+
+// Процессорное время процесса pigpiod, мкс; < 0 — демон не найден
+static double pigpiod_cpu_us(void) {
+    DIR *d = opendir("/proc");
+    struct dirent *e;
+    double res = -1;
+
+    if (!d)
+        return -1;
+    while ((e = readdir(d)) && res < 0) {
+        char path[288], comm[32] = "";
+        if (e->d_name[0] < '0' || e->d_name[0] > '9')
+            continue;
+        snprintf(path, sizeof(path), "/proc/%s/comm", e->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            continue;
+        if (fgets(comm, sizeof(comm), f) && strcmp(comm, "pigpiod\n") == 0) {
+            unsigned long utime, stime;
+            FILE *st;
+            snprintf(path, sizeof(path), "/proc/%s/stat", e->d_name);
+            // Поля 14 и 15 — utime и stime в тиках; имя процесса без пробелов
+            if ((st = fopen(path, "r"))) {
+                if (fscanf(st, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                           &utime, &stime) == 2)
+                    res = (utime + stime) * 1e6 / sysconf(_SC_CLK_TCK);
+                fclose(st);
+            }
+        }
+        fclose(f);
+    }
+    closedir(d);
+    return res;
+}
+
+// Занятое и всё время системы по /proc/stat, в тиках
+static void system_ticks(double *busy, double *total) {
+    unsigned long long v[8] = {0};
+    FILE *f = fopen("/proc/stat", "r");
+
+    *busy = *total = 0;
+    if (!f)
+        return;
+    if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &v[0], &v[1], &v[2], &v[3],
+               &v[4], &v[5], &v[6], &v[7]) == 8) {
+        for (int i = 0; i < 8; i++)
+            *total += v[i];
+        *busy = *total - v[3] - v[4]; // Без idle и iowait
+    }
+    fclose(f);
+}
+
+// Способ: set задаёт импульс (мкс), count — сколько записей/команд ушло
+typedef struct {
+    const char *name;
+    int (*set)(void *ctx, unsigned pulsewidth);
+    unsigned long (*count)(void *ctx);
+    void *ctx;
+} backend_t;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void measure(const backend_t *b, int idle_s, int updates, double *lat) {
+    double ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    double busy0, total0, busy1, total1;
+
+    if (b->set)
+        b->set(b->ctx, 1500);
+
+    // Простой
+    double s0 = self_cpu_us(), d0 = pigpiod_cpu_us(), t0 = now_us();
+    system_ticks(&busy0, &total0);
+    sleep(idle_s);
+    system_ticks(&busy1, &total1);
+    double wall = now_us() - t0;
+    double self = (self_cpu_us() - s0) * 100 / wall;
+    double d1 = pigpiod_cpu_us();
+    double sys = total1 > total0 ? (busy1 - busy0) * 100 * ncpu / (total1 - total0) : 0;
+
+    printf("%-8s %9.2f ", b->name, self);
+    if (d0 >= 0 && d1 >= 0)
+        printf("%11.2f ", (d1 - d0) * 100 / wall);
+    else
+        printf("%11s ", "-");
+    printf("%10.2f", sys);
+    if (!b->set) {
+        printf("\n");
+        return;
+    }
+
+    // Обновления: импульс сервопривода туда-обратно, каждое значение новое
+    unsigned long c0 = b->count(b->ctx);
+    int errors = 0;
+    for (int i = 0; i < updates; i++) {
+        double t = now_us();
+        if (b->set(b->ctx, 500 + (i * 7) % 2001) < 0)
+            errors++;
+        lat[i] = now_us() - t;
+    }
+    unsigned long writes = b->count(b->ctx) - c0;
+    double sum = 0;
+    for (int i = 0; i < updates; i++)
+        sum += lat[i];
+    qsort(lat, updates, sizeof(lat[0]), cmp_double);
+    printf(" %8d %9.1f %8.1f %8.1f %8.1f %8lu", updates, sum / updates, lat[updates / 2],
+           lat[updates * 99 / 100], lat[updates - 1], writes);
+    if (errors)
+        printf("  (%d failed)", errors);
+    printf("\n");
+}
+
+// --- hw: аппаратный ШИМ ---
+
+static int hw_set(void *ctx, unsigned pw) {
+    return hw_pwm_set_duty(ctx, pw * 1000UL);
+}
+
+static unsigned long hw_count(void *ctx) {
+    return hw_pwm_writes(ctx);
+}
+
+// --- pigpiod: синхронная команда SERVO, как у выходного каскада без конвейера ---
+
+static unsigned pigpiod_gpio;
+
+static int pigpiod_set(void *ctx, unsigned pw) {
+    return pigpiod_servo(ctx, pigpiod_gpio, pw);
+}
+
+static unsigned long pigpiod_count(void *ctx) {
+    pigpiod_stats_t st;
+    pigpiod_get_stats(ctx, &st);
+    return st.sent;
+}
+
+#ifdef USE_PIGPIO
+// --- pigpio: библиотека в процессе ---
+
+static unsigned pigpio_gpio;
+static unsigned long pigpio_calls;
+
+static int pigpio_set(void *ctx, unsigned pw) {
+    pigpio_calls++;
+    return gpioServo(pigpio_gpio, pw);
+}
+
+static unsigned long pigpio_count(void *ctx) {
+    return pigpio_calls;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    unsigned gpio = argc > 1 ? atoi(argv[1]) : 18;
+    int idle_s = argc > 2 ? atoi(argv[2]) : 5;
+    int updates = argc > 3 ? atoi(argv[3]) : 2000;
+
+    if (idle_s < 1)
+        idle_s = 1;
+    if (updates < 1)
+        updates = 1;
+    double *lat = malloc(updates * sizeof(*lat));
+    if (!lat)
+        return 1;
+
+    printf("GPIO%u, idle %d s, %d updates; cpu in %% of one core\n\n", gpio, idle_s, updates);
+    printf("%-8s %9s %11s %10s %8s %9s %8s %8s %8s %8s\n", "backend", "self cpu", "pigpiod cpu",
+           "system", "updates", "mean us", "p50 us", "p99 us", "max us", "writes");
+
+    backend_t none = {"none", NULL, NULL, NULL};
+    measure(&none, idle_s, updates, lat);
+
+    hw_pwm_t *hw = hw_pwm_open(gpio, FRAME_NS);
+    if (hw) {
+        backend_t b = {"hw", hw_set, hw_count, hw};
+        measure(&b, idle_s, updates, lat);
+        hw_pwm_close(hw);
+    } else {
+        printf("%-8s skipped: %s\n", "hw",
+               hw_pwm_channel(gpio) < 0 ? "no hardware PWM channel on this GPIO"
+                                        : "pwm sysfs not available (dtoverlay=pwm-2chan?)");
+    }
+
+    pigpiod_t *pi = pigpiod_open(NULL, NULL);
+    if (pi) {
+        pigpiod_gpio = gpio;
+        backend_t b = {"pigpiod", pigpiod_set, pigpiod_count, pi};
+        measure(&b, idle_s, updates, lat);
+        pigpiod_servo(pi, gpio, 0);
+        pigpiod_close(pi);
+    } else {
+        printf("%-8s skipped: daemon not reachable (PIGPIO_ADDR/PIGPIO_PORT)\n", "pigpiod");
+    }
+
+#ifdef USE_PIGPIO
+    if (gpioInitialise() >= 0) {
+        pigpio_gpio = gpio;
+        backend_t b = {"pigpio", pigpio_set, pigpio_count, NULL};
+        measure(&b, idle_s, updates, lat);
+        gpioServo(gpio, 0);
+        gpioTerminate();
+    } else {
+        printf("%-8s skipped: gpioInitialise failed (root? pigpiod running?)\n", "pigpio");
+    }
+#endif
+
+    free(lat);
+    return 0;
+}
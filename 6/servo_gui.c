@@ -1,54 +1,289 @@
 #include <gtk/gtk.h>    // Включаем заголовочный файл для библиотеки GTK+ (для создания графического интерфейса пользователя)
-#include <stdlib.h>     // Включаем заголовочный файл для стандартных функций, таких как system() и snprintf()
-#include <stdio.h>      // Включаем заголовочный файл для snprintf() - используется для форматирования строки команды
+#include <glib-unix.h>  // g_unix_fd_add: ответы демона читаются в главном цикле GTK
+#include <stdio.h>      // Включаем заголовочный файл для snprintf() - используется для форматирования текста статуса
+#include "pigpiod_client.h" // Клиент демона pigpiod: одно соединение вместо запуска pigs на каждую команду
+#include "servo_output.h"   // Выходной каскад: не больше одной команды на канал за кадр серво (20 мс)
+#include "servo_motion.h"   // Профиль движения: ограничение скорости, ускорения и рывка
+
+#define SERVO_GPIO 17 // GPIO сервопривода по умолчанию (GPIO17), если в командной строке нет других.
+#define MAX_SERVOS 16 // Сервоприводов в одном окне
+#define PREVIEW_MAX 500 // Точек предпросмотра: 10 с движения при кадре 20 мс
+
+// --- Соединение с pigpiod и строка статуса ---
+static pigpiod_t *pi;           // Соединение с демоном; NULL — демон недоступен
+static guint pi_watch;          // Источник главного цикла, читающий ответы демона
+static GtkWidget *status_label; // Ошибки демона и состояние соединения
+static GtkWidget *stats_label;  // Счётчики выходного каскада
+static servo_output_t *output;  // Отправляет последнюю цель раз в кадр в своём потоке
+static servo_motion_t *motion;  // Ведёт сервопривод к цели по профилю в потоке реального времени
+static gboolean use_wave = TRUE; // Все каналы одной волной pigpio; --servo-cmd — командами SERVO
+static gboolean use_hw_pwm;      // --hw-pwm: GPIO12/13/18/19 через аппаратный ШИМ ядра
+static gboolean need_pigpiod = TRUE; // Есть каналы, которые ведёт pigpiod
+
+// --- Каналы ---
+static unsigned servo_gpios[MAX_SERVOS]; // GPIO каналов в порядке командной строки
+static GtkWidget *scales[MAX_SERVOS];    // Ползунок каждого канала
+static int n_servos;
+
+// --- Предпросмотр движения ---
+static GtkWidget *preview;              // Область рисования кривой
+static GtkWidget *speed_spin, *accel_spin, *scurve_check; // Ограничения профиля
+static double preview_pos[PREVIEW_MAX]; // Положение по кадрам от момента смены цели
+static int preview_len;                 // Число точек; последняя — цель
+static double preview_frame;            // Длительность кадра, с
+static gint64 preview_start;            // Когда посчитана кривая (g_get_monotonic_time)
+static guint preview_timer;             // Перерисовка бегунка, пока идёт движение
+static unsigned preview_gpio;           // Канал, который двигали последним
+
+static void pigpiod_disconnect(void);
+
+/**
+ * @brief Выводит текст ошибки в строку статуса (в главном цикле GTK).
+ * @return G_SOURCE_REMOVE: вызывается один раз.
+ */
+static gboolean show_status(gpointer text) {
+    gtk_label_set_text(GTK_LABEL(status_label), text);
+    g_free(text);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Показывает ошибку, которую вернул демон на команду.
+ * Вызывается клиентом при чтении ответа: в главном цикле GTK или, при
+ * отправке волной, в потоке выходного каскада — поэтому текст передаётся
+ * в главный цикл через g_idle_add.
+ */
+static void on_pigpiod_error(pigpiod_t *p, unsigned cmd, unsigned p1, unsigned p2, int res,
+                             void *user_data) {
+    g_idle_add(show_status, g_strdup_printf("pigpiod: команда %u (%u, %u): %s", cmd, p1, p2,
+                                            pigpiod_strerror(res)));
+}
+
+/**
+ * @brief Читает пришедшие ответы демона, когда сокет готов к чтению.
+ * @return G_SOURCE_CONTINUE, пока соединение живо.
+ */
+static gboolean on_pigpiod_readable(gint fd, GIOCondition condition, gpointer user_data) {
+    if (pigpiod_poll(pi) < 0) {
+        gtk_label_set_text(GTK_LABEL(status_label), "pigpiod: соединение потеряно");
+        pi_watch = 0;
+        pigpiod_disconnect();
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Подключается к pigpiod (PIGPIO_ADDR/PIGPIO_PORT, как у pigs).
+ * @return TRUE, если соединение есть.
+ */
+static gboolean pigpiod_connect(void) {
+    if (pi)
+        return TRUE;
+    pi = pigpiod_open(NULL, NULL);
+    if (!pi) {
+        gtk_label_set_text(GTK_LABEL(status_label), "pigpiod недоступен: запустите sudo pigpiod");
+        return FALSE;
+    }
+    pigpiod_set_error_cb(pi, on_pigpiod_error, NULL);
+    servo_output_set_client(output, pi);
+    pi_watch = g_unix_fd_add(pigpiod_fd(pi), G_IO_IN | G_IO_HUP | G_IO_ERR, on_pigpiod_readable, NULL);
+    gtk_label_set_text(GTK_LABEL(status_label), "pigpiod: подключено");
+    return TRUE;
+}
+
+static void pigpiod_disconnect(void) {
+    servo_output_set_client(output, NULL); // После этого поток каскада соединение не трогает
+    if (pi_watch)
+        g_source_remove(pi_watch);
+    pi_watch = 0;
+    pigpiod_close(pi);
+    pi = NULL;
+}
 
 // --- Функции управления сервоприводом ---
 
 /**
- * @brief Устанавливает положение сервопривода, отправляя команду через pigs.
+ * @brief Выход профиля движения: очередное положение уходит выходному каскаду.
+ * Вызывается из потока движения раз в кадр, пока сервопривод едет к цели.
+ */
+static void motion_output(void *ctx, unsigned gpio, unsigned pulsewidth) {
+    servo_output_set(output, gpio, pulsewidth);
+}
+
+/**
+ * @brief Перерисовывает бегунок предпросмотра, пока движение не закончится.
+ * @return G_SOURCE_REMOVE после конца кривой.
+ */
+static gboolean on_preview_tick(gpointer user_data) {
+    gtk_widget_queue_draw(preview);
+    if ((g_get_monotonic_time() - preview_start) / 1e6 > preview_len * preview_frame) {
+        preview_timer = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Пересчитывает кривую предпросмотра: копия профиля из потока
+ * движения прогоняется вперёд теми же шагами, что и настоящий профиль,
+ * поэтому кривая совпадает с движением сервопривода.
+ */
+static void preview_update(void) {
+    servo_profile_t prof;
+    double target;
+
+    if (servo_motion_snapshot(motion, preview_gpio, &prof, &target) < 0)
+        return;
+    preview_frame = prof.dt;
+    preview_start = g_get_monotonic_time();
+    preview_len = 0;
+    preview_pos[preview_len++] = prof.out;
+    while (preview_len < PREVIEW_MAX && !servo_profile_settled(&prof, target))
+        preview_pos[preview_len++] = servo_profile_step(&prof, target);
+
+    if (!preview_timer)
+        preview_timer = g_timeout_add(40, on_preview_tick, NULL);
+    gtk_widget_queue_draw(preview);
+}
+
+/**
+ * @brief Рисует кривую положения от смены цели до остановки и бегунок
+ * текущего момента. По горизонтали — время (не меньше 0,5 с), по
+ * вертикали — ширина импульса от 500 до 2500 мкс.
+ */
+static gboolean on_preview_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    int w = gtk_widget_get_allocated_width(widget);
+    int h = gtk_widget_get_allocated_height(widget);
+    double span = preview_len * preview_frame;
+
+    if (span < 0.5)
+        span = 0.5;
+    cairo_set_source_rgb(cr, 0.12, 0.12, 0.12);
+    cairo_paint(cr);
+
+    // Сетка: 500, 1500 и 2500 мкс
+    cairo_set_line_width(cr, 1);
+    cairo_set_source_rgb(cr, 0.35, 0.35, 0.35);
+    for (int pw = 500; pw <= 2500; pw += 1000) {
+        double y = h - 4 - (pw - 500) * (h - 8) / 2000.0;
+        cairo_move_to(cr, 0, y);
+        cairo_line_to(cr, w, y);
+    }
+    cairo_stroke(cr);
+    if (preview_len == 0)
+        return FALSE;
+
+    // Кривая положения
+    cairo_set_line_width(cr, 2);
+    cairo_set_source_rgb(cr, 0.3, 0.8, 0.4);
+    for (int i = 0; i < preview_len; i++) {
+        double x = i * preview_frame * w / span;
+        double y = h - 4 - (preview_pos[i] - 500) * (h - 8) / 2000.0;
+        if (i == 0)
+            cairo_move_to(cr, x, y);
+        else
+            cairo_line_to(cr, x, y);
+    }
+    cairo_line_to(cr, w, h - 4 - (preview_pos[preview_len - 1] - 500) * (h - 8) / 2000.0);
+    cairo_stroke(cr);
+
+    // Бегунок: где сервопривод сейчас
+    double t = (g_get_monotonic_time() - preview_start) / 1e6;
+    if (t < span) {
+        cairo_set_line_width(cr, 1);
+        cairo_set_source_rgb(cr, 0.9, 0.6, 0.2);
+        cairo_move_to(cr, t * w / span, 0);
+        cairo_line_to(cr, t * w / span, h);
+        cairo_stroke(cr);
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Передаёт потоку движения ограничения из полей настройки.
+ * Сервопривод, который уже едет, продолжает движение с новыми ограничениями.
+ */
+static void on_limits_changed(GtkWidget *widget, gpointer user_data) {
+    servo_limits_t lim;
+
+    lim.vmax = gtk_spin_button_get_value(GTK_SPIN_BUTTON(speed_spin));
+    lim.amax = gtk_spin_button_get_value(GTK_SPIN_BUTTON(accel_spin));
+    // Рывок задаёт время нарастания ускорения: amax / jmax = 0,1 с
+    lim.jmax = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(scurve_check)) ? lim.amax * 10 : 0;
+    for (int i = 0; i < n_servos; i++)
+        servo_motion_set_limits(motion, servo_gpios[i], &lim);
+    preview_update();
+}
+
+/**
+ * @brief Задаёт сервоприводу новое положение.
+ * Цель передаётся профилю движения: поток движения раз в кадр серво
+ * выставляет очередное положение через выходной каскад, и до демона
+ * доходит не больше одного значения за кадр. Смена цели посреди движения
+ * продолжает его из текущих положения и скорости. Ответ прочитает
+ * on_pigpiod_readable, ошибку покажет on_pigpiod_error.
+ * @param gpio GPIO канала.
  * @param pulsewidth Ширина импульса в микросекундах (обычно от 500 до 2500 для SG90).
  * 1500 us обычно соответствует центральному положению.
  */
-void set_servo(int pulsewidth) {
-    char cmd[64]; // Создаем буфер для хранения строки команды.
-                  // Достаточно большой для команды "pigs s 17 2500" и завершающего нуля.
-
-    // Форматируем строку команды: "pigs s 17 [pulsewidth]".
-    // "pigs s" - команда pigs для установки ширины импульса (серво).
-    // "17" - номер GPIO-пина, к которому подключен сервопривод (GPIO17).
-    // "%d" - placeholder для значения pulsewidth.
-    snprintf(cmd, sizeof(cmd), "pigs s 17 %d", pulsewidth);
-
-    // Выполняем команду в системной оболочке.
-    // Это запускает внешний инструмент 'pigs', который управляет сервоприводом.
-    // Важно: для работы 'pigs' должен быть запущен демон pigpiod, и у пользователя должны быть права.
-    system(cmd);
+void set_servo(unsigned gpio, int pulsewidth) {
+    // Если демон был недоступен или соединение оборвалось, пробуем подключиться снова.
+    // Цель сохраняется в любом случае и уйдёт после подключения.
+    if (need_pigpiod)
+        pigpiod_connect();
+    servo_motion_move(motion, gpio, pulsewidth);
+    preview_gpio = gpio;
+    preview_update();
+}
+
+/**
+ * @brief Раз в секунду показывает счётчики выходного каскада.
+ * @return G_SOURCE_CONTINUE, чтобы таймер продолжал работать.
+ */
+static gboolean update_stats(gpointer user_data) {
+    servo_output_stats_t st;
+    servo_motion_stats_t ms;
+    char text[256];
+
+    servo_output_get_stats(output, &st);
+    servo_motion_get_stats(motion, &ms);
+    snprintf(text, sizeof(text),
+             "События: %lu, %s: %lu, отброшено: %lu, задержка до %lu мс\n"
+             "Профиль (%s): кадров %lu, опозданий %lu, пробуждение до %lu мкс",
+             st.events, use_wave ? "волн" : "команд", use_wave ? st.waves : st.commands,
+             st.dropped, (st.max_lag_us + 999) / 1000,
+             ms.realtime ? "SCHED_FIFO" : "без приоритета RT", ms.ticks, ms.overruns,
+             ms.max_late_us);
+    gtk_label_set_text(GTK_LABEL(stats_label), text);
+    return G_SOURCE_CONTINUE;
 }
 
 // --- Функции обратного вызова для GUI (GTK+) ---
 
 /**
  * @brief Функция обратного вызова, вызываемая при нажатии одной из кнопок управления сервоприводом.
+ * Кнопки двигают все каналы: ползунки переставляются, и каждый сам задаёт цель своему каналу.
  * @param widget Указатель на виджет, вызвавший событие (в данном случае GtkButton).
  * @param data Пользовательские данные, переданные при подключении сигнала (здесь - целевая ширина импульса).
  */
 void on_button_clicked(GtkWidget *widget, gpointer data) {
     // Преобразуем gpointer (обобщенный указатель) обратно в int (ширину импульса).
     int value = GPOINTER_TO_INT(data);
-    // Устанавливаем положение сервопривода.
-    set_servo(value);
+    for (int i = 0; i < n_servos; i++)
+        gtk_range_set_value(GTK_RANGE(scales[i]), value);
 }
 
 /**
  * @brief Функция обратного вызова, вызываемая при изменении положения ползунка (GtkScale).
  * @param range Указатель на GtkRange (базовый тип для GtkScale), вызвавший событие.
- * @param user_data Пользовательские данные (не используются в данной функции, NULL).
+ * @param user_data GPIO канала (GINT_TO_POINTER).
  */
 void on_scale_moved(GtkRange *range, gpointer user_data) {
     // Получаем текущее значение ползунка.
     int value = (int)gtk_range_get_value(range);
-    // Устанавливаем положение сервопривода на основе значения ползунка.
-    set_servo(value);
+    // Устанавливаем положение сервопривода этого канала на основе значения ползунка.
+    set_servo(GPOINTER_TO_INT(user_data), value);
 }
 
 // --- Главная функция программы ---
@@ -56,6 +291,14 @@ void on_scale_moved(GtkRange *range, gpointer user_data) {
 /**
  * @brief Точка входа в программу. Инициализирует GTK+, создает графический интерфейс
  * и запускает основной цикл обработки событий.
+ *
+ *   ./servo_gui [--servo-cmd] [--hw-pwm] [GPIO ...]
+ *
+ * Каждый GPIO (0..31) — отдельный канал со своим ползунком; без них — один
+ * канал на GPIO17. По умолчанию все каналы кадра уходят одной волной
+ * pigpio, --servo-cmd — командой SERVO на канал, как раньше. С --hw-pwm
+ * каналы на GPIO12/13/18/19 ведёт аппаратный ШИМ ядра (по одному каналу
+ * на пару 12/18 и 13/19); если такие все, pigpiod не нужен вовсе.
  * @param argc Количество аргументов командной строки.
  * @param argv Массив строк аргументов командной строки.
  * @return Код завершения программы (0 при успешном выполнении, 1 при ошибке).
@@ -64,6 +307,28 @@ int main(int argc, char *argv[]) {
     // Инициализация библиотеки GTK+. Должна быть вызвана первой для любого GTK-приложения.
     gtk_init(&argc, &argv);
 
+    // --- Разбор командной строки: каналы и способ отправки ---
+    for (int i = 1; i < argc; i++) {
+        char *end;
+        long gpio = strtol(argv[i], &end, 10);
+        if (strcmp(argv[i], "--servo-cmd") == 0) {
+            use_wave = FALSE;
+        } else if (strcmp(argv[i], "--hw-pwm") == 0) {
+            use_hw_pwm = TRUE;
+        } else if (*argv[i] && !*end && gpio >= 0 && gpio < SERVO_OUTPUT_GPIOS) {
+            gboolean dup = FALSE;
+            for (int j = 0; j < n_servos; j++)
+                dup = dup || servo_gpios[j] == (unsigned)gpio;
+            if (!dup && n_servos < MAX_SERVOS)
+                servo_gpios[n_servos++] = gpio;
+        } else {
+            g_printerr("Использование: %s [--servo-cmd] [--hw-pwm] [GPIO 0..31 ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n_servos == 0)
+        servo_gpios[n_servos++] = SERVO_GPIO;
+
     // --- Создание главного окна GTK+ ---
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL); // Создаем новое окно верхнего уровня.
     gtk_window_set_title(GTK_WINDOW(window), "Servo SG90 Controller"); // Устанавливаем заголовок окна.
@@ -110,24 +375,89 @@ int main(int argc, char *argv[]) {
         gtk_box_pack_start(GTK_BOX(hbox), btn, TRUE, TRUE, 0);
     }
 
-    // --- Создание ползунка (GtkScale) ---
-    // Создаем горизонтальный ползунок с диапазоном значений от 500 до 2500
-    // и шагом изменения значения 10.
-    GtkWidget *scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 500, 2500, 10);
-    gtk_scale_set_value_pos(GTK_SCALE(scale), GTK_POS_TOP); // Размещаем текущее значение ползунка сверху.
-    // Подключаем сигнал "value-changed" (изменение значения ползунка) к функции on_scale_moved.
-    // NULL в user_data, так как значение берется напрямую из ползунка в on_scale_moved.
-    g_signal_connect(scale, "value-changed", G_CALLBACK(on_scale_moved), NULL);
-    gtk_range_set_value(GTK_RANGE(scale), 1500); // Устанавливаем начальное значение ползунка в 1500 (центр).
-    // Упаковываем ползунок в вертикальный контейнер.
-    // TRUE, TRUE - ползунок будет растягиваться и заполнять доступное пространство.
-    // 0 - без дополнительного отступа.
-    gtk_box_pack_start(GTK_BOX(vbox), scale, TRUE, TRUE, 0);
+    // --- Строка статуса и соединение с pigpiod ---
+    // Создаётся до ползунка: gtk_range_set_value ниже уже отправляет команду.
+    status_label = gtk_label_new("");
+    stats_label = gtk_label_new("");
+    output = use_wave ? servo_output_new_wave(NULL, SERVO_FRAME_US)
+                      : servo_output_new(NULL, SERVO_FRAME_US);
+    motion = servo_motion_new(SERVO_FRAME_US, motion_output, NULL);
+    if (use_hw_pwm) {
+        // Каналы без аппаратного ШИМ (или если sysfs недоступен) остаются на pigpiod
+        need_pigpiod = FALSE;
+        for (int i = 0; i < n_servos; i++) {
+            if (servo_output_attach_hw(output, servo_gpios[i]) < 0)
+                need_pigpiod = TRUE;
+        }
+    }
+    if (need_pigpiod)
+        pigpiod_connect();
+    else
+        gtk_label_set_text(GTK_LABEL(status_label), "Аппаратный ШИМ: pigpiod не нужен");
+    g_timeout_add_seconds(1, update_stats, NULL);
+
+    // --- Создание ползунков (GtkScale), по одному на канал ---
+    for (int i = 0; i < n_servos; i++) {
+        char name[16];
+        GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+        snprintf(name, sizeof(name), "GPIO%u", servo_gpios[i]);
+        gtk_box_pack_start(GTK_BOX(row), gtk_label_new(name), FALSE, FALSE, 0);
+        // Создаем горизонтальный ползунок с диапазоном значений от 500 до 2500
+        // и шагом изменения значения 10.
+        scales[i] = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 500, 2500, 10);
+        gtk_scale_set_value_pos(GTK_SCALE(scales[i]), GTK_POS_TOP); // Размещаем текущее значение ползунка сверху.
+        // Подключаем сигнал "value-changed" (изменение значения ползунка) к функции on_scale_moved.
+        // В user_data — GPIO канала: значение берется напрямую из ползунка.
+        g_signal_connect(scales[i], "value-changed", G_CALLBACK(on_scale_moved),
+                         GINT_TO_POINTER(servo_gpios[i]));
+        // TRUE, TRUE - ползунок будет растягиваться и заполнять доступное пространство.
+        gtk_box_pack_start(GTK_BOX(row), scales[i], TRUE, TRUE, 0);
+        gtk_box_pack_start(GTK_BOX(vbox), row, FALSE, FALSE, 0);
+    }
+
+    // --- Ограничения профиля движения ---
+    GtkWidget *limits_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    speed_spin = gtk_spin_button_new_with_range(500, 20000, 500);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(speed_spin), SERVO_MOTION_VMAX);
+    accel_spin = gtk_spin_button_new_with_range(1000, 100000, 1000);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(accel_spin), SERVO_MOTION_AMAX);
+    scurve_check = gtk_check_button_new_with_label("S-кривая");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(scurve_check), TRUE);
+    gtk_box_pack_start(GTK_BOX(limits_box), gtk_label_new("Скорость, мкс/с:"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(limits_box), speed_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(limits_box), gtk_label_new("Ускорение, мкс/с²:"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(limits_box), accel_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(limits_box), scurve_check, FALSE, FALSE, 0);
+    g_signal_connect(speed_spin, "value-changed", G_CALLBACK(on_limits_changed), NULL);
+    g_signal_connect(accel_spin, "value-changed", G_CALLBACK(on_limits_changed), NULL);
+    g_signal_connect(scurve_check, "toggled", G_CALLBACK(on_limits_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), limits_box, FALSE, FALSE, 0);
+
+    // --- Предпросмотр: кривая положения до остановки ---
+    preview = gtk_drawing_area_new();
+    gtk_widget_set_size_request(preview, -1, 120);
+    g_signal_connect(preview, "draw", G_CALLBACK(on_preview_draw), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), preview, TRUE, TRUE, 0);
+    // Устанавливаем начальное значение ползунков в 1500 (центр). Положение сервоприводов
+    // при запуске неизвестно, поэтому первая цель выставляется сразу, без профиля.
+    for (int i = 0; i < n_servos; i++)
+        gtk_range_set_value(GTK_RANGE(scales[i]), 1500);
+
+    gtk_box_pack_start(GTK_BOX(vbox), status_label, FALSE, FALSE, 5);
+    gtk_box_pack_start(GTK_BOX(vbox), stats_label, FALSE, FALSE, 5);
 
     // --- Отображение GUI и запуск основного цикла GTK+ ---
     gtk_widget_show_all(window); // Отображает все виджеты, содержащиеся в окне.
     gtk_main(); // Запускает основной цикл обработки событий GTK+.
                 // Программа будет работать, пока gtk_main_quit() не будет вызвана.
 
+    servo_motion_free(motion); // Останавливает поток движения там, где сервопривод сейчас.
+    servo_output_free(output); // Отправляет последнюю цель, если она ещё не ушла.
+    if (pi) // Дожидаемся ответов на последние команды и закрываем соединение.
+        pigpiod_sync(pi);
+    output = NULL;
+    pi_watch = 0; // Главный цикл уже завершён, его источники не нужны.
+    pigpiod_close(pi);
+
     return 0; // Возвращаем 0, указывая на успешное завершение программы.
 }
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "servo_motion.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define MOTION_RT_PRIORITY 50 // SCHED_FIFO; выше обычных потоков, ниже IRQ-потоков ядра
+
+// --- Профиль ---
+
+static int profile_taps(const servo_limits_t *lim, double dt) {
+    if (lim->jmax <= 0)
+        return 1;
+    // Усреднение по окну T сглаживает ускорение в рампу длиной T:
+    // рывок amax / T не превышает jmax при T = amax / jmax
+    int taps = (int)lround(lim->amax / lim->jmax / dt);
+    if (taps < 1)
+        taps = 1;
+    if (taps > SERVO_MOTION_TAPS_MAX)
+        taps = SERVO_MOTION_TAPS_MAX;
+    return taps;
+}
+
+void servo_profile_init(servo_profile_t *p, const servo_limits_t *lim, double dt, double pos) {
+    memset(p, 0, sizeof(*p));
+    p->lim = *lim;
+    p->dt = dt;
+    p->pos = pos;
+    p->out = pos;
+    p->taps = profile_taps(lim, dt);
+    for (int i = 0; i < SERVO_MOTION_TAPS_MAX; i++)
+        p->hist[i] = pos;
+}
+
+void servo_profile_set_limits(servo_profile_t *p, const servo_limits_t *lim) {
+    int taps = profile_taps(lim, p->dt);
+
+    p->lim = *lim;
+    if (taps == p->taps)
+        return;
+    // Окно другой длины: продолжаем трапецию с выхода, иначе выход
+    // скачком догонит опережающую его трапецию. Скорость выхода —
+    // средняя по окну.
+    int newest = (p->idx + p->taps - 1) % p->taps;
+    p->vel = (p->hist[newest] - p->hist[p->idx]) / (p->taps * p->dt);
+    p->pos = p->out;
+    p->taps = taps;
+    p->idx = 0;
+    for (int i = 0; i < SERVO_MOTION_TAPS_MAX; i++)
+        p->hist[i] = p->out;
+}
+
+// Шаг трапеции: скорость стремится к наибольшей, с которой ещё можно
+// остановиться на цели, но меняется не больше чем на amax * dt за шаг.
+// Состояние — только положение и скорость, поэтому новая цель сразу
+// учитывается со всем, что уже набрано.
+static void trapezoid_step(servo_profile_t *p, double target) {
+    double dt = p->dt;
+    double dv = p->lim.amax * dt;
+    double d = target - p->pos;
+    double dist = fabs(d);
+
+    // Торможение по dv за шаг проходит dv * dt * n(n+1)/2 за n шагов;
+    // отсюда скорость, с которой тормозить ровно до цели
+    double vstop = dv * (sqrt(0.25 + 2 * dist / (dv * dt)) - 0.5);
+    double want = fmin(p->lim.vmax, vstop);
+    if (d < 0)
+        want = -want;
+
+    double vel = p->vel;
+    if (want > vel + dv)
+        vel += dv;
+    else if (want < vel - dv)
+        vel -= dv;
+    else
+        vel = want;
+
+    double next = p->pos + vel * dt;
+    // Цель достигнута или пройдена на последнем малом шаге
+    if (fabs(vel) <= dv && (dist <= fabs(vel) * dt || (target - next) * d <= 0)) {
+        p->pos = target;
+        p->vel = 0;
+    } else {
+        p->pos = next;
+        p->vel = vel;
+    }
+}
+
+double servo_profile_step(servo_profile_t *p, double target) {
+    trapezoid_step(p, target);
+    if (p->taps == 1) {
+        p->out = p->pos;
+        return p->out;
+    }
+
+    p->hist[p->idx] = p->pos;
+    p->idx = (p->idx + 1) % p->taps;
+    double sum = 0;
+    for (int i = 0; i < p->taps; i++)
+        sum += p->hist[i];
+    p->out = sum / p->taps;
+    if (fabs(p->out - target) < 1e-6 && p->pos == target)
+        p->out = target; // Без остатка округления в сумме
+    return p->out;
+}
+
+int servo_profile_settled(const servo_profile_t *p, double target) {
+    return p->pos == target && p->vel == 0 && p->out == target;
+}
+
+// --- Поток движения ---
+
+struct servo_motion {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int quit;
+
+    long frame_ns;
+    servo_motion_out_fn out;
+    void *ctx;
+
+    uint32_t used;   // Каналы с профилем
+    uint32_t moving; // Каналы, ещё не дошедшие до цели
+    servo_limits_t lim[SERVO_MOTION_GPIOS];
+    servo_profile_t prof[SERVO_MOTION_GPIOS];
+    double target[SERVO_MOTION_GPIOS];
+    unsigned last[SERVO_MOTION_GPIOS]; // Последний выставленный импульс
+
+    servo_motion_stats_t stats;
+};
+
+static void *motion_main(void *arg);
+
+static long ts_diff_ns(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec - b->tv_sec) * 1000000000L + (a->tv_nsec - b->tv_nsec);
+}
+
+static void ts_add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+servo_motion_t *servo_motion_new(unsigned frame_us, servo_motion_out_fn out, void *ctx) {
+    servo_motion_t *m = calloc(1, sizeof(*m));
+    servo_limits_t def = {SERVO_MOTION_VMAX, SERVO_MOTION_AMAX, SERVO_MOTION_JMAX};
+
+    if (!m)
+        return NULL;
+    m->frame_ns = (frame_us ? frame_us : 20000) * 1000L;
+    m->out = out;
+    m->ctx = ctx;
+    for (int g = 0; g < SERVO_MOTION_GPIOS; g++)
+        m->lim[g] = def;
+
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->cond, NULL);
+    if (pthread_create(&m->thread, NULL, motion_main, m) != 0) {
+        pthread_cond_destroy(&m->cond);
+        pthread_mutex_destroy(&m->lock);
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void servo_motion_free(servo_motion_t *m) {
+    if (!m)
+        return;
+
+    pthread_mutex_lock(&m->lock);
+    m->quit = 1;
+    pthread_cond_signal(&m->cond);
+    pthread_mutex_unlock(&m->lock);
+    pthread_join(m->thread, NULL);
+
+    pthread_cond_destroy(&m->cond);
+    pthread_mutex_destroy(&m->lock);
+    free(m);
+}
+
+void servo_motion_set_limits(servo_motion_t *m, unsigned gpio, const servo_limits_t *lim) {
+    if (gpio >= SERVO_MOTION_GPIOS || lim->vmax <= 0 || lim->amax <= 0 || lim->jmax < 0)
+        return;
+
+    pthread_mutex_lock(&m->lock);
+    m->lim[gpio] = *lim;
+    if (m->used & (1u << gpio))
+        servo_profile_set_limits(&m->prof[gpio], lim);
+    pthread_mutex_unlock(&m->lock);
+}
+
+void servo_motion_jump(servo_motion_t *m, unsigned gpio, unsigned pulsewidth) {
+    if (gpio >= SERVO_MOTION_GPIOS)
+        return;
+
+    pthread_mutex_lock(&m->lock);
+    servo_profile_init(&m->prof[gpio], &m->lim[gpio], m->frame_ns / 1e9, pulsewidth);
+    m->target[gpio] = pulsewidth;
+    m->last[gpio] = pulsewidth;
+    m->used |= 1u << gpio;
+    m->moving &= ~(1u << gpio);
+    pthread_mutex_unlock(&m->lock);
+
+    m->out(m->ctx, gpio, pulsewidth);
+}
+
+void servo_motion_move(servo_motion_t *m, unsigned gpio, unsigned pulsewidth) {
+    if (gpio >= SERVO_MOTION_GPIOS)
+        return;
+
+    pthread_mutex_lock(&m->lock);
+    if (!(m->used & (1u << gpio))) {
+        // Откуда начинать, неизвестно: первая цель выставляется сразу
+        pthread_mutex_unlock(&m->lock);
+        servo_motion_jump(m, gpio, pulsewidth);
+        return;
+    }
+    m->target[gpio] = pulsewidth;
+    if (!m->moving)
+        pthread_cond_signal(&m->cond);
+    m->moving |= 1u << gpio;
+    pthread_mutex_unlock(&m->lock);
+}
+
+int servo_motion_snapshot(servo_motion_t *m, unsigned gpio, servo_profile_t *p, double *target) {
+    int res = -1;
+
+    if (gpio >= SERVO_MOTION_GPIOS)
+        return -1;
+    pthread_mutex_lock(&m->lock);
+    if (m->used & (1u << gpio)) {
+        *p = m->prof[gpio];
+        *target = m->target[gpio];
+        res = 0;
+    }
+    pthread_mutex_unlock(&m->lock);
+    return res;
+}
+
+void servo_motion_get_stats(servo_motion_t *m, servo_motion_stats_t *st) {
+    pthread_mutex_lock(&m->lock);
+    *st = m->stats;
+    pthread_mutex_unlock(&m->lock);
+}
+
+// Приоритет реального времени, если он разрешён (root или CAP_SYS_NICE);
+// иначе поток остаётся обычным и только опаздывает чаще
+static int motion_set_realtime(void) {
+    struct sched_param sp = {.sched_priority = MOTION_RT_PRIORITY};
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+}
+
+static void *motion_main(void *arg) {
+    servo_motion_t *m = arg;
+    unsigned pw[SERVO_MOTION_GPIOS];
+    uint32_t changed;
+    struct timespec next, now;
+
+    int rt = motion_set_realtime();
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    pthread_mutex_lock(&m->lock);
+    m->stats.realtime = rt;
+    for (;;) {
+        if (!m->moving) {
+            if (m->quit)
+                break;
+            pthread_cond_wait(&m->cond, &m->lock);
+            // Движение началось: первый шаг сразу, дальше по сетке кадров
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+        if (m->quit)
+            break;
+
+        // Шаг всех движущихся каналов
+        changed = 0;
+        for (unsigned g = 0; g < SERVO_MOTION_GPIOS; g++) {
+            uint32_t bit = 1u << g;
+            if (!(m->moving & bit))
+                continue;
+            double out = servo_profile_step(&m->prof[g], m->target[g]);
+            if (servo_profile_settled(&m->prof[g], m->target[g]))
+                m->moving &= ~bit;
+            pw[g] = (unsigned)lround(out);
+            if (pw[g] != m->last[g]) {
+                m->last[g] = pw[g];
+                changed |= bit;
+            }
+        }
+        m->stats.ticks++;
+        pthread_mutex_unlock(&m->lock);
+
+        // Выход — без блокировки: move из GUI не ждёт отправки
+        for (unsigned g = 0; g < SERVO_MOTION_GPIOS; g++)
+            if (changed & (1u << g))
+                m->out(m->ctx, g, pw[g]);
+
+        // Абсолютные сроки: опоздание одного кадра не сдвигает остальные
+        ts_add_ns(&next, m->frame_ns);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long late;
+        if (ts_diff_ns(&now, &next) > 0) {
+            // Кадр пропущен; догонять не нужно, сетка начинается заново
+            late = -1;
+            next = now;
+        } else {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            late = ts_diff_ns(&now, &next) / 1000;
+        }
+        pthread_mutex_lock(&m->lock);
+        if (late < 0)
+            m->stats.overruns++;
+        else if ((unsigned long)late > m->stats.max_late_us)
+            m->stats.max_late_us = late;
+    }
+    pthread_mutex_unlock(&m->lock);
+    return NULL;
+}
@@ -0,0 +1,80 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+// Плавные движения сервоприводов. Вместо скачка к цели импульс меняется
+// по профилю с ограничением скорости и ускорения (трапеция) и, если задан
+// рывок, со сглаженным ускорением (S-кривая). Профиль считается в своём
+// потоке реального времени раз в кадр серво; смена цели посреди движения
+// не начинает движение заново, а продолжает его из текущих положения и
+// скорости.
+//
+// Единицы: положение — ширина импульса в мкс, скорость — мкс/с,
+// ускорение — мкс/с², рывок — мкс/с³.
+
+#define SERVO_MOTION_GPIOS 32 // Как у servo_output: GPIO 0..31
+
+// Ограничения по умолчанию. SG90 проходит 180° (2000 мкс) примерно за
+// 0,3 с без нагрузки; берём вдвое медленнее, чтобы не проседало питание.
+#define SERVO_MOTION_VMAX 3000.0
+#define SERVO_MOTION_AMAX 12000.0
+#define SERVO_MOTION_JMAX 120000.0
+
+// S-кривая — трапеция, сглаженная скользящим средним длиной amax/jmax.
+// Рывок не превышает jmax, пока ускорение не меняет знак с +amax на
+// -amax сразу (разворот посреди движения): тогда он до 2·jmax.
+// Длиннее этого числа кадров окно не бывает.
+#define SERVO_MOTION_TAPS_MAX 64
+
+typedef struct {
+    double vmax;
+    double amax;
+    double jmax; // 0 — трапеция без ограничения рывка
+} servo_limits_t;
+
+// Профиль одного сервопривода. Функции профиля не потокобезопасны и
+// не зависят от потока движения: GUI копирует профиль и прогоняет копию
+// вперёд, чтобы нарисовать будущую кривую.
+typedef struct {
+    servo_limits_t lim;
+    double dt;       // Шаг, с
+    double pos, vel; // Трапеция
+    double out;      // Выход (после сглаживания)
+    double hist[SERVO_MOTION_TAPS_MAX];
+    int taps, idx;
+} servo_profile_t;
+
+void servo_profile_init(servo_profile_t *p, const servo_limits_t *lim, double dt, double pos);
+// Новые ограничения; движение продолжается из текущего состояния
+void servo_profile_set_limits(servo_profile_t *p, const servo_limits_t *lim);
+// Один шаг к цели; возвращает новый выход
+double servo_profile_step(servo_profile_t *p, double target);
+// Выход стоит на цели
+int servo_profile_settled(const servo_profile_t *p, double target);
+
+typedef struct {
+    int realtime;              // Поток получил SCHED_FIFO
+    unsigned long ticks;       // Шагов профиля (кадров с движением)
+    unsigned long overruns;    // Кадров, не уложившихся в срок
+    unsigned long max_late_us; // Наибольшее опоздание пробуждения к кадру
+} servo_motion_stats_t;
+
+typedef struct servo_motion servo_motion_t;
+
+// Выставляет импульс; вызывается из потока движения раз в кадр для
+// каждого движущегося сервопривода
+typedef void (*servo_motion_out_fn)(void *ctx, unsigned gpio, unsigned pulsewidth);
+
+servo_motion_t *servo_motion_new(unsigned frame_us, servo_motion_out_fn out, void *ctx);
+void servo_motion_free(servo_motion_t *m);
+
+void servo_motion_set_limits(servo_motion_t *m, unsigned gpio, const servo_limits_t *lim);
+// Ставит сервопривод в положение сразу, без профиля (например, при запуске)
+void servo_motion_jump(servo_motion_t *m, unsigned gpio, unsigned pulsewidth);
+// Новая цель; движение перепланируется из текущего состояния
+void servo_motion_move(servo_motion_t *m, unsigned gpio, unsigned pulsewidth);
+// Копия профиля и цели для предпросмотра; -1, если GPIO не использовался
+int servo_motion_snapshot(servo_motion_t *m, unsigned gpio, servo_profile_t *p, double *target);
+
+void servo_motion_get_stats(servo_motion_t *m, servo_motion_stats_t *st);
+
+#endif // SERVO_MOTION_H
@@ -0,0 +1,318 @@
+#include "servo_output.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// Режимы вывода pigpio: функция, через которую на вывод выходит ШИМ
+#define PI_ALT0 4 // GPIO12, GPIO13
+#define PI_ALT5 2 // GPIO18, GPIO19
+
+struct servo_output {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int quit;
+
+    pigpiod_t *pi;
+    servo_wave_t *wave; // NULL — командами SERVO
+    hw_pwm_t *hw[SERVO_OUTPUT_GPIOS]; // Каналы аппаратного ШИМ (демон им не нужен)
+    uint32_t hw_mask;
+    long frame_ns;
+    struct timespec next_frame; // Раньше этого срока следующая отправка не уходит
+
+    // Цели каналов; dirty — ещё не отправлены
+    uint32_t dirty;
+    unsigned target[SERVO_OUTPUT_GPIOS];
+    unsigned sent[SERVO_OUTPUT_GPIOS];       // Последнее отправленное (0 — ничего)
+    struct timespec since[SERVO_OUTPUT_GPIOS]; // Когда канал стал dirty
+
+    servo_output_stats_t stats;
+};
+
+static void *output_main(void *arg);
+
+static long ts_diff_ns(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec - b->tv_sec) * 1000000000L + (a->tv_nsec - b->tv_nsec);
+}
+
+static void ts_add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static servo_output_t *output_new(pigpiod_t *pi, unsigned frame_us, int wave) {
+    servo_output_t *out = calloc(1, sizeof(*out));
+    pthread_condattr_t ca;
+
+    if (!frame_us)
+        frame_us = SERVO_FRAME_US;
+    if (!out)
+        return NULL;
+    if (wave && !(out->wave = servo_wave_new(frame_us))) {
+        free(out);
+        return NULL;
+    }
+    out->pi = pi;
+    out->frame_ns = frame_us * 1000L;
+    clock_gettime(CLOCK_MONOTONIC, &out->next_frame);
+
+    pthread_mutex_init(&out->lock, NULL);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&out->cond, &ca);
+    pthread_condattr_destroy(&ca);
+
+    if (pthread_create(&out->thread, NULL, output_main, out) != 0) {
+        pthread_cond_destroy(&out->cond);
+        pthread_mutex_destroy(&out->lock);
+        servo_wave_free(out->wave);
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+servo_output_t *servo_output_new(pigpiod_t *pi, unsigned frame_us) {
+    return output_new(pi, frame_us, 0);
+}
+
+servo_output_t *servo_output_new_wave(pigpiod_t *pi, unsigned frame_us) {
+    return output_new(pi, frame_us, 1);
+}
+
+void servo_output_free(servo_output_t *out) {
+    if (!out)
+        return;
+
+    pthread_mutex_lock(&out->lock);
+    out->quit = 1;
+    pthread_cond_signal(&out->cond);
+    pthread_mutex_unlock(&out->lock);
+    pthread_join(out->thread, NULL);
+
+    if (out->wave) {
+        if (out->pi)
+            servo_wave_stop(out->wave, out->pi);
+        servo_wave_free(out->wave);
+    }
+    for (unsigned g = 0; g < SERVO_OUTPUT_GPIOS; g++)
+        hw_pwm_close(out->hw[g]);
+    pthread_cond_destroy(&out->cond);
+    pthread_mutex_destroy(&out->lock);
+    free(out);
+}
+
+void servo_output_set_client(servo_output_t *out, pigpiod_t *pi) {
+    pthread_mutex_lock(&out->lock);
+    out->pi = pi;
+    if (pi && out->dirty)
+        pthread_cond_signal(&out->cond);
+    pthread_mutex_unlock(&out->lock);
+}
+
+// Каналы, которые поток может отправить сейчас: без соединения — только аппаратные
+static uint32_t output_ready(const servo_output_t *out) {
+    return out->dirty & (out->pi ? ~0u : out->hw_mask);
+}
+
+int servo_output_attach_hw(servo_output_t *out, unsigned gpio) {
+    int res = 0;
+
+    if (gpio >= SERVO_OUTPUT_GPIOS)
+        return -1;
+    pthread_mutex_lock(&out->lock);
+    if (!out->hw[gpio]) {
+        out->hw[gpio] = hw_pwm_open(gpio, out->frame_ns);
+        if (out->hw[gpio]) {
+            uint32_t bit = 1u << gpio, ready = output_ready(out);
+            out->hw_mask |= bit;
+            out->sent[gpio] = 0; // Аппаратный канал начинает без импульса
+            if (out->pi) {
+                // Демон перестаёт вести вывод и возвращает его ШИМ: SERVO
+                // и волна оставляют вывод в режиме выхода
+                if (out->wave)
+                    servo_wave_release_gpio(out->wave, gpio);
+                if (pigpiod_send_servo(out->pi, gpio, 0) == 0 &&
+                    pigpiod_send(out->pi, PIGPIOD_CMD_MODES, gpio, gpio < 16 ? PI_ALT0 : PI_ALT5) == 0)
+                    pigpiod_flush(out->pi);
+            }
+            // Цель, заданная до перевода, уходит на канал следующим кадром
+            if (out->target[gpio]) {
+                out->dirty |= bit;
+                clock_gettime(CLOCK_MONOTONIC, &out->since[gpio]);
+            }
+            if (!ready && output_ready(out))
+                pthread_cond_signal(&out->cond);
+        } else {
+            res = -1;
+        }
+    }
+    pthread_mutex_unlock(&out->lock);
+    return res;
+}
+
+void servo_output_set(servo_output_t *out, unsigned gpio, unsigned pulsewidth) {
+    if (gpio >= SERVO_OUTPUT_GPIOS)
+        return;
+
+    pthread_mutex_lock(&out->lock);
+    out->stats.events++;
+    uint32_t bit = 1u << gpio;
+    if (out->dirty & bit) {
+        out->stats.dropped++; // Прежняя цель так и не ушла
+        if (pulsewidth == out->sent[gpio])
+            out->dirty &= ~bit; // Вернулись к отправленному: слать нечего
+    } else if (pulsewidth == out->sent[gpio]) {
+        out->stats.dropped++;
+    } else {
+        // Поток будим, только когда появляется работа: внутри кадра
+        // события лишь обновляют цель
+        uint32_t ready = output_ready(out);
+        out->dirty |= bit;
+        if (!ready && output_ready(out))
+            pthread_cond_signal(&out->cond);
+        clock_gettime(CLOCK_MONOTONIC, &out->since[gpio]);
+    }
+    out->target[gpio] = pulsewidth;
+    pthread_mutex_unlock(&out->lock);
+}
+
+void servo_output_get_stats(servo_output_t *out, servo_output_stats_t *st) {
+    pthread_mutex_lock(&out->lock);
+    *st = out->stats;
+    if (out->wave) {
+        servo_wave_stats_t ws;
+        servo_wave_get_stats(out->wave, &ws);
+        st->waves = ws.updates;
+    }
+    pthread_mutex_unlock(&out->lock);
+}
+
+void servo_output_reset_stats(servo_output_t *out) {
+    pthread_mutex_lock(&out->lock);
+    memset(&out->stats, 0, sizeof(out->stats));
+    pthread_mutex_unlock(&out->lock);
+}
+
+// Канал отправлен: запоминаем значение и задержку от события
+static void output_mark_sent(servo_output_t *out, unsigned g, const struct timespec *now) {
+    out->sent[g] = out->target[g];
+    out->stats.commands++;
+    unsigned long lag = ts_diff_ns(now, &out->since[g]) / 1000;
+    if (lag > out->stats.max_lag_us)
+        out->stats.max_lag_us = lag;
+    out->dirty &= ~(1u << g);
+}
+
+// Аппаратные каналы: по записи в sysfs на изменённый канал
+static void output_flush_hw(servo_output_t *out, const struct timespec *now) {
+    for (unsigned g = 0; g < SERVO_OUTPUT_GPIOS; g++) {
+        if (!(out->dirty & out->hw_mask & (1u << g)))
+            continue;
+        if (hw_pwm_set_duty(out->hw[g], out->target[g] * 1000UL) < 0) {
+            out->stats.errors++;
+            out->dirty &= ~(1u << g); // Повтор даст ту же ошибку
+            continue;
+        }
+        output_mark_sent(out, g, now);
+    }
+}
+
+// Все каналы одной новой волной; при отложенном обновлении (старые
+// волны ещё не освобождены) каналы остаются dirty до следующего кадра
+static void output_flush_wave(servo_output_t *out, const struct timespec *now) {
+    uint32_t mask = 0;
+
+    for (unsigned g = 0; g < SERVO_OUTPUT_GPIOS; g++) {
+        if (out->target[g] && !(out->hw_mask & (1u << g)))
+            mask |= 1u << g;
+    }
+    int status = servo_wave_update(out->wave, out->pi, out->target, mask);
+    if (status < 0) {
+        out->stats.errors++;
+        if (status != PIGPIOD_ERR_IO)
+            out->dirty = 0; // Демон отверг эти цели: повтор даст ту же ошибку
+        return;
+    }
+    if (status > 0)
+        return;
+
+    for (unsigned g = 0; g < SERVO_OUTPUT_GPIOS; g++) {
+        if (out->dirty & (1u << g))
+            output_mark_sent(out, g, now);
+    }
+    out->stats.frames++;
+}
+
+// Отправляет все изменённые каналы одним write; вызывается под lock,
+// чтобы servo_output_set_client не закрыл соединение посреди отправки
+static void output_flush(servo_output_t *out, const struct timespec *now) {
+    int status = 0;
+
+    if (out->dirty & out->hw_mask) {
+        output_flush_hw(out, now);
+        if (!out->dirty || !out->pi) {
+            out->stats.frames++;
+            return;
+        }
+    }
+    if (out->wave) {
+        output_flush_wave(out, now);
+        return;
+    }
+    for (unsigned g = 0; g < SERVO_OUTPUT_GPIOS && status == 0; g++) {
+        if (!(out->dirty & (1u << g)))
+            continue;
+        status = pigpiod_send_servo(out->pi, g, out->target[g]);
+        if (status < 0)
+            break;
+        output_mark_sent(out, g, now);
+    }
+    if (status == 0)
+        status = pigpiod_flush(out->pi);
+    if (status < 0)
+        out->stats.errors++;
+    else
+        out->stats.frames++;
+}
+
+static void *output_main(void *arg) {
+    servo_output_t *out = arg;
+    struct timespec now;
+
+    pthread_mutex_lock(&out->lock);
+    for (;;) {
+        if (!output_ready(out)) {
+            if (out->quit)
+                break;
+            pthread_cond_wait(&out->cond, &out->lock);
+            continue;
+        }
+
+        // Ждём начала кадра; при выходе отправляем сразу
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (!out->quit && ts_diff_ns(&out->next_frame, &now) > 0) {
+            pthread_cond_timedwait(&out->cond, &out->lock, &out->next_frame);
+            continue;
+        }
+
+        output_flush(out, &now);
+        if (out->quit)
+            break;
+
+        // Следующий кадр — по сетке, пока события идут подряд; после
+        // простоя сетка начинается заново с первого события
+        ts_add_ns(&out->next_frame, out->frame_ns);
+        if (ts_diff_ns(&out->next_frame, &now) <= 0) {
+            out->next_frame = now;
+            ts_add_ns(&out->next_frame, out->frame_ns);
+        }
+    }
+    pthread_mutex_unlock(&out->lock);
+    return NULL;
+}
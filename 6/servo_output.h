@@ -0,0 +1,64 @@
+#ifndef SERVO_OUTPUT_H
+#define SERVO_OUTPUT_H
+
+#include "pigpiod_client.h"
+#include "servo_wave.h"
+#include "hw_pwm.h"
+
+// Выходной каскад сервоприводов: для каждого GPIO хранится только
+// последняя цель, а команды демону уходят не чаще раза за кадр серво
+// (20 мс при 50 Гц) — одной пачкой и одним write на все каналы.
+// Сервопривод всё равно защёлкивает новый импульс раз в кадр, поэтому
+// промежуточные значения внутри кадра ничего не меняют.
+//
+// Первое изменение после простоя уходит сразу, следующие — по сетке
+// кадров от него, так что задержка не больше кадра. В простое поток
+// каскада спит и не тратит процессор.
+//
+// Способ отправки выбирается при создании: команды SERVO (по одной на
+// изменённый канал) или одна волна pigpio на все каналы (servo_wave.h) —
+// тогда каналы меняются одновременно на границе кадра, а цена обновления
+// не зависит от числа каналов. Каналы на GPIO12/13/18/19 можно отдать
+// аппаратному ШИМ ядра (hw_pwm.h): они пишутся в sysfs и работают без
+// демона.
+
+#define SERVO_FRAME_US 20000 // Кадр SG90: 50 Гц
+#define SERVO_OUTPUT_GPIOS 32 // Сервоимпульсы pigpio — GPIO 0..31
+
+typedef struct {
+    unsigned long events;   // Вызовов servo_output_set
+    unsigned long commands; // Каналов обновлено (команд SERVO, изменений в волнах, записей ШИМ)
+    unsigned long waves;    // Волн запущено (способ с волной)
+    unsigned long dropped;  // Значений, заменённых до отправки или не изменившихся
+    unsigned long frames;   // Кадров с отправкой (write)
+    unsigned long errors;   // Ошибок отправки (нет соединения)
+    unsigned long max_lag_us; // Наибольшая задержка от события до отправки
+} servo_output_stats_t;
+
+typedef struct servo_output servo_output_t;
+
+// pi может быть NULL: значения копятся, пока не появится соединение
+servo_output_t *servo_output_new(pigpiod_t *pi, unsigned frame_us);
+// То же, но все каналы одной волной длиной frame_us
+servo_output_t *servo_output_new_wave(pigpiod_t *pi, unsigned frame_us);
+// Отправляет то, что ещё не ушло, и останавливает поток. Волну
+// останавливает: импульсы SERVO демон держит и без клиента, а волна,
+// оставленная передаваться, так и останется занятой в демоне. Аппаратные
+// каналы выключаются.
+void servo_output_free(servo_output_t *out);
+// Переводит канал на аппаратный ШИМ с периодом кадра: импульсы pigpiod на
+// выводе снимаются (SERVO 0, вывод возвращается в режим ШИМ), а уже
+// заданная цель уходит на канал следующим кадром. -1 — у GPIO нет
+// аппаратного канала или sysfs недоступен: канал остаётся на pigpiod.
+int servo_output_attach_hw(servo_output_t *out, unsigned gpio);
+// Меняет соединение (например, после переподключения к демону). После
+// возврата каскад старое соединение не трогает, его можно закрыть.
+void servo_output_set_client(servo_output_t *out, pigpiod_t *pi);
+
+// Новая цель канала. Не блокируется на время кадра.
+void servo_output_set(servo_output_t *out, unsigned gpio, unsigned pulsewidth);
+
+void servo_output_get_stats(servo_output_t *out, servo_output_stats_t *st);
+void servo_output_reset_stats(servo_output_t *out);
+
+#endif // SERVO_OUTPUT_H
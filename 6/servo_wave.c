@@ -0,0 +1,184 @@
+#include "servo_wave.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PI_OUTPUT 1
+#define PI_BAD_PULSEWIDTH (-7)
+
+// gpioPulse_t pigpio: маски поднимаемых и опускаемых GPIO и пауза после, мкс
+struct wave_pulse {
+    uint32_t on, off, delay;
+};
+
+struct servo_wave {
+    unsigned frame_us;
+    uint32_t outputs; // GPIO, уже переведённые в режим выхода
+
+    // Созданные волны от старой к новой; последняя — запущенная
+    int queue[SERVO_WAVE_QUEUE];
+    int queued;
+
+    // Результаты команд конвейера (pigpiod_send_ext пишет их при ответе)
+    int res_create, res_tx, res_tat;
+
+    servo_wave_stats_t stats;
+};
+
+servo_wave_t *servo_wave_new(unsigned frame_us) {
+    servo_wave_t *w = calloc(1, sizeof(*w));
+
+    if (w)
+        w->frame_us = frame_us ? frame_us : 20000;
+    return w;
+}
+
+void servo_wave_free(servo_wave_t *w) {
+    free(w);
+}
+
+// Волна кадра: все выходы вверх в начале, вниз по возрастанию ширины.
+// Возвращает число импульсов (не больше SERVO_WAVE_GPIOS + 1).
+static int wave_build(const servo_wave_t *w, const unsigned *pulsewidth, uint32_t mask,
+                      struct wave_pulse *pulses) {
+    unsigned order[SERVO_WAVE_GPIOS];
+    int n = 0;
+
+    for (unsigned g = 0; g < SERVO_WAVE_GPIOS; g++) {
+        if (!(mask & (1u << g)) || pulsewidth[g] == 0)
+            continue;
+        // Вставка по ширине: каналов не больше 32
+        int i = n++;
+        while (i > 0 && pulsewidth[order[i - 1]] > pulsewidth[g]) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = g;
+    }
+    if (n == 0)
+        return 0;
+
+    int np = 0;
+    pulses[np].on = 0;
+    pulses[np].off = 0;
+    for (int i = 0; i < n; i++)
+        pulses[np].on |= 1u << order[i];
+    pulses[np].delay = pulsewidth[order[0]];
+    np++;
+
+    // Одна ступень на каждую разную ширину
+    for (int i = 0; i < n;) {
+        unsigned pw = pulsewidth[order[i]];
+        uint32_t off = 0;
+        while (i < n && pulsewidth[order[i]] == pw)
+            off |= 1u << order[i++];
+        unsigned until = i < n ? pulsewidth[order[i]] : w->frame_us;
+        pulses[np].on = 0;
+        pulses[np].off = off;
+        pulses[np].delay = until - pw;
+        np++;
+    }
+    return np;
+}
+
+// Удаляет из очереди волны старше передаваемой: их цикл уже закончился.
+// Команды уходят конвейером вместе со следующим обновлением.
+static void wave_release(servo_wave_t *w, pigpiod_t *pi, int tat) {
+    int keep = w->queued - 1; // Запущенную не трогаем никогда
+
+    for (int i = 0; i < w->queued - 1; i++) {
+        if (w->queue[i] == tat) {
+            keep = i;
+            break;
+        }
+    }
+    for (int i = 0; i < keep; i++) {
+        pigpiod_send(pi, PIGPIOD_CMD_WVDEL, w->queue[i], 0);
+        w->stats.deleted++;
+    }
+    memmove(w->queue, w->queue + keep, (w->queued - keep) * sizeof(w->queue[0]));
+    w->queued -= keep;
+}
+
+int servo_wave_update(servo_wave_t *w, pigpiod_t *pi, const unsigned *pulsewidth, uint32_t mask) {
+    struct wave_pulse pulses[SERVO_WAVE_GPIOS + 1];
+    int status;
+
+    // Волна исполнит любую длительность; проверяем, как это делает SERVO
+    for (unsigned g = 0; g < SERVO_WAVE_GPIOS; g++) {
+        unsigned pw = pulsewidth[g];
+        if ((mask & (1u << g)) && pw != 0 && (pw < 500 || pw > 2500))
+            return PI_BAD_PULSEWIDTH;
+    }
+    if (w->queued == SERVO_WAVE_QUEUE) {
+        w->stats.skipped++;
+        return 1;
+    }
+
+    int np = wave_build(w, pulsewidth, mask, pulses);
+    if (np == 0)
+        return servo_wave_stop(w, pi);
+
+    // Обмен 1: выходы, новая волна
+    for (unsigned g = 0; g < SERVO_WAVE_GPIOS; g++) {
+        uint32_t bit = 1u << g;
+        if ((mask & bit) && !(w->outputs & bit)) {
+            pigpiod_send(pi, PIGPIOD_CMD_MODES, g, PI_OUTPUT);
+            w->outputs |= bit;
+        }
+    }
+    pigpiod_send(pi, PIGPIOD_CMD_WVNEW, 0, 0);
+    pigpiod_send_ext(pi, PIGPIOD_CMD_WVAG, 0, 0, pulses, np * sizeof(pulses[0]), NULL);
+    pigpiod_send_ext(pi, PIGPIOD_CMD_WVCRE, 0, 0, NULL, 0, &w->res_create);
+    status = pigpiod_sync(pi);
+    if (status == PIGPIOD_ERR_IO)
+        return status;
+    if (w->res_create < 0) {
+        w->stats.errors++;
+        return w->res_create;
+    }
+    int wid = w->res_create;
+
+    // Обмен 2: запуск с конца текущего цикла и какая волна идёт сейчас
+    pigpiod_send_ext(pi, PIGPIOD_CMD_WVTXM, wid, PIGPIOD_WAVE_MODE_REPEAT_SYNC, NULL, 0, &w->res_tx);
+    pigpiod_send_ext(pi, PIGPIOD_CMD_WVTAT, 0, 0, NULL, 0, &w->res_tat);
+    status = pigpiod_sync(pi);
+    if (status == PIGPIOD_ERR_IO)
+        return status;
+    if (w->res_tx < 0) {
+        w->stats.errors++;
+        pigpiod_send(pi, PIGPIOD_CMD_WVDEL, wid, 0);
+        return w->res_tx;
+    }
+
+    w->queue[w->queued++] = wid;
+    w->stats.updates++;
+    w->stats.pulses = np;
+    wave_release(w, pi, w->res_tat);
+    return 0;
+}
+
+int servo_wave_stop(servo_wave_t *w, pigpiod_t *pi) {
+    pigpiod_send(pi, PIGPIOD_CMD_WVHLT, 0, 0);
+    // Остановка могла прийтись на импульс: опускаем выходы
+    for (unsigned g = 0; g < SERVO_WAVE_GPIOS; g++) {
+        if (w->outputs & (1u << g))
+            pigpiod_send(pi, PIGPIOD_CMD_WRITE, g, 0);
+    }
+    for (int i = 0; i < w->queued; i++)
+        pigpiod_send(pi, PIGPIOD_CMD_WVDEL, w->queue[i], 0);
+    w->stats.deleted += w->queued;
+    w->queued = 0;
+    int status = pigpiod_sync(pi);
+    if (status < 0)
+        w->stats.errors++;
+    return status;
+}
+
+void servo_wave_release_gpio(servo_wave_t *w, unsigned gpio) {
+    if (gpio < SERVO_WAVE_GPIOS)
+        w->outputs &= ~(1u << gpio);
+}
+
+void servo_wave_get_stats(servo_wave_t *w, servo_wave_stats_t *st) {
+    *st = w->stats;
+}
@@ -0,0 +1,54 @@
+#ifndef SERVO_WAVE_H
+#define SERVO_WAVE_H
+
+#include <stdint.h>
+#include "pigpiod_client.h"
+
+// Все каналы сервоприводов одной волной pigpio. Кадр (20 мс) описывается
+// как одна повторяющаяся волна: в начале кадра поднимаются все включённые
+// выходы, каждый опускается через свою ширину импульса, остаток кадра —
+// пауза. Импульсов в волне — не больше числа разных ширин плюс один, и
+// волна уходит одной командой WVAG при любом числе каналов.
+//
+// Обновление — два обмена с демоном при любом числе каналов:
+//   1) WVNEW, WVAG, WVCRE — создать волну, получить её id;
+//   2) WVTXM (REPEAT_SYNC), WVTAT — запустить её с конца текущего цикла
+//      и узнать, какая волна передаётся сейчас.
+// Смена волны происходит на границе кадра, поэтому все каналы меняются
+// одновременно и импульс не обрывается. Старые волны удаляются (WVDEL)
+// только после того, как WVTAT показал, что передаётся более новая.
+//
+// Функции не потокобезопасны: servo_output вызывает их под своей блокировкой.
+
+#define SERVO_WAVE_GPIOS 32
+#define SERVO_WAVE_QUEUE 8 // Созданных волн, ещё не удалённых
+
+typedef struct {
+    unsigned long updates; // Волн запущено
+    unsigned long deleted; // Волн удалено
+    unsigned long skipped; // Обновлений, отложенных до освобождения старых волн
+    unsigned long errors;  // Ошибок демона
+    unsigned pulses;       // Импульсов в последней волне
+} servo_wave_stats_t;
+
+typedef struct servo_wave servo_wave_t;
+
+servo_wave_t *servo_wave_new(unsigned frame_us);
+// Освобождает только память; волну в демоне останавливает servo_wave_stop
+void servo_wave_free(servo_wave_t *w);
+
+// Новая волна: pulsewidth[g] (500..2500 мкс, 0 — выключен) для GPIO из
+// mask. 0 — запущена, 1 — отложена (очередь старых волн полна, повторите
+// в следующем кадре), < 0 — код ошибки pigpio или PIGPIOD_ERR_IO.
+int servo_wave_update(servo_wave_t *w, pigpiod_t *pi, const unsigned *pulsewidth, uint32_t mask);
+// Останавливает волну, опускает выходы и удаляет свои волны
+int servo_wave_stop(servo_wave_t *w, pigpiod_t *pi);
+
+// Вывод больше не принадлежит волне (ушёл на аппаратный ШИМ): servo_wave_stop
+// его не трогает, иначе WRITE вернул бы его в режим выхода. Исключить его
+// из mask следующих обновлений — дело вызывающего.
+void servo_wave_release_gpio(servo_wave_t *w, unsigned gpio);
+
+void servo_wave_get_stats(servo_wave_t *w, servo_wave_stats_t *st);
+
+#endif // SERVO_WAVE_H
@@ -1,108 +1,1213 @@
 #include "lcd1602.h"
+#include "lcd1602_charmap.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <fcntl.h>
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <sys/ioctl.h>
 
 #define LCD_BACKLIGHT 0x08
 #define ENABLE 0x04
+#define LCD_RW 0x02
 #define LCD_CMD 0
 #define LCD_DATA 1
 
-static int i2c_fd = -1;
-static uint8_t i2c_addr = 0x27;
+// Время выполнения команд HD44780 по даташиту (мкс, генератор 270 кГц)
+#define LCD_EXEC_US 37
+#define LCD_CLEAR_US 1520
+
+// Сколько ждать снятия флага занятости, прежде чем считать чтение неработающим
+#define LCD_BUSY_TIMEOUT_US 10000
+
+// Частота шины I2C, если её не удалось узнать из device tree
+#define LCD_DEFAULT_BUS_HZ 100000
+
+// Буфер кадра: полный кадр (2 команды позиционирования + 32 символа)
+// занимает около 140 байт, загрузка всех 8 глифов CGRAM — ещё около 300,
+// остальное — запас под паузы после команд и бегущую строку
+#define LCD_TX_MAX 1024
+
+#define LCD_COLS 16
+#define LCD_ROWS 2
+// Длина строки в DDRAM: при сдвиге экрана строка прокручивается по кругу
+#define LCD_DDRAM_COLS 40
+// Строка кадра в UTF-8: до 4 байт на символ
+#define LCD_LINE_BYTES (LCD_DDRAM_COLS * 4 + 1)
+
+// Мест для пользовательских знаков в CGRAM (коды 0-7)
+#define LCD_CGRAM_SLOTS 8
+
+// Адресов PCF8574 (0x20-0x27) и PCF8574A (0x38-0x3F) на одной шине — 16
+#define LCD_BUS_MAX 16
+
+// ===== Асинхронная запись =====
+// Почтовый ящик на один кадр («побеждает последний») построен как тройной
+// буфер: GUI заполняет свой буфер и атомарно меняет его местами со слотом,
+// поток записи так же забирает слот. Младшие биты mailbox — индекс буфера
+// в слоте, MAILBOX_FRESH — в слоте новый, ещё не переданный кадр.
+#define MAILBOX_INDEX 0x03
+#define MAILBOX_FRESH 0x04
+
+struct lcd_frame {
+    int op;
+    char line[LCD_ROWS][LCD_LINE_BYTES];
+};
+
+// Шина I2C: один дескриптор и один поток записи на все дисплеи шины.
+// lock защищает шину и состояние всех её дисплеев: кадры разных
+// дисплеев не должны перемешиваться.
+struct lcd_bus {
+    struct lcd_bus *next;
+    char dev[64];
+    int fd;
+    // Транспорт: для устройства /dev/i2c-N — ioctl(I2C_RDWR) по fd,
+    // иначе переданный в lcd1602_open_transport (например, эмулятор)
+    lcd1602_transport_t tr;
+    unsigned long hz;
+    int refs;
+    pthread_mutex_t lock;
+
+    // Дисплеи в асинхронном режиме, которые обслуживает поток записи
+    lcd1602_t *displays[LCD_BUS_MAX];
+    int ndisplays;
+    sem_t sem;
+    pthread_t thread;
+    atomic_int running;
+};
+
+struct lcd1602 {
+    struct lcd_bus *bus;
+    uint8_t addr;
+
+    // Буфер байтов PCF8574, который отправляется на шину одной транзакцией
+    uint8_t tx_buf[LCD_TX_MAX];
+    size_t tx_len;
+    // Последнее состояние выводов PCF8574 и режим RS (-1 — неизвестен)
+    uint8_t port_state;
+    int port_mode;
+
+    // Теневая копия экрана: какие коды знакогенератора сейчас на дисплее.
+    // Пока shadow_valid == 0, содержимое дисплея считается неизвестным.
+    char shadow[LCD_ROWS][LCD_COLS];
+    int shadow_valid;
+
+    // Кэш CGRAM: номер глифа в каждом месте (-1 — содержимое неизвестно),
+    // время последнего использования для LRU и места, занятые текущим
+    // кадром (их нельзя вытеснять, пока кадр не передан)
+    int cgram[LCD_CGRAM_SLOTS];
+    unsigned long cgram_used[LCD_CGRAM_SLOTS];
+    unsigned long cgram_clock;
+    unsigned cgram_pinned;
+
+    // Пользовательские знаки: номера глифов после встроенных
+    struct {
+        uint32_t cp;
+        uint8_t rows[8];
+    } custom[LCD1602_CUSTOM_GLYPHS];
+    int ncustom;
+
+    // Способ ожидания готовности контроллера и текущие паузы (мкс).
+    // Паузы начинаются с минимальных значений из даташита и уточняются
+    // калибровкой по флагу занятости, если модуль поддерживает чтение.
+    int wait_mode;
+    unsigned exec_us;
+    unsigned clear_us;
+    lcd1602_latency_t latency;
+
+    lcd1602_stats_t stats;
+    struct timespec frame_start;
+    unsigned long frame_bytes, frame_syscalls;
+    int frame_error;
+
+    struct lcd_frame frames[3];
+    atomic_int mailbox;
+    atomic_int wait_request; // Режим ожидания для потока записи (-1 — нет)
+    int back_idx;  // буфер GUI-потока
+    int front_idx; // буфер потока записи
+    int async;
+    lcd1602_done_cb done_cb;
+    void *done_user_data;
+
+    // Бегущая строка: текст лежит в DDRAM, поток записи сдвигает экран
+    // командой 0x18 по таймеру. shift — текущий сдвиг (0..39).
+    int marquee;
+    unsigned shift;
+    struct timespec next_step;
+    atomic_uint marquee_ms;
+};
+
+// Список открытых шин
+static struct lcd_bus *buses;
+static pthread_mutex_t buses_lock = PTHREAD_MUTEX_INITIALIZER;
 
 // Прототипы внутренних функций
-static void lcd_write_byte(uint8_t data, uint8_t mode);
-static void lcd_toggle_enable(uint8_t data);
-static void lcd_send_cmd(uint8_t cmd);
-static void lcd_send_data(uint8_t data);
-static void lcd_set_cursor(int col, int row);
+static struct lcd_bus *lcd_bus_get(const char *i2c_dev, const lcd1602_transport_t *tr);
+static int lcd_i2c_transfer(void *ctx, struct i2c_msg *msgs, int nmsgs);
+static lcd1602_t *lcd_open(struct lcd_bus *bus, uint8_t addr);
+static void lcd_bus_put(struct lcd_bus *bus);
+static int lcd_bus_flush(struct lcd_bus *bus, lcd1602_t *const *lcds, int n);
+static void lcd_queue_byte(lcd1602_t *lcd, uint8_t data);
+static void lcd_queue_nibble(lcd1602_t *lcd, uint8_t data, uint8_t mode);
+static void lcd_queue_wait(lcd1602_t *lcd, unsigned us, int cls);
+static void lcd_wait_long(lcd1602_t *lcd);
+static int lcd_read_busy(lcd1602_t *lcd);
+static int lcd_wait_ready(lcd1602_t *lcd, unsigned long *waited_us);
+static void lcd_latency_add(lcd1602_t *lcd, int cls, unsigned long us);
+static void lcd_send_cmd(lcd1602_t *lcd, uint8_t cmd);
+static void lcd_send_data(lcd1602_t *lcd, uint8_t data);
+static void lcd_set_cursor(lcd1602_t *lcd, int col, int row);
+static int lcd_map_line(lcd1602_t *lcd, unsigned *out, const char *s, int cols, int pad);
+static int lcd_cgram_find(lcd1602_t *lcd, int glyph);
+static void lcd_cgram_pin(lcd1602_t *lcd, const unsigned *syms, int n);
+static void lcd_cgram_resolve(lcd1602_t *lcd, unsigned *syms, int n);
+static void lcd_build_clear(lcd1602_t *lcd);
+static void lcd_build_update(lcd1602_t *lcd, const char *line1, const char *line2);
+static int lcd_build_wait_mode(lcd1602_t *lcd, int mode);
+static void lcd_build_marquee(lcd1602_t *lcd, const char *line1, const char *line2);
+static void lcd_marquee_cancel(lcd1602_t *lcd);
+static void lcd_marquee_step(lcd1602_t *lcd, const struct timespec *now);
+static void lcd_timespec_add_ms(struct timespec *ts, unsigned ms);
+static int lcd_timespec_before(const struct timespec *a, const struct timespec *b);
+static void lcd_flush(lcd1602_t *lcd);
+static void lcd_frame_begin(lcd1602_t *lcd);
+static int lcd_frame_end(lcd1602_t *lcd);
+static int lcd_submit_frame(lcd1602_t *lcd, int op, const char *line1, const char *line2);
+static void *lcd_writer_main(void *arg);
+static unsigned long lcd_read_bus_hz(const char *i2c_dev);
+
+lcd1602_t *lcd1602_open(const char *i2c_dev, uint8_t addr) {
+    struct lcd_bus *bus = lcd_bus_get(i2c_dev, NULL);
+    return bus ? lcd_open(bus, addr) : NULL;
+}
+
+lcd1602_t *lcd1602_open_transport(const lcd1602_transport_t *tr, uint8_t addr) {
+    struct lcd_bus *bus = lcd_bus_get(NULL, tr);
+    return bus ? lcd_open(bus, addr) : NULL;
+}
+
+// Создаёт дисплей на уже открытой шине и инициализирует его.
+// При ошибке отпускает шину.
+static lcd1602_t *lcd_open(struct lcd_bus *bus, uint8_t addr) {
+    lcd1602_t *lcd = calloc(1, sizeof(*lcd));
+    if (!lcd) {
+        perror("Unable to allocate LCD");
+        lcd_bus_put(bus);
+        return NULL;
+    }
+
+    lcd->bus = bus;
+    lcd->addr = addr;
+    lcd->port_state = LCD_BACKLIGHT;
+    lcd->port_mode = -1;
+    lcd->wait_mode = LCD1602_WAIT_DELAY;
+    lcd->exec_us = LCD_EXEC_US;
+    lcd->clear_us = LCD_CLEAR_US;
+    atomic_init(&lcd->mailbox, 0);
+    atomic_init(&lcd->wait_request, -1);
+    lcd->back_idx = 1;
+    lcd->front_idx = 2;
+    atomic_init(&lcd->marquee_ms, LCD1602_MARQUEE_DEFAULT_MS);
+    for (int i = 0; i < LCD_CGRAM_SLOTS; i++)
+        lcd->cgram[i] = -1;
+
+    // Инициализация LCD (4-bit mode): три раза 0x3, затем переход на 0x2
+    usleep(50000);
+    pthread_mutex_lock(&lcd->bus->lock);
+    lcd_frame_begin(lcd);
+    lcd_queue_nibble(lcd, 0x30, LCD_CMD);
+    lcd_queue_wait(lcd, 4100, -1);
+    lcd_queue_nibble(lcd, 0x30, LCD_CMD);
+    lcd_queue_wait(lcd, 100, -1);
+    lcd_queue_nibble(lcd, 0x30, LCD_CMD);
+    lcd_queue_wait(lcd, 100, -1);
+    lcd_queue_nibble(lcd, 0x20, LCD_CMD);
+    lcd_queue_wait(lcd, LCD_EXEC_US, -1);
+    lcd_send_cmd(lcd, 0x28);
+    lcd_send_cmd(lcd, 0x0C);
+    lcd_send_cmd(lcd, 0x06);
+    lcd_send_cmd(lcd, 0x01);
+    lcd_queue_wait(lcd, LCD_CLEAR_US, -1);
+    memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+    lcd->shadow_valid = 1;
+    int status = lcd_frame_end(lcd);
+    pthread_mutex_unlock(&lcd->bus->lock);
+
+    if (status != 0) {
+        fprintf(stderr, "LCD at 0x%02X does not respond\n", addr);
+        lcd_bus_put(lcd->bus);
+        free(lcd);
+        return NULL;
+    }
+    return lcd;
+}
+
+void lcd1602_close(lcd1602_t *lcd) {
+    if (!lcd)
+        return;
+    lcd1602_async_stop(lcd);
+    lcd_bus_put(lcd->bus);
+    free(lcd);
+}
+
+uint8_t lcd1602_addr(const lcd1602_t *lcd) {
+    return lcd->addr;
+}
+
+int lcd1602_clear(lcd1602_t *lcd) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    lcd_frame_begin(lcd);
+    lcd_build_clear(lcd);
+    int status = lcd_frame_end(lcd);
+    pthread_mutex_unlock(&lcd->bus->lock);
+    return status;
+}
+
+int lcd1602_home(lcd1602_t *lcd) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    lcd_frame_begin(lcd);
+    lcd_send_cmd(lcd, 0x02);
+    lcd_wait_long(lcd);
+    lcd->marquee = 0;
+    lcd->shift = 0;
+    int status = lcd_frame_end(lcd);
+    pthread_mutex_unlock(&lcd->bus->lock);
+    return status;
+}
+
+int lcd1602_write(lcd1602_t *lcd, const char *line1, const char *line2) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    const char *lines[LCD_ROWS] = {line1, line2};
+    unsigned syms[LCD_ROWS][LCD_COLS];
+    int len[LCD_ROWS];
+
+    lcd_frame_begin(lcd);
+    lcd_marquee_cancel(lcd);
+    lcd->cgram_pinned = 0;
+    for (int row = 0; row < LCD_ROWS; row++) {
+        len[row] = lcd_map_line(lcd, syms[row], lines[row], LCD_COLS, 0);
+        // Хвост строки остаётся на экране и держит свои места CGRAM
+        for (int i = len[row]; lcd->shadow_valid && i < LCD_COLS; i++) {
+            if ((uint8_t)lcd->shadow[row][i] < LCD_CGRAM_SLOTS)
+                lcd->cgram_pinned |= 1u << (uint8_t)lcd->shadow[row][i];
+        }
+        lcd_cgram_pin(lcd, syms[row], len[row]);
+    }
+    for (int row = 0; row < LCD_ROWS; row++)
+        lcd_cgram_resolve(lcd, syms[row], len[row]);
+
+    for (int row = 0; row < LCD_ROWS; row++) {
+        lcd_set_cursor(lcd, 0, row);
+        for (int i = 0; i < len[row]; i++) {
+            lcd_send_data(lcd, syms[row][i]);
+            lcd->shadow[row][i] = syms[row][i];
+        }
+    }
+    int status = lcd_frame_end(lcd);
+    pthread_mutex_unlock(&lcd->bus->lock);
+    return status;
+}
+
+int lcd1602_update(lcd1602_t *lcd, const char *line1, const char *line2) {
+    return lcd1602_update_many(&lcd, &line1, &line2, 1);
+}
+
+int lcd1602_update_many(lcd1602_t *const *lcds, const char *const *line1,
+                        const char *const *line2, int n) {
+    struct lcd_bus *bus = lcds[0]->bus;
+    int status = 0;
+
+    for (int i = 1; i < n; i++) {
+        if (lcds[i]->bus != bus) {
+            fprintf(stderr, "lcd1602_update_many: displays are on different buses\n");
+            return -1;
+        }
+    }
+
+    // Сначала собираем кадры всех дисплеев, затем отправляем их одним
+    // I2C_RDWR: по сообщению на дисплей, каждое со своим адресом
+    pthread_mutex_lock(&bus->lock);
+    for (int i = 0; i < n; i++) {
+        lcd_frame_begin(lcds[i]);
+        lcd_build_update(lcds[i], line1[i], line2[i]);
+    }
+    lcd_bus_flush(bus, lcds, n);
+    for (int i = 0; i < n; i++) {
+        if (lcd_frame_end(lcds[i]) != 0)
+            status = -1;
+    }
+    pthread_mutex_unlock(&bus->lock);
+    return status;
+}
+
+void lcd1602_get_stats(lcd1602_t *lcd, lcd1602_stats_t *st) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    *st = lcd->stats;
+    pthread_mutex_unlock(&lcd->bus->lock);
+}
+
+int lcd1602_set_wait_mode(lcd1602_t *lcd, int mode) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    lcd_frame_begin(lcd);
+    mode = lcd_build_wait_mode(lcd, mode);
+    lcd_frame_end(lcd);
+    pthread_mutex_unlock(&lcd->bus->lock);
+    return mode;
+}
+
+void lcd1602_get_latency(lcd1602_t *lcd, lcd1602_latency_t *lat) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    *lat = lcd->latency;
+    pthread_mutex_unlock(&lcd->bus->lock);
+}
+
+void lcd1602_reset_latency(lcd1602_t *lcd) {
+    pthread_mutex_lock(&lcd->bus->lock);
+    memset(&lcd->latency, 0, sizeof(lcd->latency));
+    pthread_mutex_unlock(&lcd->bus->lock);
+}
+
+void lcd1602_print_latency(lcd1602_t *lcd, FILE *out) {
+    static const char *names[LCD1602_LAT_CLASSES] = {"data", "cmd", "clear/home"};
+    lcd1602_latency_t lat;
+
+    lcd1602_get_latency(lcd, &lat);
+    fprintf(out, "LCD1602 0x%02X latency (%s mode), us:\n", lcd->addr,
+            lcd->wait_mode == LCD1602_WAIT_BUSY ? "busy-flag" : "delay");
+    fprintf(out, "%14s %10s %10s %10s\n", "range", names[0], names[1], names[2]);
+    for (int b = 0; b < LCD1602_HIST_BUCKETS; b++) {
+        unsigned long lo = b ? 1UL << (b - 1) : 0;
+        unsigned long hi = b ? (1UL << b) - 1 : 0;
+        if (!lat.count[0][b] && !lat.count[1][b] && !lat.count[2][b])
+            continue;
+        fprintf(out, "%6lu..%-6lu %10lu %10lu %10lu\n", lo, hi,
+                lat.count[0][b], lat.count[1][b], lat.count[2][b]);
+    }
+}
 
-int lcd1602_init(const char *i2c_dev, uint8_t addr) {
-    i2c_addr = addr;
+int lcd1602_async_start(lcd1602_t *lcd, lcd1602_done_cb cb, void *user_data) {
+    struct lcd_bus *bus = lcd->bus;
+    int status = 0;
+
+    pthread_mutex_lock(&bus->lock);
+    lcd->done_cb = cb;
+    lcd->done_user_data = user_data;
+    if (!lcd->async) {
+        if (bus->ndisplays == LCD_BUS_MAX) {
+            status = -1;
+        } else {
+            bus->displays[bus->ndisplays++] = lcd;
+            lcd->async = 1;
+        }
+    }
+
+    // Поток записи один на шину; он живёт, пока шина открыта
+    if (status == 0 && !atomic_load(&bus->running)) {
+        if (sem_init(&bus->sem, 0, 0) < 0) {
+            perror("Unable to create LCD writer semaphore");
+            status = -1;
+        } else {
+            atomic_store(&bus->running, 1);
+            if (pthread_create(&bus->thread, NULL, lcd_writer_main, bus) != 0) {
+                fprintf(stderr, "Unable to start LCD writer thread\n");
+                atomic_store(&bus->running, 0);
+                sem_destroy(&bus->sem);
+                status = -1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&bus->lock);
+    return status;
+}
 
-    if ((i2c_fd = open(i2c_dev, O_RDWR)) < 0) {
-        perror("Unable to open I2C device");
+int lcd1602_submit(lcd1602_t *lcd, const char *line1, const char *line2) {
+    return lcd1602_submit_many(&lcd, &line1, &line2, 1);
+}
+
+int lcd1602_submit_many(lcd1602_t *const *lcds, const char *const *line1,
+                        const char *const *line2, int n) {
+    int wake[LCD_BUS_MAX] = {0};
+    int status = 0;
+
+    if (n > LCD_BUS_MAX)
         return -1;
+
+    for (int i = 0; i < n; i++) {
+        wake[i] = lcd_submit_frame(lcds[i], LCD1602_OP_UPDATE, line1[i], line2[i]);
+        if (wake[i] < 0)
+            status = -1;
+    }
+
+    // Будим поток шины один раз и только после того, как все кадры
+    // лежат в ящиках: проснувшись, он заберёт их одной транзакцией
+    for (int i = 0; i < n; i++) {
+        if (wake[i] <= 0)
+            continue;
+        for (int j = i + 1; j < n; j++) {
+            if (lcds[j]->bus == lcds[i]->bus)
+                wake[j] = 0;
+        }
+        sem_post(&lcds[i]->bus->sem);
     }
+    return status;
+}
 
-    if (ioctl(i2c_fd, I2C_SLAVE, i2c_addr) < 0) {
-        perror("Unable to select I2C device");
+int lcd1602_submit_clear(lcd1602_t *lcd) {
+    int wake = lcd_submit_frame(lcd, LCD1602_OP_CLEAR, NULL, NULL);
+    if (wake < 0)
         return -1;
+    if (wake)
+        sem_post(&lcd->bus->sem);
+    return 0;
+}
+
+int lcd1602_define_glyph(lcd1602_t *lcd, uint32_t cp, const uint8_t rows[8]) {
+    int status = 0;
+
+    pthread_mutex_lock(&lcd->bus->lock);
+    int i = 0;
+    while (i < lcd->ncustom && lcd->custom[i].cp != cp)
+        i++;
+    if (i == LCD1602_CUSTOM_GLYPHS) {
+        status = -1;
+    } else {
+        if (i == lcd->ncustom)
+            lcd->ncustom++;
+        lcd->custom[i].cp = cp;
+        memcpy(lcd->custom[i].rows, rows, sizeof(lcd->custom[i].rows));
+        // Старая картинка знака в CGRAM больше не годится
+        int slot = lcd_cgram_find(lcd, LCD_CHARMAP_GLYPHS + i);
+        if (slot >= 0) {
+            lcd->cgram[slot] = -1;
+            lcd->cgram_used[slot] = 0;
+        }
     }
+    pthread_mutex_unlock(&lcd->bus->lock);
+    return status;
+}
 
-    // Инициализация LCD (4-bit mode)
-    usleep(50000);
-    lcd_send_cmd(0x33);
-    lcd_send_cmd(0x32);
-    lcd_send_cmd(0x28);
-    lcd_send_cmd(0x0C);
-    lcd_send_cmd(0x06);
-    lcd_send_cmd(0x01);
-    usleep(2000);
+int lcd1602_submit_marquee(lcd1602_t *lcd, const char *line1, const char *line2,
+                           unsigned step_ms) {
+    if (step_ms == 0)
+        return -1;
+    lcd1602_set_marquee_rate(lcd, step_ms);
+
+    int wake = lcd_submit_frame(lcd, LCD1602_OP_MARQUEE, line1, line2);
+    if (wake < 0)
+        return -1;
+    if (wake)
+        sem_post(&lcd->bus->sem);
+    return 0;
+}
 
+int lcd1602_submit_wait_mode(lcd1602_t *lcd, int mode) {
+    if (!lcd->async)
+        return -1;
+    // Не в почтовом ящике: следующий кадр текста не должен вытеснить запрос
+    atomic_store(&lcd->wait_request, mode);
+    sem_post(&lcd->bus->sem);
     return 0;
 }
 
-void lcd1602_clear() {
-    lcd_send_cmd(0x01);
-    usleep(2000);
+void lcd1602_set_marquee_rate(lcd1602_t *lcd, unsigned step_ms) {
+    if (step_ms > 0)
+        atomic_store(&lcd->marquee_ms, step_ms);
 }
 
-void lcd1602_home() {
-    lcd_send_cmd(0x02);
-    usleep(2000);
+void lcd1602_async_stop(lcd1602_t *lcd) {
+    struct lcd_bus *bus = lcd->bus;
+
+    pthread_mutex_lock(&bus->lock);
+    for (int i = 0; i < bus->ndisplays; i++) {
+        if (bus->displays[i] == lcd) {
+            bus->displays[i] = bus->displays[--bus->ndisplays];
+            break;
+        }
+    }
+    lcd->async = 0;
+    pthread_mutex_unlock(&bus->lock);
 }
 
-void lcd1602_write(const char *line1, const char *line2) {
-    lcd_set_cursor(0, 0);
-    for (int i = 0; i < 16 && line1[i]; i++) {
-        lcd_send_data(line1[i]);
+// ===== Внутренние функции =====
+
+// Находит открытую шину по имени устройства (или по контексту транспорта)
+// или открывает новую
+static struct lcd_bus *lcd_bus_get(const char *i2c_dev, const lcd1602_transport_t *tr) {
+    struct lcd_bus *bus;
+
+    pthread_mutex_lock(&buses_lock);
+    for (bus = buses; bus; bus = bus->next) {
+        if (tr ? bus->fd < 0 && bus->tr.ctx == tr->ctx : strcmp(bus->dev, i2c_dev) == 0)
+            break;
     }
 
-    lcd_set_cursor(0, 1);
-    for (int i = 0; i < 16 && line2[i]; i++) {
-        lcd_send_data(line2[i]);
+    if (!bus) {
+        bus = calloc(1, sizeof(*bus));
+        if (!bus) {
+            perror("Unable to allocate I2C bus");
+            pthread_mutex_unlock(&buses_lock);
+            return NULL;
+        }
+        if (tr) {
+            bus->fd = -1;
+            bus->tr = *tr;
+            bus->hz = tr->hz ? tr->hz : LCD_DEFAULT_BUS_HZ;
+        } else {
+            if ((bus->fd = open(i2c_dev, O_RDWR)) < 0) {
+                perror("Unable to open I2C device");
+                free(bus);
+                pthread_mutex_unlock(&buses_lock);
+                return NULL;
+            }
+            snprintf(bus->dev, sizeof(bus->dev), "%s", i2c_dev);
+            bus->tr.transfer = lcd_i2c_transfer;
+            bus->tr.ctx = bus;
+            bus->hz = lcd_read_bus_hz(i2c_dev);
+        }
+        pthread_mutex_init(&bus->lock, NULL);
+        atomic_init(&bus->running, 0);
+        bus->next = buses;
+        buses = bus;
     }
+    bus->refs++;
+    pthread_mutex_unlock(&buses_lock);
+    return bus;
 }
 
-void lcd1602_close() {
-    if (i2c_fd >= 0)
-        close(i2c_fd);
+static void lcd_bus_put(struct lcd_bus *bus) {
+    pthread_mutex_lock(&buses_lock);
+    if (--bus->refs > 0) {
+        pthread_mutex_unlock(&buses_lock);
+        return;
+    }
+    for (struct lcd_bus **p = &buses; *p; p = &(*p)->next) {
+        if (*p == bus) {
+            *p = bus->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&buses_lock);
+
+    if (atomic_exchange(&bus->running, 0)) {
+        sem_post(&bus->sem);
+        pthread_join(bus->thread, NULL);
+        sem_destroy(&bus->sem);
+    }
+    if (bus->fd >= 0)
+        close(bus->fd);
+    pthread_mutex_destroy(&bus->lock);
+    free(bus);
 }
 
-// ===== Внутренние функции =====
+// Транспорт устройства /dev/i2c-N: все сообщения — один ioctl(I2C_RDWR)
+static int lcd_i2c_transfer(void *ctx, struct i2c_msg *msgs, int nmsgs) {
+    struct lcd_bus *bus = ctx;
+    struct i2c_rdwr_ioctl_data xfer = {.msgs = msgs, .nmsgs = nmsgs};
+    return ioctl(bus->fd, I2C_RDWR, &xfer) < 0 ? -1 : 0;
+}
+
+// Отправляет накопленные буферы n дисплеев одной транзакцией I2C_RDWR:
+// каждый дисплей — отдельное сообщение со своим адресом
+static int lcd_bus_flush(struct lcd_bus *bus, lcd1602_t *const *lcds, int n) {
+    struct i2c_msg msgs[LCD_BUS_MAX];
+    lcd1602_t *sent[LCD_BUS_MAX];
+    int nmsgs = 0;
+    int status = 0;
 
-static void lcd_send_cmd(uint8_t cmd) {
-    lcd_write_byte(cmd & 0xF0, LCD_CMD);
-    lcd_write_byte((cmd << 4) & 0xF0, LCD_CMD);
+    for (int i = 0; i < n; i++) {
+        if (lcds[i]->tx_len == 0)
+            continue;
+        msgs[nmsgs].addr = lcds[i]->addr;
+        msgs[nmsgs].flags = 0;
+        msgs[nmsgs].len = lcds[i]->tx_len;
+        msgs[nmsgs].buf = lcds[i]->tx_buf;
+        sent[nmsgs++] = lcds[i];
+        if (nmsgs == LCD_BUS_MAX && i + 1 < n) {
+            // Больше сообщений, чем дисплеев на шине, не бывает; на всякий
+            // случай отправляем остаток следующей транзакцией
+            status |= lcd_bus_flush(bus, lcds + i + 1, n - i - 1);
+            break;
+        }
+    }
+    if (nmsgs == 0)
+        return status;
+
+    int failed = bus->tr.transfer(bus->tr.ctx, msgs, nmsgs) < 0;
+
+    for (int i = 0; i < nmsgs; i++) {
+        lcd1602_t *lcd = sent[i];
+        if (failed) {
+            lcd->port_mode = -1; // состояние порта после ошибки неизвестно
+            lcd->frame_error = 1;
+        }
+        lcd->frame_syscalls++;
+        lcd->frame_bytes += lcd->tx_len;
+        lcd->tx_len = 0;
+    }
+    return failed ? -1 : status;
+}
+
+static void lcd_send_cmd(lcd1602_t *lcd, uint8_t cmd) {
+    lcd_queue_nibble(lcd, cmd & 0xF0, LCD_CMD);
+    lcd_queue_nibble(lcd, (cmd << 4) & 0xF0, LCD_CMD);
+    lcd_queue_wait(lcd, lcd->exec_us, LCD1602_LAT_CMD);
+}
+
+static void lcd_send_data(lcd1602_t *lcd, uint8_t data) {
+    lcd_queue_nibble(lcd, data & 0xF0, LCD_DATA);
+    lcd_queue_nibble(lcd, (data << 4) & 0xF0, LCD_DATA);
+    lcd_queue_wait(lcd, lcd->exec_us, LCD1602_LAT_DATA);
+}
+
+static void lcd_queue_byte(lcd1602_t *lcd, uint8_t data) {
+    if (lcd->tx_len == sizeof(lcd->tx_buf))
+        lcd_flush(lcd);
+    lcd->tx_buf[lcd->tx_len++] = data;
+    lcd->port_state = data;
+}
+
+// Полубайт = импульс E: E-high с данными, затем E-low.
+// Отдельный байт установки RS нужен только при смене режима команда/данные:
+// данные D4-D7 защёлкиваются по спаду E, и байт E-high даёт им время установки.
+static void lcd_queue_nibble(lcd1602_t *lcd, uint8_t data, uint8_t mode) {
+    uint8_t buf = (data & 0xF0) | LCD_BACKLIGHT | (mode ? 0x01 : 0x00);
+    if (lcd->port_mode != mode)
+        lcd_queue_byte(lcd, buf);
+    lcd_queue_byte(lcd, buf | ENABLE);
+    lcd_queue_byte(lcd, buf);
+    lcd->port_mode = mode;
+}
+
+// Пауза без usleep: повторяем текущее состояние порта, пока шина не
+// отработает нужное время. Один байт I2C — 9 тактов SCL, а следующий
+// импульс E начнётся не раньше, чем через ещё один байт.
+// cls — класс команды для гистограммы задержек (-1 — не учитывать).
+static void lcd_queue_wait(lcd1602_t *lcd, unsigned us, int cls) {
+    unsigned long byte_ns = 9000000000UL / lcd->bus->hz;
+    unsigned long n = (us * 1000UL + byte_ns - 1) / byte_ns;
+    for (unsigned long i = 1; i < n; i++)
+        lcd_queue_byte(lcd, lcd->port_state);
+    if (cls >= 0)
+        lcd_latency_add(lcd, cls, (n ? n : 1) * byte_ns / 1000);
 }
 
-static void lcd_send_data(uint8_t data) {
-    lcd_write_byte(data & 0xF0, LCD_DATA);
-    lcd_write_byte((data << 4) & 0xF0, LCD_DATA);
+// Ожидание после долгой команды (очистка, home). В режиме флага занятости
+// кадр отправляется сразу, а затем BF опрашивается до готовности контроллера.
+// Короткие команды так не ждём: одна транзакция чтения длиннее 37 мкс.
+static void lcd_wait_long(lcd1602_t *lcd) {
+    unsigned long us;
+
+    if (lcd->wait_mode == LCD1602_WAIT_BUSY) {
+        lcd_flush(lcd);
+        if (lcd_wait_ready(lcd, &us) == 0) {
+            lcd_latency_add(lcd, LCD1602_LAT_LONG, us);
+            return;
+        }
+        // Чтение перестало работать — дальше только паузы
+        lcd->wait_mode = LCD1602_WAIT_DELAY;
+    }
+    lcd_queue_wait(lcd, lcd->clear_us, LCD1602_LAT_LONG);
 }
 
-static void lcd_write_byte(uint8_t data, uint8_t mode) {
-    uint8_t buf = data | LCD_BACKLIGHT | (mode ? 0x01 : 0x00);
-    if (write(i2c_fd, &buf, 1) != 1) return;
-    lcd_toggle_enable(buf);
+// Читает флаг занятости через PCF8574 одной транзакцией I2C_RDWR:
+// RW=1, D4-D7 в «1» (квазидвунаправленные выводы), импульс E и чтение
+// старшего полубайта (D7 = BF), затем холостой импульс для младшего.
+// Возвращает 1 — занят, 0 — готов, -1 — ошибка чтения.
+static int lcd_read_busy(lcd1602_t *lcd) {
+    uint8_t rd = 0xF0 | LCD_BACKLIGHT | LCD_RW;
+    uint8_t pre[2] = {rd, rd | ENABLE};
+    uint8_t post[3] = {rd, rd | ENABLE, rd};
+    uint8_t val = 0;
+    struct i2c_msg msgs[3] = {
+        {.addr = lcd->addr, .flags = 0, .len = sizeof(pre), .buf = pre},
+        {.addr = lcd->addr, .flags = I2C_M_RD, .len = 1, .buf = &val},
+        {.addr = lcd->addr, .flags = 0, .len = sizeof(post), .buf = post},
+    };
+
+    lcd->frame_syscalls++;
+    lcd->frame_bytes += sizeof(pre) + 1 + sizeof(post);
+    // После чтения нужен байт установки с RW=0 перед следующей записью
+    lcd->port_state = rd;
+    lcd->port_mode = -1;
+    if (lcd->bus->tr.transfer(lcd->bus->tr.ctx, msgs, 3) < 0)
+        return -1;
+    return (val & 0x80) ? 1 : 0;
 }
 
-static void lcd_toggle_enable(uint8_t data) {
-    uint8_t buf = data | ENABLE;
-    write(i2c_fd, &buf, 1);
-    usleep(500);
-    buf = data & ~ENABLE;
-    write(i2c_fd, &buf, 1);
-    usleep(100);
+// Опрашивает BF, пока контроллер не освободится.
+// Возвращает 0 и время ожидания в мкс или -1, если чтение не работает.
+static int lcd_wait_ready(lcd1602_t *lcd, unsigned long *waited_us) {
+    struct timespec t0, now;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (;;) {
+        int busy = lcd_read_busy(lcd);
+        if (busy < 0)
+            return -1;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        unsigned long us = (now.tv_sec - t0.tv_sec) * 1000000L +
+                           (now.tv_nsec - t0.tv_nsec) / 1000;
+        if (!busy) {
+            *waited_us = us;
+            return 0;
+        }
+        if (us > LCD_BUSY_TIMEOUT_US)
+            return -1;
+    }
 }
 
-static void lcd_set_cursor(int col, int row) {
+// Гистограмма с логарифмическими корзинами: корзина 0 — 0 мкс,
+// корзина b — от 2^(b-1) до 2^b - 1 мкс, последняя собирает всё остальное
+static void lcd_latency_add(lcd1602_t *lcd, int cls, unsigned long us) {
+    int b = 0;
+    while (us && b < LCD1602_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    lcd->latency.count[cls][b]++;
+}
+
+static void lcd_set_cursor(lcd1602_t *lcd, int col, int row) {
     static const uint8_t row_offsets[] = {0x00, 0x40};
-    lcd_send_cmd(0x80 | (col + row_offsets[row]));
+    lcd_send_cmd(lcd, 0x80 | (col + row_offsets[row]));
+}
+
+static void lcd_build_clear(lcd1602_t *lcd) {
+    // Очистка заодно сбрасывает сдвиг экрана
+    lcd_send_cmd(lcd, 0x01);
+    lcd_wait_long(lcd);
+    lcd->marquee = 0;
+    lcd->shift = 0;
+    memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+    lcd->shadow_valid = 1;
+}
+
+// Переключает способ ожидания. Для флага занятости — пробное чтение и
+// калибровка: «home» выполняется столько же, сколько очистка, но не меняет
+// содержимое экрана. Он же сбрасывает сдвиг, поэтому бегущая строка
+// останавливается. Кадр отправляется сразу. Возвращает фактический режим.
+static int lcd_build_wait_mode(lcd1602_t *lcd, int mode) {
+    unsigned long us;
+
+    lcd->wait_mode = LCD1602_WAIT_DELAY;
+    if (mode != LCD1602_WAIT_BUSY)
+        return lcd->wait_mode;
+
+    lcd_queue_nibble(lcd, 0x00, LCD_CMD);
+    lcd_queue_nibble(lcd, 0x20, LCD_CMD);
+    lcd_flush(lcd);
+    lcd->marquee = 0;
+    lcd->shift = 0;
+    if (lcd_wait_ready(lcd, &us) == 0) {
+        lcd->wait_mode = LCD1602_WAIT_BUSY;
+        // Паузы для режима задержек: измеренное время + 25% запаса,
+        // короткие команды масштабируются в той же пропорции
+        if (us > 0) {
+            lcd->clear_us = us + us / 4;
+            lcd->exec_us = (LCD_EXEC_US * lcd->clear_us + LCD_CLEAR_US - 1) / LCD_CLEAR_US;
+        }
+    } else {
+        // Чтение не поддерживается (например, RW модуля посажен на землю):
+        // остаёмся на минимальных паузах из даташита; home без BF
+        // дожидаемся паузой
+        lcd->clear_us = LCD_CLEAR_US;
+        lcd->exec_us = LCD_EXEC_US;
+        lcd_queue_wait(lcd, lcd->clear_us, -1);
+    }
+    return lcd->wait_mode;
+}
+
+static void lcd_build_update(lcd1602_t *lcd, const char *line1, const char *line2) {
+    const char *lines[LCD_ROWS] = {line1, line2};
+    unsigned syms[LCD_ROWS][LCD_COLS];
+    char next[LCD_ROWS][LCD_COLS];
+
+    lcd_marquee_cancel(lcd);
+
+    // Строки короче 16 символов дополняются пробелами: так хвост
+    // предыдущего текста стирается без команды очистки
+    for (int row = 0; row < LCD_ROWS; row++)
+        lcd_map_line(lcd, syms[row], lines[row], LCD_COLS, 1);
+
+    // Глифы загружаются до записи текста. Кадр описывает весь экран,
+    // поэтому вытеснить можно любое место, которое в нём не используется:
+    // позиции со старым глифом всё равно будут переписаны.
+    lcd->cgram_pinned = 0;
+    lcd_cgram_pin(lcd, &syms[0][0], LCD_ROWS * LCD_COLS);
+    lcd_cgram_resolve(lcd, &syms[0][0], LCD_ROWS * LCD_COLS);
+    for (int row = 0; row < LCD_ROWS; row++) {
+        for (int col = 0; col < LCD_COLS; col++)
+            next[row][col] = syms[row][col];
+    }
+
+    for (int row = 0; row < LCD_ROWS; row++) {
+        int col = 0;
+        while (col < LCD_COLS) {
+            if (lcd->shadow_valid && next[row][col] == lcd->shadow[row][col]) {
+                col++;
+                continue;
+            }
+
+            // Ищем конец изменённого участка. Один неизменённый символ внутри
+            // участка дешевле переписать (4 байта), чем ставить курсор заново
+            // (команда + смена RS, около 6 байт), поэтому разрыв в 1 символ
+            // не прерывает участок.
+            int last = col;
+            for (int i = col + 1; i < LCD_COLS && i - last <= 2; i++) {
+                if (!lcd->shadow_valid || next[row][i] != lcd->shadow[row][i])
+                    last = i;
+            }
+
+            lcd_set_cursor(lcd, col, row);
+            for (int i = col; i <= last; i++) {
+                lcd_send_data(lcd, next[row][i]);
+                lcd->shadow[row][i] = next[row][i];
+            }
+            col = last + 1;
+        }
+    }
+    lcd->shadow_valid = 1;
+}
+
+// Переводит строку UTF-8 в знаки: код ПЗУ или LCD_CHARMAP_GLYPH | глиф.
+// Берётся не больше cols символов; если pad, остаток заполняется
+// пробелами. Возвращает число символов строки.
+static int lcd_map_line(lcd1602_t *lcd, unsigned *out, const char *s, int cols, int pad) {
+    int n = 0;
+
+    while (n < cols && *s) {
+        uint32_t cp = lcd_charmap_next(&s);
+        int i = 0;
+        while (i < lcd->ncustom && lcd->custom[i].cp != cp)
+            i++;
+        out[n++] = i < lcd->ncustom ? LCD_CHARMAP_GLYPH | (unsigned)(LCD_CHARMAP_GLYPHS + i)
+                                    : lcd_charmap_lookup(cp);
+    }
+    int len = n;
+    while (pad && n < cols)
+        out[n++] = ' ';
+    return len;
+}
+
+static int lcd_cgram_find(lcd1602_t *lcd, int glyph) {
+    for (int slot = 0; slot < LCD_CGRAM_SLOTS; slot++) {
+        if (lcd->cgram[slot] == glyph)
+            return slot;
+    }
+    return -1;
+}
+
+// Закрепляет за кадром места CGRAM, где уже лежат нужные ему глифы,
+// чтобы промахи того же кадра их не вытеснили
+static void lcd_cgram_pin(lcd1602_t *lcd, const unsigned *syms, int n) {
+    for (int i = 0; i < n; i++) {
+        if (!(syms[i] & LCD_CHARMAP_GLYPH))
+            continue;
+        int slot = lcd_cgram_find(lcd, syms[i] & ~LCD_CHARMAP_GLYPH);
+        if (slot >= 0)
+            lcd->cgram_pinned |= 1u << slot;
+    }
+}
+
+// Заменяет глифы кадра кодами мест CGRAM. Промах вытесняет давно не
+// использованное незакреплённое место и загружает туда глиф (команда
+// адреса CGRAM + 8 байт). Если все 8 мест заняты кадром, символ
+// выводится ближайшим знаком ПЗУ.
+static void lcd_cgram_resolve(lcd1602_t *lcd, unsigned *syms, int n) {
+    for (int i = 0; i < n; i++) {
+        if (!(syms[i] & LCD_CHARMAP_GLYPH))
+            continue;
+        int glyph = syms[i] & ~LCD_CHARMAP_GLYPH;
+        int slot = lcd_cgram_find(lcd, glyph);
+
+        if (slot >= 0) {
+            lcd->stats.cgram_hits++;
+        } else {
+            for (int s = 0; s < LCD_CGRAM_SLOTS; s++) {
+                if (lcd->cgram_pinned & (1u << s))
+                    continue;
+                if (slot < 0 || lcd->cgram_used[s] < lcd->cgram_used[slot])
+                    slot = s;
+            }
+            if (slot < 0) {
+                lcd->stats.cgram_fallbacks++;
+                syms[i] = glyph < LCD_CHARMAP_GLYPHS ? lcd_charmap_fallback(glyph) : '?';
+                continue;
+            }
+
+            const uint8_t *rows = glyph < LCD_CHARMAP_GLYPHS ? lcd_charmap_bitmap(glyph)
+                                  : lcd->custom[glyph - LCD_CHARMAP_GLYPHS].rows;
+            lcd_send_cmd(lcd, 0x40 | (slot << 3));
+            for (int r = 0; r < 8; r++)
+                lcd_send_data(lcd, rows[r]);
+            lcd->cgram[slot] = glyph;
+            lcd->stats.cgram_misses++;
+        }
+        lcd->cgram_pinned |= 1u << slot;
+        lcd->cgram_used[slot] = ++lcd->cgram_clock;
+        syms[i] = slot;
+    }
+}
+
+// Загружает бегущую строку: до 40 символов на строку прямо в DDRAM.
+// Дальше экран сдвигается командой 0x18 без повторной передачи текста.
+static void lcd_build_marquee(lcd1602_t *lcd, const char *line1, const char *line2) {
+    const char *lines[LCD_ROWS] = {line1, line2};
+    unsigned syms[LCD_ROWS][LCD_DDRAM_COLS];
+
+    // Адреса DDRAM отсчитываются от текущего сдвига, поэтому сначала
+    // возвращаем экран на место
+    if (lcd->shift != 0) {
+        lcd_send_cmd(lcd, 0x02);
+        lcd_wait_long(lcd);
+        lcd->shift = 0;
+    }
+
+    for (int row = 0; row < LCD_ROWS; row++)
+        lcd_map_line(lcd, syms[row], lines[row], LCD_DDRAM_COLS, 1);
+    lcd->cgram_pinned = 0;
+    lcd_cgram_pin(lcd, &syms[0][0], LCD_ROWS * LCD_DDRAM_COLS);
+    lcd_cgram_resolve(lcd, &syms[0][0], LCD_ROWS * LCD_DDRAM_COLS);
+
+    for (int row = 0; row < LCD_ROWS; row++) {
+        lcd_set_cursor(lcd, 0, row);
+        for (int i = 0; i < LCD_DDRAM_COLS; i++) {
+            lcd_send_data(lcd, syms[row][i]);
+            if (i < LCD_COLS)
+                lcd->shadow[row][i] = syms[row][i];
+        }
+    }
+    lcd->shadow_valid = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &lcd->next_step);
+    lcd_timespec_add_ms(&lcd->next_step, atomic_load(&lcd->marquee_ms));
+    lcd->marquee = 1;
+}
+
+// Останавливает бегущую строку перед обычным выводом: теневой буфер
+// описывает экран без сдвига, поэтому экран возвращается на место
+static void lcd_marquee_cancel(lcd1602_t *lcd) {
+    lcd->marquee = 0;
+    if (lcd->shift != 0) {
+        lcd_send_cmd(lcd, 0x02);
+        lcd_wait_long(lcd);
+        lcd->shift = 0;
+    }
+}
+
+// Один шаг бегущей строки: сдвиг экрана влево (обе строки вместе).
+// Если поток записи отстал, следующий шаг отсчитывается от текущего
+// времени, а не выполняется пачкой.
+static void lcd_marquee_step(lcd1602_t *lcd, const struct timespec *now) {
+    unsigned ms = atomic_load(&lcd->marquee_ms);
+
+    lcd_send_cmd(lcd, 0x18);
+    lcd->shift = (lcd->shift + 1) % LCD_DDRAM_COLS;
+
+    lcd_timespec_add_ms(&lcd->next_step, ms);
+    if (lcd_timespec_before(&lcd->next_step, now)) {
+        lcd->next_step = *now;
+        lcd_timespec_add_ms(&lcd->next_step, ms);
+    }
+}
+
+static void lcd_timespec_add_ms(struct timespec *ts, unsigned ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += ms % 1000 * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static int lcd_timespec_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Отправляет накопленный буфер одного дисплея
+static void lcd_flush(lcd1602_t *lcd) {
+    lcd_bus_flush(lcd->bus, &lcd, 1);
+}
+
+static void lcd_frame_begin(lcd1602_t *lcd) {
+    clock_gettime(CLOCK_MONOTONIC, &lcd->frame_start);
+    lcd->frame_bytes = 0;
+    lcd->frame_syscalls = 0;
+    lcd->frame_error = 0;
+}
+
+static int lcd_frame_end(lcd1602_t *lcd) {
+    struct timespec now;
+
+    lcd_flush(lcd);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    lcd->stats.frames++;
+    lcd->stats.bytes = lcd->frame_bytes;
+    lcd->stats.syscalls = lcd->frame_syscalls;
+    lcd->stats.us = (now.tv_sec - lcd->frame_start.tv_sec) * 1000000L +
+                    (now.tv_nsec - lcd->frame_start.tv_nsec) / 1000;
+    lcd->stats.total_bytes += lcd->frame_bytes;
+    lcd->stats.total_syscalls += lcd->frame_syscalls;
+    return lcd->frame_error ? -1 : 0;
+}
+
+// Кладёт кадр в почтовый ящик дисплея. Если поток записи ещё не забрал
+// предыдущий кадр, тот заменяется новым.
+// Возвращает 1, если поток записи нужно разбудить, 0 — если он и так
+// проснётся и заберёт уже новый кадр, -1 — асинхронный режим не запущен.
+static int lcd_submit_frame(lcd1602_t *lcd, int op, const char *line1, const char *line2) {
+    if (!lcd->async)
+        return -1;
+
+    struct lcd_frame *f = &lcd->frames[lcd->back_idx];
+    f->op = op;
+    snprintf(f->line[0], sizeof(f->line[0]), "%s", line1 ? line1 : "");
+    snprintf(f->line[1], sizeof(f->line[1]), "%s", line2 ? line2 : "");
+
+    int old = atomic_exchange(&lcd->mailbox, lcd->back_idx | MAILBOX_FRESH);
+    lcd->back_idx = old & MAILBOX_INDEX;
+    return (old & MAILBOX_FRESH) ? 0 : 1;
+}
+
+// Поток записи шины: забирает новые кадры всех дисплеев шины и отправляет
+// их одной транзакцией. Он же по таймеру сдвигает бегущие строки.
+// Обратные вызовы выполняются под блокировкой шины, поэтому из них нельзя
+// вызывать синхронные функции драйвера. Шаги бегущей строки обратный вызов
+// не получают.
+static void *lcd_writer_main(void *arg) {
+    struct lcd_bus *bus = arg;
+
+    while (1) {
+        lcd1602_t *batch[LCD_BUS_MAX];
+        int ops[LCD_BUS_MAX];
+        int n = 0;
+        struct timespec now, deadline;
+        int timed = 0;
+
+        // Ближайший шаг бегущей строки среди дисплеев шины
+        pthread_mutex_lock(&bus->lock);
+        for (int i = 0; i < bus->ndisplays; i++) {
+            lcd1602_t *lcd = bus->displays[i];
+            if (lcd->marquee && (!timed || lcd_timespec_before(&lcd->next_step, &deadline))) {
+                deadline = lcd->next_step;
+                timed = 1;
+            }
+        }
+        pthread_mutex_unlock(&bus->lock);
+
+        if (timed) {
+            // sem_timedwait ждёт по CLOCK_REALTIME, а шаги считаются по
+            // CLOCK_MONOTONIC: переводим остаток времени в абсолютный срок
+            struct timespec rt;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (lcd_timespec_before(&now, &deadline)) {
+                long ns = (deadline.tv_sec - now.tv_sec) * 1000000000L +
+                          (deadline.tv_nsec - now.tv_nsec);
+                clock_gettime(CLOCK_REALTIME, &rt);
+                rt.tv_sec += ns / 1000000000L;
+                rt.tv_nsec += ns % 1000000000L;
+                if (rt.tv_nsec >= 1000000000L) {
+                    rt.tv_sec++;
+                    rt.tv_nsec -= 1000000000L;
+                }
+                sem_timedwait(&bus->sem, &rt);
+            }
+        } else {
+            sem_wait(&bus->sem);
+        }
+        if (!atomic_load(&bus->running))
+            break;
+
+        pthread_mutex_lock(&bus->lock);
+        // Смена способа ожидания опрашивает BF, поэтому идёт своим кадром
+        // до остальных
+        for (int i = 0; i < bus->ndisplays; i++) {
+            lcd1602_t *lcd = bus->displays[i];
+            int want = atomic_exchange(&lcd->wait_request, -1);
+            if (want < 0)
+                continue;
+            lcd_frame_begin(lcd);
+            int mode = lcd_build_wait_mode(lcd, want);
+            int status = lcd_frame_end(lcd) != 0 || mode != want ? -1 : 0;
+            if (lcd->done_cb)
+                lcd->done_cb(lcd, LCD1602_OP_WAIT_MODE, status, &lcd->stats, lcd->done_user_data);
+        }
+        for (int i = 0; i < bus->ndisplays; i++) {
+            lcd1602_t *lcd = bus->displays[i];
+            // Слот освобождает только этот поток, поэтому проверка и обмен
+            // не гоняются друг с другом
+            if (!(atomic_load(&lcd->mailbox) & MAILBOX_FRESH))
+                continue;
+            int m = atomic_exchange(&lcd->mailbox, lcd->front_idx);
+            lcd->front_idx = m & MAILBOX_INDEX;
+
+            struct lcd_frame *f = &lcd->frames[lcd->front_idx];
+            lcd_frame_begin(lcd);
+            if (f->op == LCD1602_OP_CLEAR)
+                lcd_build_clear(lcd);
+            else if (f->op == LCD1602_OP_MARQUEE)
+                lcd_build_marquee(lcd, f->line[0], f->line[1]);
+            else
+                lcd_build_update(lcd, f->line[0], f->line[1]);
+            ops[n] = f->op;
+            batch[n++] = lcd;
+        }
+
+        // Шаги бегущих строк, срок которых наступил, уходят той же транзакцией
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (int i = 0; i < bus->ndisplays; i++) {
+            lcd1602_t *lcd = bus->displays[i];
+            if (!lcd->marquee || lcd_timespec_before(&now, &lcd->next_step))
+                continue;
+            int j = 0;
+            while (j < n && batch[j] != lcd)
+                j++;
+            if (j == n) {
+                lcd_frame_begin(lcd);
+                ops[n] = -1;
+                batch[n++] = lcd;
+            }
+            lcd_marquee_step(lcd, &now);
+        }
+
+        lcd_bus_flush(bus, batch, n);
+        for (int i = 0; i < n; i++) {
+            int status = lcd_frame_end(batch[i]);
+            if (ops[i] >= 0 && batch[i]->done_cb)
+                batch[i]->done_cb(batch[i], ops[i], status, &batch[i]->stats,
+                                  batch[i]->done_user_data);
+        }
+        pthread_mutex_unlock(&bus->lock);
+    }
+    return NULL;
+}
+
+// Частота шины берётся из device tree (dtparam=i2c_arm_baudrate=...):
+// свойство clock-frequency хранится как 32-битное big-endian число.
+static unsigned long lcd_read_bus_hz(const char *i2c_dev) {
+    char path[96];
+    uint8_t be[4];
+    int bus;
+
+    if (sscanf(i2c_dev, "/dev/i2c-%d", &bus) != 1)
+        return LCD_DEFAULT_BUS_HZ;
+
+    snprintf(path, sizeof(path), "/sys/class/i2c-adapter/i2c-%d/of_node/clock-frequency", bus);
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return LCD_DEFAULT_BUS_HZ;
+    size_t n = fread(be, 1, sizeof(be), f);
+    fclose(f);
+    if (n != sizeof(be))
+        return LCD_DEFAULT_BUS_HZ;
+
+    unsigned long hz = ((unsigned long)be[0] << 24) | (be[1] << 16) | (be[2] << 8) | be[3];
+    return hz ? hz : LCD_DEFAULT_BUS_HZ;
 }
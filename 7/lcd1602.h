@@ -2,11 +2,136 @@
 #define LCD1602_H
 
 #include <stdint.h>
+#include <stdio.h>
+#include <linux/i2c.h>
 
-int lcd1602_init(const char *i2c_dev, uint8_t addr);
-void lcd1602_clear();
-void lcd1602_home();
-void lcd1602_write(const char *line1, const char *line2);
-void lcd1602_close();
+// Дескриптор одного дисплея. Дисплеи на одной шине (например, 0x27 и 0x3F
+// на /dev/i2c-1) разделяют один файловый дескриптор и один поток записи.
+typedef struct lcd1602 lcd1602_t;
+
+// Статистика обмена с дисплеем. Кадр — одна операция драйвера
+// (lcd1602_write, lcd1602_clear, lcd1602_home) или шаг бегущей строки,
+// собранные в один буфер.
+// Если кадры нескольких дисплеев ушли одной транзакцией, системный вызов
+// учитывается у каждого из них.
+typedef struct {
+    unsigned long frames;         // Количество переданных кадров
+    unsigned long bytes;          // Байт PCF8574 в последнем кадре
+    unsigned long syscalls;       // Системных вызовов в последнем кадре
+    unsigned long us;             // Длительность последнего кадра, мкс
+    unsigned long total_bytes;    // Байт PCF8574 за всё время
+    unsigned long total_syscalls; // Системных вызовов за всё время
+
+    // Кэш CGRAM за всё время. Кириллица, которой нет в ПЗУ HD44780, и
+    // пользовательские знаки выводятся глифами из 8 мест CGRAM.
+    unsigned long cgram_hits;      // Глиф уже был в CGRAM
+    unsigned long cgram_misses;    // Глиф загружен в CGRAM (8 байт данных)
+    unsigned long cgram_fallbacks; // Все 8 мест заняты кадром: выведен знак ПЗУ
+} lcd1602_stats_t;
+
+// Сколько пользовательских знаков можно задать одному дисплею
+#define LCD1602_CUSTOM_GLYPHS 16
+
+// Операции, которые можно передать потоку записи
+#define LCD1602_OP_UPDATE 0
+#define LCD1602_OP_CLEAR  1
+#define LCD1602_OP_MARQUEE 2
+#define LCD1602_OP_WAIT_MODE 3 // Смена способа ожидания (lcd1602_submit_wait_mode)
+
+// Шаг бегущей строки по умолчанию, мс
+#define LCD1602_MARQUEE_DEFAULT_MS 300
+
+// Способ ожидания готовности HD44780 после команды
+#define LCD1602_WAIT_DELAY 0 // Паузы, отмеренные байтами на шине
+#define LCD1602_WAIT_BUSY  1 // Опрос флага занятости (BF) через PCF8574
+
+// Гистограмма задержек после команд: классы команд и логарифмические
+// корзины (0 — 0 мкс, b — от 2^(b-1) до 2^b - 1 мкс)
+#define LCD1602_LAT_DATA 0    // Запись символа
+#define LCD1602_LAT_CMD  1    // Короткая команда (курсор, режимы)
+#define LCD1602_LAT_LONG 2    // Очистка и возврат курсора
+#define LCD1602_LAT_CLASSES 3
+#define LCD1602_HIST_BUCKETS 16
+
+typedef struct {
+    unsigned long count[LCD1602_LAT_CLASSES][LCD1602_HIST_BUCKETS];
+} lcd1602_latency_t;
+
+// Транспорт шины: передаёт nmsgs сообщений I2C одной транзакцией и
+// возвращает 0 или -1. Драйвер вызывает его под своей блокировкой шины.
+// hz — частота шины, по которой отмеряются паузы (0 — 100 кГц).
+typedef struct {
+    int (*transfer)(void *ctx, struct i2c_msg *msgs, int nmsgs);
+    void *ctx;
+    unsigned long hz;
+} lcd1602_transport_t;
+
+// Вызывается из потока записи после передачи кадра.
+// status: 0 — успешно, -1 — ошибка I2C; для LCD1602_OP_WAIT_MODE -1 также
+// значит, что запрошенный режим не включился.
+typedef void (*lcd1602_done_cb)(lcd1602_t *lcd, int op, int status,
+                                const lcd1602_stats_t *stats, void *user_data);
+
+// Открывает дисплей с адресом addr на шине i2c_dev и инициализирует его.
+// Повторное открытие той же шины использует уже открытый дескриптор.
+// Возвращает NULL при ошибке.
+lcd1602_t *lcd1602_open(const char *i2c_dev, uint8_t addr);
+// То же поверх своего транспорта (например, эмулятора lcd1602_emu.h).
+// Дисплеи с одинаковым tr->ctx считаются одной шиной.
+lcd1602_t *lcd1602_open_transport(const lcd1602_transport_t *tr, uint8_t addr);
+void lcd1602_close(lcd1602_t *lcd);
+uint8_t lcd1602_addr(const lcd1602_t *lcd);
+
+// Функции вывода принимают текст в UTF-8 (кириллица выводится через ПЗУ
+// и CGRAM) и возвращают 0 при успехе и -1 при ошибке I2C
+int lcd1602_clear(lcd1602_t *lcd);
+int lcd1602_home(lcd1602_t *lcd);
+int lcd1602_write(lcd1602_t *lcd, const char *line1, const char *line2);
+// Обновляет экран по теневому буферу: передаются только изменившиеся
+// участки строк, без очистки дисплея. Если ничего не изменилось,
+// на шину не уходит ни одного байта.
+int lcd1602_update(lcd1602_t *lcd, const char *line1, const char *line2);
+// Обновляет n дисплеев одной шины одной транзакцией I2C_RDWR:
+// изменения всех дисплеев уходят в одном окне шины.
+int lcd1602_update_many(lcd1602_t *const *lcds, const char *const *line1,
+                        const char *const *line2, int n);
+void lcd1602_get_stats(lcd1602_t *lcd, lcd1602_stats_t *stats);
+
+// Задаёт знак для символа Unicode cp: 8 строк по 5 точек (старший из 5 бит
+// слева). Знак загружается в CGRAM при первом выводе. Возвращает -1, если
+// таблица пользовательских знаков заполнена.
+int lcd1602_define_glyph(lcd1602_t *lcd, uint32_t cp, const uint8_t rows[8]);
+
+// Включает опрос флага занятости. Если модуль не поддерживает чтение,
+// драйвер остаётся на паузах из даташита. Включение отправляет home:
+// бегущая строка останавливается. Возвращает фактический режим.
+int lcd1602_set_wait_mode(lcd1602_t *lcd, int mode);
+void lcd1602_get_latency(lcd1602_t *lcd, lcd1602_latency_t *lat);
+void lcd1602_reset_latency(lcd1602_t *lcd);
+void lcd1602_print_latency(lcd1602_t *lcd, FILE *out);
+
+// Асинхронный режим: поток записи шины принимает кадры дисплея, а
+// lcd1602_submit*() только кладут кадр в почтовый ящик и сразу
+// возвращаются. Непереданный кадр заменяется более новым. Кадры всех
+// дисплеев шины, ожидающие передачи, уходят одной транзакцией.
+// Отправлять кадры должен один поток (обычно GUI).
+int lcd1602_async_start(lcd1602_t *lcd, lcd1602_done_cb cb, void *user_data);
+int lcd1602_submit(lcd1602_t *lcd, const char *line1, const char *line2);
+// То же для n дисплеев сразу: поток записи будится один раз
+int lcd1602_submit_many(lcd1602_t *const *lcds, const char *const *line1,
+                        const char *const *line2, int n);
+int lcd1602_submit_clear(lcd1602_t *lcd);
+// Бегущая строка: до 40 символов на строку загружаются в DDRAM один раз,
+// затем поток записи каждые step_ms сдвигает экран командой 0x18 (обе
+// строки сдвигаются вместе). Обратный вызов приходит только после загрузки
+// текста. Бегущую строку останавливает любой следующий кадр или очистка.
+int lcd1602_submit_marquee(lcd1602_t *lcd, const char *line1, const char *line2,
+                           unsigned step_ms);
+// lcd1602_set_wait_mode в потоке записи: проба BF не блокирует вызывающего,
+// результат приходит в обратный вызов с LCD1602_OP_WAIT_MODE
+int lcd1602_submit_wait_mode(lcd1602_t *lcd, int mode);
+// Меняет шаг бегущей строки на лету
+void lcd1602_set_marquee_rate(lcd1602_t *lcd, unsigned step_ms);
+void lcd1602_async_stop(lcd1602_t *lcd);
 
 #endif // LCD1602_H
@@ -0,0 +1,132 @@
+#include "lcd1602_charmap.h"
+#include <stddef.h>
+
+#define R(c) ((unsigned)(uint8_t)(c))    // Знак из ПЗУ
+#define G(i) (LCD_CHARMAP_GLYPH | (i))   // Глиф в CGRAM
+
+// Встроенные глифы: 8 строк по 5 точек, старший из 5 бит — левая точка
+enum {
+    GL_BE, GL_GHE, GL_DE, GL_ZHE, GL_I, GL_SHORT_I, GL_EL, GL_PE, GL_EF, GL_TSE,
+    GL_CHE, GL_SHA, GL_SHCHA, GL_HARD, GL_YERU, GL_SOFT, GL_E, GL_YU, GL_YA
+};
+
+static const struct {
+    uint8_t rows[8];
+    uint8_t fallback;
+} glyphs[LCD_CHARMAP_GLYPHS] = {
+    [GL_BE]      = {{0x1F, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x1E, 0x00}, '6'},
+    [GL_GHE]     = {{0x1F, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00}, 'r'},
+    [GL_DE]      = {{0x0E, 0x0A, 0x0A, 0x0A, 0x0A, 0x1F, 0x11, 0x00}, 'D'},
+    [GL_ZHE]     = {{0x15, 0x15, 0x15, 0x0E, 0x15, 0x15, 0x15, 0x00}, '*'},
+    [GL_I]       = {{0x11, 0x11, 0x13, 0x15, 0x19, 0x11, 0x11, 0x00}, 'N'},
+    [GL_SHORT_I] = {{0x0A, 0x04, 0x11, 0x13, 0x15, 0x19, 0x11, 0x00}, 'N'},
+    [GL_EL]      = {{0x0F, 0x05, 0x05, 0x05, 0x05, 0x15, 0x09, 0x00}, 'n'},
+    [GL_PE]      = {{0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x00}, 'n'},
+    [GL_EF]      = {{0x04, 0x0E, 0x15, 0x15, 0x15, 0x0E, 0x04, 0x00}, 'f'},
+    [GL_TSE]     = {{0x12, 0x12, 0x12, 0x12, 0x12, 0x12, 0x1F, 0x01}, 'U'},
+    [GL_CHE]     = {{0x11, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x01, 0x00}, '4'},
+    [GL_SHA]     = {{0x15, 0x15, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x00}, 'W'},
+    [GL_SHCHA]   = {{0x15, 0x15, 0x15, 0x15, 0x15, 0x15, 0x1F, 0x01}, 'W'},
+    [GL_HARD]    = {{0x18, 0x08, 0x08, 0x0E, 0x09, 0x09, 0x0E, 0x00}, 'b'},
+    [GL_YERU]    = {{0x11, 0x11, 0x11, 0x19, 0x15, 0x15, 0x19, 0x00}, 'b'},
+    [GL_SOFT]    = {{0x10, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x1E, 0x00}, 'b'},
+    [GL_E]       = {{0x0E, 0x11, 0x01, 0x07, 0x01, 0x11, 0x0E, 0x00}, '3'},
+    [GL_YU]      = {{0x12, 0x15, 0x15, 0x1D, 0x15, 0x15, 0x12, 0x00}, 'O'},
+    [GL_YA]      = {{0x0F, 0x11, 0x11, 0x0F, 0x05, 0x09, 0x11, 0x00}, 'R'},
+};
+
+// Кириллица U+0410..U+044F. Буквы, похожие на латинские, берутся из ПЗУ,
+// остальные — глифы CGRAM. Строчные без латинского двойника используют
+// глиф заглавной буквы, чтобы не занимать лишние места в CGRAM.
+static const uint16_t cyrillic[64] = {
+    // А       Б            В       Г           Д          Е       Ж           З
+    R('A'), G(GL_BE),    R('B'), G(GL_GHE),  G(GL_DE),  R('E'), G(GL_ZHE),  R('3'),
+    // И       Й            К       Л           М          Н       О           П
+    G(GL_I), G(GL_SHORT_I), R('K'), G(GL_EL), R('M'),   R('H'), R('O'),     G(GL_PE),
+    // Р       С            Т       У           Ф          Х       Ц           Ч
+    R('P'), R('C'),      R('T'), R('Y'),     G(GL_EF),  R('X'), G(GL_TSE),  G(GL_CHE),
+    // Ш         Щ             Ъ           Ы            Ь            Э          Ю          Я
+    G(GL_SHA), G(GL_SHCHA), G(GL_HARD), G(GL_YERU), G(GL_SOFT), G(GL_E), G(GL_YU), G(GL_YA),
+    // а       б            в       г           д          е       ж           з
+    R('a'), G(GL_BE),    R('B'), G(GL_GHE),  G(GL_DE),  R('e'), G(GL_ZHE),  R('3'),
+    // и       й            к       л           м          н       о           п
+    G(GL_I), G(GL_SHORT_I), R('k'), G(GL_EL), R('M'),   R('H'), R('o'),     G(GL_PE),
+    // р       с            т       у           ф          х       ц           ч
+    R('p'), R('c'),      R('T'), R('y'),     G(GL_EF),  R('x'), G(GL_TSE),  G(GL_CHE),
+    // ш         щ             ъ           ы            ь            э          ю          я
+    G(GL_SHA), G(GL_SHCHA), G(GL_HARD), G(GL_YERU), G(GL_SOFT), G(GL_E), G(GL_YU), G(GL_YA),
+};
+
+// Прочие символы, которые есть в ПЗУ A00
+static const struct {
+    uint32_t cp;
+    uint8_t code;
+} symbols[] = {
+    {0x00B0, 0xDF}, // °
+    {0x00B5, 0xE4}, // µ
+    {0x00B7, 0xA5}, // ·
+    {0x00F7, 0xFD}, // ÷
+    {0x0401, 'E'},  // Ё
+    {0x0451, 'e'},  // ё
+    {0x03A3, 0xF6}, // Σ
+    {0x03A9, 0xF4}, // Ω
+    {0x03C0, 0xF7}, // π
+    {0x2190, 0x7F}, // ←
+    {0x2192, 0x7E}, // →
+    {0x221A, 0xE8}, // √
+    {0x2588, 0xFF}, // █
+};
+
+uint32_t lcd_charmap_next(const char **s) {
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t cp;
+    int len;
+
+    if (p[0] < 0x80) {
+        *s += 1;
+        return p[0];
+    } else if ((p[0] & 0xE0) == 0xC0) {
+        cp = p[0] & 0x1F;
+        len = 2;
+    } else if ((p[0] & 0xF0) == 0xE0) {
+        cp = p[0] & 0x0F;
+        len = 3;
+    } else if ((p[0] & 0xF8) == 0xF0) {
+        cp = p[0] & 0x07;
+        len = 4;
+    } else {
+        *s += 1;
+        return '?';
+    }
+
+    for (int i = 1; i < len; i++) {
+        // Обрыв последовательности (в том числе конец строки)
+        if ((p[i] & 0xC0) != 0x80) {
+            *s += 1;
+            return '?';
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *s += len;
+    return cp;
+}
+
+unsigned lcd_charmap_lookup(uint32_t cp) {
+    if (cp >= 0x20 && cp < 0x80)
+        return cp;
+    if (cp >= 0x0410 && cp <= 0x044F)
+        return cyrillic[cp - 0x0410];
+    for (size_t i = 0; i < sizeof(symbols) / sizeof(symbols[0]); i++) {
+        if (symbols[i].cp == cp)
+            return symbols[i].code;
+    }
+    return '?';
+}
+
+const uint8_t *lcd_charmap_bitmap(unsigned glyph) {
+    return glyphs[glyph].rows;
+}
+
+uint8_t lcd_charmap_fallback(unsigned glyph) {
+    return glyphs[glyph].fallback;
+}
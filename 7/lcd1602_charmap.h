@@ -0,0 +1,25 @@
+#ifndef LCD1602_CHARMAP_H
+#define LCD1602_CHARMAP_H
+
+#include <stdint.h>
+
+// Таблица знаков HD44780 (ПЗУ A00) для текста в UTF-8.
+// Символ отображается либо кодом ПЗУ, либо глифом, который драйвер
+// загружает в CGRAM. Результат поиска — код ПЗУ (0..255) или
+// LCD_CHARMAP_GLYPH | номер глифа.
+#define LCD_CHARMAP_GLYPH 0x100
+#define LCD_CHARMAP_GLYPHS 19 // Встроенных глифов (кириллица, которой нет в ПЗУ)
+
+// Декодирует один символ UTF-8 и сдвигает *s за него.
+// Неверная последовательность возвращается как '?' (сдвиг на 1 байт).
+uint32_t lcd_charmap_next(const char **s);
+
+// Код знакогенератора для символа Unicode. Неизвестные символы — '?'.
+unsigned lcd_charmap_lookup(uint32_t cp);
+
+// Битовая карта встроенного глифа (8 строк по 5 бит) и код ПЗУ,
+// которым глиф заменяется, если в CGRAM не осталось свободных мест
+const uint8_t *lcd_charmap_bitmap(unsigned glyph);
+uint8_t lcd_charmap_fallback(unsigned glyph);
+
+#endif // LCD1602_CHARMAP_H
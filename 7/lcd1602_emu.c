@@ -0,0 +1,244 @@
+#include "lcd1602_emu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Выводы PCF8574 так же, как в драйвере
+#define EMU_RS 0x01
+#define EMU_RW 0x02
+#define EMU_E  0x04
+
+#define EMU_MAX_DISPLAYS 16
+#define EMU_DDRAM_COLS 40
+
+// Один дисплей: состояние PCF8574 и контроллера HD44780
+struct emu_lcd {
+    uint8_t addr;
+    uint8_t port;      // Последний байт, записанный в PCF8574
+    int eight_bit;     // После включения контроллер в 8-битном режиме
+    int have_high;     // Принят старший полубайт, ждём младший
+    uint8_t high;
+    uint8_t ddram[0x80];
+    uint8_t cgram[64];
+    int ac;            // Счётчик адреса
+    int cgram_mode;    // Счётчик адреса указывает в CGRAM
+    int inc;           // Направление счётчика (I/D)
+    int shift;         // Сдвиг экрана влево, 0..39
+};
+
+struct lcd1602_emu {
+    pthread_mutex_t lock;
+    unsigned long hz;
+    struct emu_lcd lcds[EMU_MAX_DISPLAYS];
+    int nlcds;
+    lcd1602_emu_stats_t stats;
+};
+
+static struct emu_lcd *emu_find(lcd1602_emu_t *emu, uint8_t addr) {
+    for (int i = 0; i < emu->nlcds; i++) {
+        if (emu->lcds[i].addr == addr)
+            return &emu->lcds[i];
+    }
+    return NULL;
+}
+
+static void emu_advance(struct emu_lcd *d) {
+    if (d->cgram_mode) {
+        d->ac = (d->ac + (d->inc ? 1 : -1)) & 0x3F;
+    } else if (d->inc) {
+        // Строки DDRAM: 0x00-0x27 и 0x40-0x67, после конца строки — следующая
+        d->ac++;
+        if (d->ac == 0x28)
+            d->ac = 0x40;
+        else if (d->ac == 0x68)
+            d->ac = 0x00;
+    } else {
+        if (d->ac == 0x00)
+            d->ac = 0x67;
+        else if (d->ac == 0x40)
+            d->ac = 0x27;
+        else
+            d->ac--;
+    }
+}
+
+static void emu_command(lcd1602_emu_t *emu, struct emu_lcd *d, uint8_t v) {
+    emu->stats.commands++;
+    if (v & 0x80) {
+        d->ac = v & 0x7F;
+        d->cgram_mode = 0;
+    } else if (v & 0x40) {
+        d->ac = v & 0x3F;
+        d->cgram_mode = 1;
+    } else if (v & 0x20) {
+        d->eight_bit = (v & 0x10) != 0;
+        d->have_high = 0;
+    } else if (v & 0x10) {
+        if (v & 0x08) {
+            // Сдвиг экрана: R/L=0 — влево
+            d->shift = (d->shift + ((v & 0x04) ? EMU_DDRAM_COLS - 1 : 1)) % EMU_DDRAM_COLS;
+        } else {
+            int save = d->inc;
+            d->inc = (v & 0x04) != 0;
+            emu_advance(d);
+            d->inc = save;
+        }
+    } else if (v & 0x08) {
+        // Включение экрана и курсора: на содержимое не влияет
+    } else if (v & 0x04) {
+        d->inc = (v & 0x02) != 0;
+    } else if (v & 0x02) {
+        d->ac = 0;
+        d->cgram_mode = 0;
+        d->shift = 0;
+    } else if (v & 0x01) {
+        memset(d->ddram, ' ', sizeof(d->ddram));
+        d->ac = 0;
+        d->cgram_mode = 0;
+        d->shift = 0;
+        d->inc = 1;
+    }
+}
+
+static void emu_data(lcd1602_emu_t *emu, struct emu_lcd *d, uint8_t v) {
+    emu->stats.data++;
+    if (d->cgram_mode)
+        d->cgram[d->ac & 0x3F] = v & 0x1F;
+    else
+        d->ddram[d->ac & 0x7F] = v;
+    emu_advance(d);
+}
+
+// Байт на выводах PCF8574. HD44780 защёлкивает D4-D7 и RS по спаду E;
+// импульсы E с RW=1 — чтение, они состояние записи не меняют.
+static void emu_port_write(lcd1602_emu_t *emu, struct emu_lcd *d, uint8_t b) {
+    uint8_t prev = d->port;
+
+    d->port = b;
+    if (!(prev & EMU_E) || (b & EMU_E) || (prev & EMU_RW))
+        return;
+
+    uint8_t nibble = prev >> 4;
+    if (d->eight_bit) {
+        // В 8-битном режиме D0-D3 не подключены и читаются как 0
+        if (prev & EMU_RS)
+            emu_data(emu, d, nibble << 4);
+        else
+            emu_command(emu, d, nibble << 4);
+    } else if (!d->have_high) {
+        d->high = nibble;
+        d->have_high = 1;
+    } else {
+        uint8_t v = (d->high << 4) | nibble;
+        d->have_high = 0;
+        if (prev & EMU_RS)
+            emu_data(emu, d, v);
+        else
+            emu_command(emu, d, v);
+    }
+}
+
+// Транспорт: всё, что драйвер отправил бы одним ioctl(I2C_RDWR).
+// Флаг занятости всегда сброшен: время выполнения команд не эмулируется.
+static int emu_transfer(void *ctx, struct i2c_msg *msgs, int nmsgs) {
+    lcd1602_emu_t *emu = ctx;
+    int status = 0;
+
+    pthread_mutex_lock(&emu->lock);
+    emu->stats.transactions++;
+    for (int i = 0; i < nmsgs; i++) {
+        struct emu_lcd *d = emu_find(emu, msgs[i].addr);
+        if (!d) {
+            // NACK: остаток транзакции не передаётся
+            status = -1;
+            break;
+        }
+        emu->stats.messages++;
+        if (msgs[i].flags & I2C_M_RD) {
+            for (int j = 0; j < msgs[i].len; j++)
+                msgs[i].buf[j] = (d->port & 0x0F) | ((d->ac >> 4) & 0x07) << 4;
+            emu->stats.reads += msgs[i].len;
+        } else {
+            for (int j = 0; j < msgs[i].len; j++)
+                emu_port_write(emu, d, msgs[i].buf[j]);
+            emu->stats.bytes += msgs[i].len;
+        }
+    }
+    pthread_mutex_unlock(&emu->lock);
+    return status;
+}
+
+lcd1602_emu_t *lcd1602_emu_new(unsigned long hz) {
+    lcd1602_emu_t *emu = calloc(1, sizeof(*emu));
+    if (!emu)
+        return NULL;
+    pthread_mutex_init(&emu->lock, NULL);
+    emu->hz = hz;
+    return emu;
+}
+
+void lcd1602_emu_free(lcd1602_emu_t *emu) {
+    if (!emu)
+        return;
+    pthread_mutex_destroy(&emu->lock);
+    free(emu);
+}
+
+int lcd1602_emu_attach(lcd1602_emu_t *emu, uint8_t addr) {
+    int status = 0;
+
+    pthread_mutex_lock(&emu->lock);
+    if (emu_find(emu, addr) || emu->nlcds == EMU_MAX_DISPLAYS) {
+        status = -1;
+    } else {
+        struct emu_lcd *d = &emu->lcds[emu->nlcds++];
+        memset(d, 0, sizeof(*d));
+        d->addr = addr;
+        d->eight_bit = 1;
+        d->inc = 1;
+        memset(d->ddram, ' ', sizeof(d->ddram));
+    }
+    pthread_mutex_unlock(&emu->lock);
+    return status;
+}
+
+void lcd1602_emu_transport(lcd1602_emu_t *emu, lcd1602_transport_t *tr) {
+    tr->transfer = emu_transfer;
+    tr->ctx = emu;
+    tr->hz = emu->hz;
+}
+
+int lcd1602_emu_screen(lcd1602_emu_t *emu, uint8_t addr, char screen[2][17]) {
+    pthread_mutex_lock(&emu->lock);
+    struct emu_lcd *d = emu_find(emu, addr);
+    if (d) {
+        for (int row = 0; row < 2; row++) {
+            for (int col = 0; col < 16; col++)
+                screen[row][col] = d->ddram[row * 0x40 + (col + d->shift) % EMU_DDRAM_COLS];
+            screen[row][16] = '\0';
+        }
+    }
+    pthread_mutex_unlock(&emu->lock);
+    return d ? 0 : -1;
+}
+
+int lcd1602_emu_cgram(lcd1602_emu_t *emu, uint8_t addr, uint8_t cgram[64]) {
+    pthread_mutex_lock(&emu->lock);
+    struct emu_lcd *d = emu_find(emu, addr);
+    if (d)
+        memcpy(cgram, d->cgram, sizeof(d->cgram));
+    pthread_mutex_unlock(&emu->lock);
+    return d ? 0 : -1;
+}
+
+void lcd1602_emu_get_stats(lcd1602_emu_t *emu, lcd1602_emu_stats_t *st) {
+    pthread_mutex_lock(&emu->lock);
+    *st = emu->stats;
+    pthread_mutex_unlock(&emu->lock);
+}
+
+void lcd1602_emu_reset_stats(lcd1602_emu_t *emu) {
+    pthread_mutex_lock(&emu->lock);
+    memset(&emu->stats, 0, sizeof(emu->stats));
+    pthread_mutex_unlock(&emu->lock);
+}
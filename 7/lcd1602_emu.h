@@ -0,0 +1,39 @@
+#ifndef LCD1602_EMU_H
+#define LCD1602_EMU_H
+
+#include <stdint.h>
+#include "lcd1602.h"
+
+// Эмулятор шины I2C с дисплеями HD44780 за PCF8574. Разбирает поток
+// байтов порта (полубайты по спаду E, RS, RW), ведёт DDRAM, CGRAM,
+// счётчик адреса и сдвиг экрана и считает трафик шины. Подключается к
+// драйверу через lcd1602_open_transport() и позволяет гонять драйвер
+// без железа.
+typedef struct lcd1602_emu lcd1602_emu_t;
+
+typedef struct {
+    unsigned long transactions; // Вызовов транспорта (системных вызовов на железе)
+    unsigned long messages;     // Сообщений I2C
+    unsigned long bytes;        // Байт, записанных в PCF8574
+    unsigned long reads;        // Байт, прочитанных из PCF8574
+    unsigned long commands;     // Команд HD44780
+    unsigned long data;         // Записей данных в DDRAM/CGRAM
+} lcd1602_emu_stats_t;
+
+// hz — частота, которую эмулятор сообщает драйверу (0 — 100 кГц)
+lcd1602_emu_t *lcd1602_emu_new(unsigned long hz);
+void lcd1602_emu_free(lcd1602_emu_t *emu);
+// Подключает к шине дисплей с адресом addr. Сообщения на адреса без
+// дисплея завершаются ошибкой, как NACK на настоящей шине.
+int lcd1602_emu_attach(lcd1602_emu_t *emu, uint8_t addr);
+void lcd1602_emu_transport(lcd1602_emu_t *emu, lcd1602_transport_t *tr);
+
+// Видимая часть экрана с учётом сдвига: 2 строки по 16 кодов знакогенератора
+int lcd1602_emu_screen(lcd1602_emu_t *emu, uint8_t addr, char screen[2][17]);
+// Содержимое CGRAM: 8 знаков по 8 строк
+int lcd1602_emu_cgram(lcd1602_emu_t *emu, uint8_t addr, uint8_t cgram[64]);
+
+void lcd1602_emu_get_stats(lcd1602_emu_t *emu, lcd1602_emu_stats_t *st);
+void lcd1602_emu_reset_stats(lcd1602_emu_t *emu);
+
+#endif // LCD1602_EMU_H
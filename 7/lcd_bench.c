@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lcd1602.h"
+#include "lcd1602_emu.h"
+
+/**
+ * @file lcd_bench.c
+ * @brief Замер горячего пути драйвера LCD1602 без железа.
+ *
+ * Драйвер работает поверх эмулятора шины (lcd1602_emu.c), который
+ * разбирает поток байтов PCF8574 и считает трафик. Для каждого режима
+ * выводятся кадры в секунду (скорость самого драйвера), байты и системные
+ * вызовы на кадр и время, которое кадр занял бы на шине 100 кГц.
+ * После каждого режима экран эмулятора сверяется с ожидаемым текстом.
+ *
+ * Запуск: make bench или ./lcd_bench [кадров на режим]
+ */
+
+#define BENCH_ADDR 0x27
+#define BENCH_HZ 100000
+
+static lcd1602_emu_t *emu;
+static lcd1602_t *lcd;
+static unsigned long frames;
+static int failed;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Сверяет экран эмулятора с ожидаемыми строками (только ASCII)
+static void check_screen(const char *name, const char *line1, const char *line2) {
+    char screen[2][17];
+    char want[2][17];
+
+    snprintf(want[0], sizeof(want[0]), "%-16.16s", line1);
+    snprintf(want[1], sizeof(want[1]), "%-16.16s", line2);
+    lcd1602_emu_screen(emu, BENCH_ADDR, screen);
+    if (strcmp(screen[0], want[0]) != 0 || strcmp(screen[1], want[1]) != 0) {
+        fprintf(stderr, "%s: screen mismatch: \"%s\" / \"%s\", expected \"%s\" / \"%s\"\n",
+                name, screen[0], screen[1], want[0], want[1]);
+        failed = 1;
+    }
+}
+
+static void report(const char *name, double sec) {
+    lcd1602_emu_stats_t st;
+
+    lcd1602_emu_get_stats(emu, &st);
+    double bytes = (double)st.bytes / frames;
+    printf("%-10s %8lu %12.0f %12.1f %15.2f %14.0f\n", name, frames, frames / sec,
+           bytes, (double)st.transactions / frames, bytes * 9 * 1e6 / BENCH_HZ);
+}
+
+static void bench_write(void) {
+    static const char *text[2][2] = {
+        {"Full frame 0123", "ABCDEFGHIJKLMNOP"},
+        {"Full frame 4567", "abcdefghijklmnop"},
+    };
+    lcd1602_emu_reset_stats(emu);
+    double t0 = now_sec();
+    for (unsigned long i = 0; i < frames; i++)
+        lcd1602_write(lcd, text[i & 1][0], text[i & 1][1]);
+    report("write", now_sec() - t0);
+    check_screen("write", text[(frames - 1) & 1][0], text[(frames - 1) & 1][1]);
+}
+
+static void bench_update(void) {
+    char line2[32];
+
+    lcd1602_update(lcd, "Counter", "");
+    lcd1602_emu_reset_stats(emu);
+    double t0 = now_sec();
+    for (unsigned long i = 0; i < frames; i++) {
+        snprintf(line2, sizeof(line2), "Value: %9lu", i);
+        lcd1602_update(lcd, "Counter", line2);
+    }
+    report("update", now_sec() - t0);
+    check_screen("update", "Counter", line2);
+}
+
+static void bench_update_ru(void) {
+    char line2[64];
+
+    lcd1602_update(lcd, "Привет, мир!", "");
+    lcd1602_emu_reset_stats(emu);
+    double t0 = now_sec();
+    for (unsigned long i = 0; i < frames; i++) {
+        snprintf(line2, sizeof(line2), "Счётчик: %7lu", i);
+        lcd1602_update(lcd, "Привет, мир!", line2);
+    }
+    report("update-ru", now_sec() - t0);
+}
+
+static void bench_clear(void) {
+    lcd1602_emu_reset_stats(emu);
+    double t0 = now_sec();
+    for (unsigned long i = 0; i < frames; i++)
+        lcd1602_clear(lcd);
+    report("clear", now_sec() - t0);
+    check_screen("clear", "", "");
+}
+
+int main(int argc, char *argv[]) {
+    lcd1602_transport_t tr;
+
+    frames = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+    if (frames == 0) {
+        fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    emu = lcd1602_emu_new(BENCH_HZ);
+    if (!emu || lcd1602_emu_attach(emu, BENCH_ADDR) != 0)
+        return 1;
+    lcd1602_emu_transport(emu, &tr);
+    lcd = lcd1602_open_transport(&tr, BENCH_ADDR);
+    if (!lcd)
+        return 1;
+
+    printf("%-10s %8s %12s %12s %15s %14s\n", "mode", "frames", "frames/s",
+           "bytes/frame", "syscalls/frame", "bus us/frame");
+    bench_write();
+    bench_update();
+    bench_update_ru();
+    bench_clear();
+
+    lcd1602_close(lcd);
+    lcd1602_emu_free(emu);
+    return failed;
+}
@@ -1,5 +1,6 @@
 #include <gtk/gtk.h> // Включаем библиотеку GTK+ 3 для создания графического интерфейса
 #include "lcd1602.h" // Включаем наш заголовочный файл драйвера LCD1602
+#include <stdlib.h>
 
 /**
  * @file lcd_gui.c
@@ -18,12 +19,104 @@ GtkWidget *entry_line1;
 GtkWidget *entry_line2;
 // Глобальный указатель на метку для отображения статуса
 GtkWidget *status_label;
+// Переключатель бегущей строки и поле шага прокрутки (мс)
+GtkWidget *marquee_check;
+GtkWidget *marquee_spin;
+// Переключатель ожидания по флагу занятости
+GtkWidget *busy_check;
+// Какой-то дисплей не поддерживает чтение BF: ответы остальных дисплеев
+// не затирают это сообщение, пока переключатель не включат снова
+static gboolean busy_rejected;
+
+// Дисплеи на шине I2C. Адреса задаются в командной строке
+// (например, ./lcd_gui 0x27 0x3F), по умолчанию один дисплей 0x27.
+#define MAX_DISPLAYS 8
+static lcd1602_t *displays[MAX_DISPLAYS];
+static int num_displays;
+
+// Результат передачи кадра, который поток записи LCD передаёт в GUI-поток
+struct lcd_status {
+    uint8_t addr;           // Адрес дисплея на шине
+    int op;                 // LCD1602_OP_UPDATE, LCD1602_OP_CLEAR, ...
+    int status;             // 0 — успешно, -1 — ошибка I2C
+    lcd1602_stats_t stats;  // Статистика переданного кадра
+};
+
+/**
+ * @brief Обновляет метку статуса по результату передачи кадра.
+ *
+ * Вызывается в главном цикле GTK через g_idle_add, потому что виджеты GTK
+ * можно трогать только из GUI-потока.
+ *
+ * @param data Указатель на struct lcd_status (освобождается здесь).
+ * @return G_SOURCE_REMOVE, чтобы функция выполнилась один раз.
+ */
+static gboolean update_status_label(gpointer data) {
+    struct lcd_status *st = data;
+    char status[192];
+
+    if (st->op == LCD1602_OP_WAIT_MODE) {
+        gboolean busy = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(busy_check));
+        if (st->status != 0 && busy) {
+            // Режим включается только если его поддерживают все дисплеи:
+            // сброс переключателя вернёт все дисплеи на паузы
+            busy_rejected = TRUE;
+            gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(busy_check), FALSE);
+            snprintf(status, sizeof(status), "LCD 0x%02X: чтение флага занятости не поддерживается.",
+                     st->addr);
+        } else if (busy_rejected) {
+            g_free(st);
+            return G_SOURCE_REMOVE;
+        } else {
+            snprintf(status, sizeof(status), "%s", busy ? "Ожидание по флагу занятости включено." :
+                                                   "Ожидание по фиксированным паузам.");
+        }
+    } else if (st->status != 0) {
+        snprintf(status, sizeof(status), "Ошибка передачи на LCD 0x%02X!", st->addr);
+    } else if (st->op == LCD1602_OP_CLEAR) {
+        snprintf(status, sizeof(status), "Экран LCD 0x%02X очищен.", st->addr);
+    } else {
+        // Весь кадр уходит одной транзакцией I2C, поэтому показываем
+        // его размер, число системных вызовов и время передачи
+        // Кириллица выводится глифами CGRAM: промах — загрузка глифа по шине
+        snprintf(status, sizeof(status),
+                 "Текст отправлен на LCD 0x%02X: %lu байт, %lu вызов(а), %lu мкс, CGRAM %lu/%lu.",
+                 st->addr, st->stats.bytes, st->stats.syscalls, st->stats.us,
+                 st->stats.cgram_hits, st->stats.cgram_misses);
+    }
+    gtk_label_set_text(GTK_LABEL(status_label), status);
+
+    g_free(st);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Обратный вызов драйвера LCD после передачи кадра.
+ *
+ * Выполняется в потоке записи драйвера, поэтому только копирует результат
+ * и передаёт его в главный цикл GTK.
+ */
+static void on_lcd_done(lcd1602_t *lcd, int op, int status, const lcd1602_stats_t *stats,
+                        void *user_data) {
+    struct lcd_status *st = g_new(struct lcd_status, 1);
+    st->addr = lcd1602_addr(lcd);
+    st->op = op;
+    st->status = status;
+    st->stats = *stats;
+    g_idle_add(update_status_label, st);
+}
 
 /**
  * @brief Обработчик события нажатия кнопки "Отправить на LCD".
  *
  * Эта функция вызывается, когда пользователь нажимает кнопку "Отправить на LCD".
- * Она считывает текст из полей ввода, очищает дисплей и записывает на него новые строки.
+ * Она считывает текст из полей ввода и передаёт его потоку записи драйвера. Драйвер
+ * сравнивает новый текст с теневой копией экрана и передаёт только изменившиеся символы,
+ * без очистки дисплея, поэтому частое обновление не вызывает мерцания.
+ * Обработчик не ждёт шину I2C: статус придёт позже через on_lcd_done.
+ * Текст уходит на все открытые дисплеи; кадры дисплеев одной шины поток
+ * записи передаёт одной транзакцией. Если включена бегущая строка, в каждой
+ * строке может быть до 40 символов.
  *
  * @param button Указатель на виджет кнопки, которая вызвала событие (не используется напрямую).
  * @param user_data Пользовательские данные, переданные при подключении сигнала (не используются).
@@ -32,12 +125,44 @@ void on_send_clicked(GtkButton *button, gpointer user_data) {
     const char *text1 = gtk_entry_get_text(GTK_ENTRY(entry_line1));
     const char *text2 = gtk_entry_get_text(GTK_ENTRY(entry_line2));
 
-    // Очищаем дисплей LCD1602
-    lcd1602_clear();
-    // Записываем полученные строки на дисплей
-    lcd1602_write(text1, text2);
-    // Обновляем метку статуса
-    gtk_label_set_text(GTK_LABEL(status_label), "Текст успешно отправлен на LCD.");
+    const char *line1[MAX_DISPLAYS], *line2[MAX_DISPLAYS];
+
+    for (int i = 0; i < num_displays; i++) {
+        line1[i] = text1;
+        line2[i] = text2;
+    }
+
+    int status = num_displays ? 0 : -1;
+
+    if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(marquee_check))) {
+        // Бегущая строка: текст загружается в DDRAM один раз, дальше
+        // экран сдвигает поток записи драйвера по своему таймеру
+        unsigned step_ms = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(marquee_spin));
+        for (int i = 0; i < num_displays; i++) {
+            if (lcd1602_submit_marquee(displays[i], text1, text2, step_ms) != 0)
+                status = -1;
+        }
+    } else if (status == 0) {
+        // Передаём кадры потоку записи; вызов не блокируется
+        status = lcd1602_submit_many(displays, line1, line2, num_displays);
+    }
+    if (status != 0)
+        gtk_label_set_text(GTK_LABEL(status_label), "Поток записи LCD не запущен!");
+}
+
+/**
+ * @brief Обработчик изменения шага бегущей строки.
+ *
+ * Новый шаг применяется сразу, без повторной загрузки текста.
+ *
+ * @param spin Поле ввода шага, вызвавшее событие.
+ * @param user_data Пользовательские данные (не используются).
+ */
+void on_marquee_rate_changed(GtkSpinButton *spin, gpointer user_data) {
+    unsigned step_ms = gtk_spin_button_get_value_as_int(spin);
+
+    for (int i = 0; i < num_displays; i++)
+        lcd1602_set_marquee_rate(displays[i], step_ms);
 }
 
 /**
@@ -50,8 +175,44 @@ void on_send_clicked(GtkButton *button, gpointer user_data) {
  * @param user_data Пользовательские данные.
  */
 void on_clear_clicked(GtkButton *button, gpointer user_data) {
-    lcd1602_clear();
-    gtk_label_set_text(GTK_LABEL(status_label), "Экран LCD очищен.");
+    int status = num_displays ? 0 : -1;
+
+    for (int i = 0; i < num_displays; i++) {
+        if (lcd1602_submit_clear(displays[i]) != 0)
+            status = -1;
+    }
+    if (status != 0)
+        gtk_label_set_text(GTK_LABEL(status_label), "Поток записи LCD не запущен!");
+}
+
+/**
+ * @brief Обработчик переключателя "Ждать по флагу занятости".
+ *
+ * Включает опрос флага занятости HD44780 вместо фиксированных пауз. Проба чтения
+ * занимает шину, поэтому режим передаётся потоку записи, как и кадры текста;
+ * результат приходит через on_lcd_done. Если какой-то дисплей не поддерживает
+ * чтение, переключатель сбрасывается, и все дисплеи возвращаются на паузы.
+ *
+ * @param button Переключатель, вызвавший событие.
+ * @param user_data Пользовательские данные (не используются).
+ */
+void on_busy_toggled(GtkToggleButton *button, gpointer user_data) {
+    int want = gtk_toggle_button_get_active(button) ? LCD1602_WAIT_BUSY : LCD1602_WAIT_DELAY;
+    int status = num_displays ? 0 : -1;
+
+    if (want == LCD1602_WAIT_BUSY)
+        busy_rejected = FALSE;
+    // Гистограмма задержек копится заново для нового режима
+    for (int i = 0; i < num_displays; i++) {
+        lcd1602_reset_latency(displays[i]);
+        if (lcd1602_submit_wait_mode(displays[i], want) != 0)
+            status = -1;
+    }
+    if (status != 0) {
+        gtk_label_set_text(GTK_LABEL(status_label), "Поток записи LCD не запущен!");
+        if (want == LCD1602_WAIT_BUSY)
+            gtk_toggle_button_set_active(button, FALSE);
+    }
 }
 
 /**
@@ -61,8 +222,8 @@ void on_clear_clicked(GtkButton *button, gpointer user_data) {
  * запускает главный цикл GTK и очищает ресурсы при завершении.
  *
  * @param argc Количество аргументов командной строки.
- * @param argv Массив аргументов командной строки.
- * @return 0 при успешном завершении, 1 при ошибке инициализации LCD.
+ * @param argv Массив аргументов командной строки: адреса дисплеев (например, 0x27 0x3F).
+ * @return 0 при успешном завершении, 1 при неверных аргументах.
  */
 int main(int argc, char *argv[]) {
     // Инициализация GTK. Должна быть вызвана первой в любом GTK-приложении.
@@ -108,18 +269,62 @@ int main(int argc, char *argv[]) {
     g_signal_connect(clear_button, "clicked", G_CALLBACK(on_clear_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(button_box), clear_button, TRUE, TRUE, 0); // Добавляем в контейнер кнопок
 
+    // --- Переключатель режима ожидания контроллера ---
+    busy_check = gtk_check_button_new_with_label("Ждать по флагу занятости (BF)");
+    g_signal_connect(busy_check, "toggled", G_CALLBACK(on_busy_toggled), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), busy_check, FALSE, FALSE, 0);
+
+    // --- Бегущая строка и её шаг ---
+    GtkWidget *marquee_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_box_pack_start(GTK_BOX(vbox), marquee_box, FALSE, FALSE, 0);
+    marquee_check = gtk_check_button_new_with_label("Бегущая строка (до 40 символов), шаг, мс:");
+    gtk_box_pack_start(GTK_BOX(marquee_box), marquee_check, FALSE, FALSE, 0);
+    marquee_spin = gtk_spin_button_new_with_range(50, 2000, 50);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(marquee_spin), LCD1602_MARQUEE_DEFAULT_MS);
+    g_signal_connect(marquee_spin, "value-changed", G_CALLBACK(on_marquee_rate_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(marquee_box), marquee_spin, FALSE, FALSE, 0);
+
     // --- Метка статуса ---
     status_label = gtk_label_new("Ожидание инициализации LCD...");
     gtk_box_pack_start(GTK_BOX(vbox), status_label, FALSE, FALSE, 0);
 
     // Инициализация LCD1602.
-    // Используем "/dev/i2c-1" для I2C-шины на Raspberry Pi и адрес 0x27 для PCF8574.
-    if (lcd1602_init("/dev/i2c-1", 0x27) != 0) {
-        // Если инициализация LCD не удалась, выводим сообщение об ошибке
-        g_printerr("Ошибка инициализации LCD. Убедитесь, что I2C включен и адрес 0x27 корректен.\n");
+    // Используем "/dev/i2c-1" для I2C-шины на Raspberry Pi; все дисплеи
+    // открываются на ней и разделяют один файловый дескриптор.
+    int num_addrs = argc > 1 ? argc - 1 : 1;
+    if (num_addrs > MAX_DISPLAYS) {
+        g_printerr("Слишком много дисплеев (не больше %d).\n", MAX_DISPLAYS);
+        return 1;
+    }
+    for (int i = 0; i < num_addrs; i++) {
+        char *end;
+        unsigned long addr = argc > 1 ? strtoul(argv[i + 1], &end, 0) : 0x27;
+        if (argc > 1 && (*end || addr < 0x03 || addr > 0x77)) {
+            g_printerr("Неверный адрес I2C: %s\n", argv[i + 1]);
+            return 1;
+        }
+
+        lcd1602_t *lcd = lcd1602_open("/dev/i2c-1", addr);
+        if (!lcd) {
+            // Если инициализация LCD не удалась, выводим сообщение об ошибке,
+            // но GUI все равно показываем
+            g_printerr("Ошибка инициализации LCD. Убедитесь, что I2C включен и адрес 0x%02lX корректен.\n",
+                       addr);
+            continue;
+        }
+        // Запускаем поток записи: дальше обработчики кнопок только передают ему кадры
+        // Без него все кадры дисплею отвергаются: закрываем его, и метка
+        // статуса сообщит об ошибке
+        if (lcd1602_async_start(lcd, on_lcd_done, NULL) != 0) {
+            g_printerr("Не удалось запустить поток записи LCD 0x%02lX.\n", addr);
+            lcd1602_close(lcd);
+            continue;
+        }
+        displays[num_displays++] = lcd;
+    }
+
+    if (num_displays < num_addrs) {
         gtk_label_set_text(GTK_LABEL(status_label), "Ошибка инициализации LCD!");
-        // Не возвращаем 1 сразу, чтобы GUI все равно показался, но с ошибкой.
-        // return 1;
     } else {
         gtk_label_set_text(GTK_LABEL(status_label), "LCD успешно инициализирован.");
     }
@@ -133,7 +338,13 @@ int main(int argc, char *argv[]) {
     // до тех пор, пока не будет вызвана gtk_main_quit (например, при закрытии окна).
     gtk_main();
 
-    // После завершения главного цикла GTK, закрываем I2C-соединение с LCD.
-    lcd1602_close();
+    // Выводим гистограмму задержек после команд для сравнения режимов ожидания
+    for (int i = 0; i < num_displays; i++)
+        lcd1602_print_latency(displays[i], stdout);
+
+    // После завершения главного цикла GTK, останавливаем поток записи
+    // и закрываем I2C-соединение с LCD.
+    for (int i = 0; i < num_displays; i++)
+        lcd1602_close(displays[i]);
     return 0; // Успешное завершение программы
 }